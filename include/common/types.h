@@ -1,6 +1,11 @@
 #pragma once
 
+#include <cmath>
+#include <cerrno>
 #include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
 #include <functional>
 #include <optional>
 #include <string>
@@ -38,17 +43,111 @@ struct Record {
         : values(std::move(vals)) {}
 };
 
+// Index keys are compared bytewise, so numeric columns are stored as a tag
+// byte followed by an 8-byte big-endian image that sorts like the number:
+// integers with the sign bit flipped, doubles with the sign bit flipped
+// (positive) or all bits flipped (negative). NULL sorts before every number
+// and text that does not parse as the column type sorts after them.
+constexpr std::size_t kNumericIndexKeyBytes = 9;
+constexpr char kIndexKeyNullTag = 0x00;
+constexpr char kIndexKeyNumberTag = 0x01;
+constexpr char kIndexKeyTextTag = 0x02;
+
+inline std::size_t indexKeyLength(ColumnType type, std::size_t columnLength) {
+    return type == ColumnType::String ? columnLength : kNumericIndexKeyBytes;
+}
+
+namespace detail {
+
+inline std::string orderedNumberKey(std::uint64_t bits) {
+    std::string key(1, kIndexKeyNumberTag);
+    for (int shift = 56; shift >= 0; shift -= 8) {
+        key.push_back(static_cast<char>((bits >> shift) & 0xFFu));
+    }
+    return key;
+}
+
+inline std::optional<double> parseIndexDouble(const std::string &value) {
+    if (value.empty()) {
+        return std::nullopt;
+    }
+    errno = 0;
+    char *end = nullptr;
+    const double parsed = std::strtod(value.c_str(), &end);
+    if (errno == ERANGE || end != value.c_str() + value.size()) {
+        return std::nullopt;
+    }
+    return parsed;
+}
+
+inline std::optional<std::int64_t> parseIndexInteger(const std::string &value) {
+    if (value.empty()) {
+        return std::nullopt;
+    }
+    errno = 0;
+    char *end = nullptr;
+    const long long parsed = std::strtoll(value.c_str(), &end, 10);
+    if (errno == 0 && end == value.c_str() + value.size()) {
+        return static_cast<std::int64_t>(parsed);
+    }
+    // "2.0" compares equal to 2, so integral doubles share its key.
+    auto asDouble = parseIndexDouble(value);
+    if (asDouble && std::trunc(*asDouble) == *asDouble &&
+        *asDouble >= -9223372036854775808.0 && *asDouble < 9223372036854775808.0) {
+        return static_cast<std::int64_t>(*asDouble);
+    }
+    return std::nullopt;
+}
+
+} // namespace detail
+
+inline std::string encodeIndexKey(const std::string &value,
+                                  ColumnType type,
+                                  std::size_t keyLength) {
+    if (type == ColumnType::String) {
+        return value.size() > keyLength ? value.substr(0, keyLength) : value;
+    }
+    if (value == "NULL") {
+        return std::string(1, kIndexKeyNullTag);
+    }
+    if (type == ColumnType::Integer) {
+        if (auto parsed = detail::parseIndexInteger(value)) {
+            return detail::orderedNumberKey(static_cast<std::uint64_t>(*parsed) ^ (1ULL << 63));
+        }
+    } else if (auto parsed = detail::parseIndexDouble(value)) {
+        double number = *parsed == 0.0 ? 0.0 : *parsed;
+        std::uint64_t bits = 0;
+        std::memcpy(&bits, &number, sizeof(bits));
+        bits = (bits >> 63) ? ~bits : (bits ^ (1ULL << 63));
+        return detail::orderedNumberKey(bits);
+    }
+    std::string key(1, kIndexKeyTextTag);
+    key += value.substr(0, keyLength > 1 ? keyLength - 1 : 0);
+    return key;
+}
+
 inline std::string sliceIndexKey(const Record &record,
                                  std::size_t columnIndex,
-                                 std::size_t keyLength) {
+                                 std::size_t keyLength,
+                                 ColumnType type = ColumnType::String) {
     if (columnIndex >= record.values.size()) {
         return {};
     }
-    std::string key = record.values[columnIndex];
-    if (key.size() > keyLength) {
-        key.resize(keyLength);
+    return encodeIndexKey(record.values[columnIndex], type, keyLength);
+}
+
+// Smallest key greater than every key starting with `prefix`; none when the
+// prefix is empty or all 0xFF bytes.
+inline std::optional<std::string> indexKeySuccessor(std::string prefix) {
+    while (!prefix.empty()) {
+        unsigned char last = static_cast<unsigned char>(prefix.back());
+        if (last < 0xFF) {
+            prefix.back() = static_cast<char>(last + 1);
+            return prefix;
+        }
+        prefix.pop_back();
     }
-    return key;
+    return std::nullopt;
 }
 
 struct BlockAddress {
@@ -75,6 +174,10 @@ struct BlockAddressHash {
 struct IndexPointer {
     BlockAddress address;
     std::size_t slot{0};
+
+    bool operator==(const IndexPointer &other) const {
+        return slot == other.slot && address == other.address;
+    }
 };
 
 } // namespace dbms
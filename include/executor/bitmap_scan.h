@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "executor/operator.h"
+#include "system/database.h"
+
+namespace dbms {
+
+// One `column = value` predicate answered by a bitmap index
+struct BitmapTerm {
+    std::string index;
+    std::string value;
+};
+
+// Conjunction of disjunctions: a row qualifies when every conjunct has a
+// term whose bitmap holds it
+using BitmapPredicate = std::vector<std::vector<BitmapTerm>>;
+
+// Bitmap scan operator: ORs the bitmaps within each conjunct, ANDs the
+// conjuncts, then reads only the blocks left in the result, each once, and
+// returns the rows at the selected slots in block order
+class BitmapScanOperator : public Operator {
+public:
+    BitmapScanOperator(DatabaseSystem& db, std::string table, BitmapPredicate predicate);
+
+    void init() override;
+    std::optional<Tuple> next() override;
+    void close() override;
+    const Schema& getSchema() const override { return schema_; }
+    void reset() override;
+
+    // Where the row last returned by next() is stored.
+    const IndexPointer& position() const { return position_; }
+
+    // Blocks the combined bitmap selects; valid after init().
+    std::size_t selectedBlocks() const { return targets_.size(); }
+
+private:
+    DatabaseSystem& db_;
+    std::string tableName_;
+    BitmapPredicate predicate_;
+    Schema schema_;
+    bool initialized_{false};
+    IndexPointer position_;
+
+    std::vector<std::pair<std::size_t, std::vector<std::uint16_t>>> targets_;
+    std::size_t nextTarget_{0};
+    std::vector<std::pair<std::size_t, Record>> currentRows_;  // slot, record
+    std::size_t currentRow_{0};
+    std::size_t currentBlock_{0};
+
+    RowBitmap evaluate() const;
+    void fetchNextBlock();
+    Schema buildSchemaFromTable(const Table& table);
+};
+
+} // namespace dbms
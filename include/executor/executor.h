@@ -1,6 +1,8 @@
 #pragma once
 
 #include <memory>
+#include <string>
+#include <vector>
 
 #include "executor/operator.h"
 #include "executor/result_set.h"
@@ -12,6 +14,12 @@ namespace dbms {
 // Forward declarations
 class Expression;
 
+// A stored row and the block slot it lives in
+struct LocatedRow {
+    IndexPointer location;
+    Record record;
+};
+
 // Query executor - translates PhysicalPlanNode to Operator tree and executes it
 class QueryExecutor {
 public:
@@ -20,6 +28,12 @@ public:
     // Execute physical plan and return results
     ResultSet execute(std::shared_ptr<PhysicalPlanNode> plan);
 
+    // Rows of `table` satisfying `condition` (every row when it is empty),
+    // reached through the access path the planner picks for the same
+    // SELECT: an index scan when the condition allows one, else a scan of
+    // every block. UPDATE and DELETE collect their targets this way.
+    std::vector<LocatedRow> locateRows(const std::string& table, const std::string& condition);
+
 private:
     DatabaseSystem& db_;
 
@@ -29,6 +43,7 @@ private:
     // Build specific operators
     std::unique_ptr<Operator> buildTableScan(std::shared_ptr<PhysicalPlanNode> planNode);
     std::unique_ptr<Operator> buildIndexScan(std::shared_ptr<PhysicalPlanNode> planNode);
+    std::unique_ptr<Operator> buildBitmapScan(std::shared_ptr<PhysicalPlanNode> planNode);
     std::unique_ptr<Operator> buildFilter(
         std::shared_ptr<PhysicalPlanNode> planNode,
         std::unique_ptr<Operator> child);
@@ -40,6 +55,7 @@ private:
         std::unique_ptr<Operator> child);
     std::unique_ptr<Operator> buildNestedLoopJoin(std::shared_ptr<PhysicalPlanNode> planNode);
     std::unique_ptr<Operator> buildHashJoin(std::shared_ptr<PhysicalPlanNode> planNode);
+    std::unique_ptr<Operator> buildIndexNestedLoopJoin(std::shared_ptr<PhysicalPlanNode> planNode);
     std::unique_ptr<Operator> buildSort(
         std::shared_ptr<PhysicalPlanNode> planNode,
         std::unique_ptr<Operator> child);
@@ -95,6 +95,27 @@ private:
     std::unique_ptr<Expression> right_;
 };
 
+// Pattern match: '%' matches any run of characters, '_' exactly one
+class LikeExpr : public Expression {
+public:
+    LikeExpr(std::unique_ptr<Expression> value, std::unique_ptr<Expression> pattern)
+        : value_(std::move(value)), pattern_(std::move(pattern)) {}
+
+    ExprValue evaluate(const Tuple& tuple) const override;
+    ExprValue::Type getType() const override { return ExprValue::Type::BOOLEAN; }
+    const Expression* value() const { return value_.get(); }
+    const Expression* pattern() const { return pattern_.get(); }
+
+    static bool matches(const std::string& text, const std::string& pattern);
+    // Literal characters before the first wildcard; a pattern whose only
+    // wildcard is a trailing run of '%' is fully described by this prefix.
+    static std::string literalPrefix(const std::string& pattern);
+
+private:
+    std::unique_ptr<Expression> value_;
+    std::unique_ptr<Expression> pattern_;
+};
+
 // Logical expression (AND, OR, NOT)
 class LogicalExpr : public Expression {
 public:
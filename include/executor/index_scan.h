@@ -1,14 +1,31 @@
 #pragma once
 
+#include <cstddef>
+#include <deque>
 #include <optional>
 #include <string>
+#include <vector>
 
 #include "executor/operator.h"
 #include "system/database.h"
 
 namespace dbms {
 
-// Index scan operator: performs equality lookup via a B+ tree index
+// Key interval for a range scan; an absent bound is open. On a composite
+// index `prefix` holds values for the leading key columns and the bounds
+// apply to the column after them
+struct IndexScanRange {
+    std::vector<std::string> prefix;
+    std::optional<std::string> lower;
+    bool lowerInclusive{true};
+    std::optional<std::string> upper;
+    bool upperInclusive{true};
+};
+
+// Index scan operator: walks the B+ tree leaf chain in key order between a
+// start and a stop key and returns every row stored under the keys in
+// between; an equality lookup is the range [key, key]. On a hash index only
+// equality lookups are possible and probe a single bucket
 class IndexScanOperator : public Operator {
 public:
     IndexScanOperator(DatabaseSystem& db,
@@ -16,22 +33,58 @@ public:
                       std::string index,
                       std::string key);
 
+    IndexScanOperator(DatabaseSystem& db,
+                      std::string table,
+                      std::string index,
+                      IndexScanRange range);
+
     void init() override;
     std::optional<Tuple> next() override;
     void close() override;
     const Schema& getSchema() const override { return schema_; }
     void reset() override;
 
+    // Where the row last returned by next() is stored.
+    const IndexPointer& position() const { return position_; }
+
+    // Restarts an initialized scan as an equality lookup of `key`, keeping
+    // its schema; an index nested loop join probes once per outer row.
+    void rebind(const std::string& key);
+
+    // Answers from the values a covering index stores with each key instead
+    // of reading the rows; tuples then hold only the covered columns. Set
+    // before init().
+    void setIndexOnly(bool indexOnly) { indexOnly_ = indexOnly; }
+
 private:
     DatabaseSystem& db_;
     std::string tableName_;
     std::string indexName_;
-    std::string searchKey_;
+    IndexScanRange range_;
+    bool boundsEncoded_{false};
+    bool emptyRange_{false};
     Schema schema_;
     bool initialized_{false};
     bool done_{false};
+    bool indexOnly_{false};
+    IndexPointer position_;
+
+    // Pointers are collected a batch at a time and the scan
+    // resumes after the last key seen, so no index page is held while the
+    // table blocks are read.
+    static constexpr std::size_t kBatchSize = 256;
+    std::deque<IndexPointer> pending_;
+    std::deque<std::string> pendingKeys_;  // stored keys, index-only scans
+    std::optional<std::string> resumeKey_;
+    std::optional<std::string> probeValue_;  // equality value, unordered indexes
+    bool nullProbed_{false};
+    bool exhausted_{false};
 
+    void encodeBounds();
+    void fillBatch();
+    void enqueue(const std::string& key, const IndexPointer& ptr);
     Schema buildSchemaFromTable(const Table& table);
+    Schema buildSchemaFromIndex(const IndexDefinition& definition);
 };
 
 } // namespace dbms
@@ -7,6 +7,7 @@
 #include <vector>
 
 #include "executor/expression.h"
+#include "executor/index_scan.h"
 #include "executor/operator.h"
 
 namespace dbms {
@@ -77,4 +78,40 @@ private:
     Tuple combineTuples(const Tuple& left, const Tuple& right) const;
 };
 
+// Index nested loop join (inner or left): each outer tuple rebinds the inner
+// index scan to its join column value, so only matching inner rows are read.
+// `inner` is the probe itself or an operator wrapping it, such as an alias.
+class IndexNestedLoopJoinOperator : public Operator {
+public:
+    IndexNestedLoopJoinOperator(std::unique_ptr<Operator> outer,
+                                std::unique_ptr<Operator> inner,
+                                IndexScanOperator& probe,
+                                std::string condition,
+                                std::string outerKey,
+                                JoinType joinType = JoinType::kInner);
+
+    void init() override;
+    std::optional<Tuple> next() override;
+    void close() override;
+    const Schema& getSchema() const override { return *outputSchema_; }
+    void reset() override;
+
+private:
+    std::unique_ptr<Operator> outer_;
+    std::unique_ptr<Operator> inner_;
+    IndexScanOperator& probe_;
+    std::string condition_;
+    std::unique_ptr<Expression> predicate_;
+    std::string outerKey_;
+    JoinType joinType_;
+    std::shared_ptr<Schema> outputSchema_;
+    bool initialized_{false};
+    std::optional<Tuple> currentOuter_;
+    bool probing_{false};
+    bool currentMatched_{false};
+
+    Tuple combineTuples(const Tuple& outer, const Tuple& inner) const;
+    Tuple padWithNulls(const Tuple& outer) const;
+};
+
 } // namespace dbms
@@ -40,6 +40,12 @@ private:
     // Current block data (copied from buffer pool)
     std::vector<Record> currentBlockRecords_;
 
+    // Private frames the blocks are read through; null for small tables
+    std::unique_ptr<ScanRing> ring_;
+
+    // Background reader for the blocks ahead; null for short tables
+    std::unique_ptr<BlockReadAhead> readAhead_;
+
     // Helper methods
     void fetchNextBlock();
     Schema buildSchemaFromTable(const Table& table);
@@ -1,25 +1,92 @@
 #pragma once
 
 #include <algorithm>
+#include <array>
 #include <cstddef>
 #include <cstdint>
+#include <cstdio>
 #include <limits>
 #include <fstream>
 #include <functional>
+#include <memory>
+#include <mutex>
 #include <optional>
 #include <queue>
+#include <shared_mutex>
 #include <sstream>
 #include <stdexcept>
 #include <string>
 #include <unordered_map>
+#include <unordered_set>
 #include <utility>
 #include <vector>
 
 #include "common/types.h"
 #include "common/utils.h"
+#include "index/node_keys.h"
 
 namespace dbms {
 
+// Fixed-size page storage for B+ tree nodes. When a tree is attached to a
+// store, node ids are page ids and only the nodes touched by the current
+// operation are kept decoded in memory.
+class IndexPageStore {
+public:
+    virtual ~IndexPageStore() = default;
+
+    // Largest encoded node that fits into a single page.
+    virtual std::size_t pageCapacity() const = 0;
+    // Every page the store currently owns, live or not.
+    virtual std::vector<std::size_t> pageIds() const = 0;
+    virtual std::size_t allocatePage() = 0;
+    virtual std::string readPage(std::size_t pageId) = 0;
+    virtual void writePage(std::size_t pageId, const std::string &payload) = 0;
+};
+
+// Pages of an index that has no IndexPageStore, kept in memory and saved
+// with the index's meta file.
+class LocalPageStore : public IndexPageStore {
+public:
+    explicit LocalPageStore(std::size_t capacity)
+        : capacity_(capacity) {}
+
+    std::size_t pageCapacity() const override {
+        return capacity_;
+    }
+
+    std::vector<std::size_t> pageIds() const override {
+        std::vector<std::size_t> ids;
+        for (std::size_t i = 0; i < pages_.size(); ++i) {
+            ids.push_back(i);
+        }
+        return ids;
+    }
+
+    std::size_t allocatePage() override {
+        pages_.emplace_back();
+        return pages_.size() - 1;
+    }
+
+    std::string readPage(std::size_t pageId) override {
+        return pages_.at(pageId);
+    }
+
+    void writePage(std::size_t pageId, const std::string &payload) override {
+        pages_.at(pageId) = payload;
+    }
+
+    void restore(std::size_t pageId, std::string payload) {
+        if (pageId >= pages_.size()) {
+            pages_.resize(pageId + 1);
+        }
+        pages_[pageId] = std::move(payload);
+    }
+
+private:
+    std::size_t capacity_;
+    std::vector<std::string> pages_;
+};
+
 class BPlusTree {
 public:
     BPlusTree() = default;
@@ -35,10 +102,50 @@ public:
         if (maxKeys_ < 3) {
             maxKeys_ = 3;
         }
+        if (store_) {
+            const std::size_t fitting = computePagedMaxKeys(store_->pageCapacity(), keyBytes);
+            if (fitting < 3) {
+                std::ostringstream oss;
+                oss << "index page of " << store_->pageCapacity()
+                    << " bytes cannot hold three keys of " << keyBytes << " bytes";
+                throw std::runtime_error(oss.str());
+            }
+            maxKeys_ = std::min(maxKeys_, fitting);
+        }
+        pageBudget_ = store_ ? store_->pageCapacity() : pageSize_;
+        if (duplicates_) {
+            configurePostings(keyBytes);
+        }
         minKeys_ = std::max<std::size_t>(1, maxKeys_ / 2);
         clearNodes();
     }
 
+    // Lets a key map to many pointers. Each leaf entry then holds a posting
+    // list: a few pointers inline, the rest on a chain of overflow pages, so
+    // one heavy key never has to fit into its leaf. Resets the tree.
+    void setAllowDuplicates(bool allow) {
+        duplicates_ = allow;
+        if (maxKeys_ != 0) {
+            initialize(pageSize_, keyLength_);
+        }
+    }
+
+    bool allowsDuplicates() const {
+        return duplicates_;
+    }
+
+    // Moves the tree onto fixed-size pages. Leaf pointers are stored without
+    // their table name, which is restored from pointerTable on decode.
+    void attachPageStore(IndexPageStore *store, std::string pointerTable) {
+        store_ = store;
+        pointerTable_ = std::move(pointerTable);
+        initialize(pageSize_, keyLength_);
+    }
+
+    bool paged() const {
+        return store_ != nullptr;
+    }
+
     std::size_t entriesPerPage() const {
         return maxKeys_;
     }
@@ -47,104 +154,251 @@ public:
         return pageSize_;
     }
 
+    std::size_t pageCount() const {
+        const auto structure = writeStructure();
+        return nodeCount();
+    }
+
+    // Lets several threads use the tree at once. This is plain latching,
+    // not optimistic lock coupling: readers still take latches. Lookups,
+    // scans and changes that stay inside one leaf run side by side under a
+    // shared structure latch and latch only that leaf. An insert that would
+    // split its leaf, an erase that would leave it underfull and anything
+    // that touches overflow pages restarts holding the structure latch
+    // exclusively, as do bulk loads, persistence and every operation of a
+    // paged tree, whose node cache and page store are not shared. Nothing in
+    // DatabaseSystem enables it. Configure the tree before enabling this;
+    // scan callbacks must not call back into the tree.
+    void setConcurrentAccess(bool enabled) {
+        latches_ = enabled ? std::make_unique<Latches>() : nullptr;
+    }
+
+    bool concurrentAccess() const {
+        return latches_ != nullptr;
+    }
+
+    // Share of each page bulkInsert fills; the rest is headroom for later
+    // inserts. Clamped to [0.5, 1.0] so built nodes never start underfull.
+    void setBulkLoadFillFactor(double fillFactor) {
+        bulkFillFactor_ = std::min(1.0, std::max(0.5, fillFactor));
+    }
+
+    double bulkLoadFillFactor() const {
+        return bulkFillFactor_;
+    }
+
     void clearNodes() {
         nodes_.clear();
         rootId_ = kInvalidNode;
         nextNodeId_ = 1;
+        nodeCount_ = 0;
+        dirtyNodes_.clear();
+        freedNodes_.clear();
+        freePages_.clear();
+        if (store_) {
+            freePages_ = store_->pageIds();
+            std::sort(freePages_.rbegin(), freePages_.rend());
+        }
+        snapshotRequired_ = true;
+    }
+
+    bool hasPendingChanges() const {
+        const auto structure = writeStructure();
+        return pendingChanges();
     }
 
+    // Replaces the tree with the given entries, built bottom-up: leaves are
+    // packed left to right, then each internal level is built over the one
+    // below. Input that is already sorted is not copied. For duplicate keys
+    // the last entry wins, as with repeated inserts, unless the tree allows
+    // duplicates; then every entry lands in its key's posting list.
     void bulkInsert(const     std::vector<std::pair<std::string, IndexPointer>> &entries) {
+            const auto structure = writeStructure();
             clearNodes();
             if (entries.empty()) {
                 return;
             }
-            ensureRoot();
+            if (maxKeys_ == 0) {
+                throw std::logic_error("B+ tree must be initialized before use");
+            }
+            const auto byKey = [](const auto &lhs, const auto &rhs) {
+                return lhs.first < rhs.first;
+            };
+            const auto sameKey = [](const auto &lhs, const auto &rhs) {
+                return lhs.first == rhs.first;
+            };
+            if (duplicates_) {
+                if (std::is_sorted(entries.begin(), entries.end(), byKey)) {
+                    buildPostingsFromSorted(entries);
+                    return;
+                }
+                std::vector<std::pair<std::string, IndexPointer>> sorted(entries);
+                std::stable_sort(sorted.begin(), sorted.end(), byKey);
+                buildPostingsFromSorted(sorted);
+                return;
+            }
+            if (std::is_sorted(entries.begin(), entries.end(), byKey) &&
+                std::adjacent_find(entries.begin(), entries.end(), sameKey) == entries.end()) {
+                buildFromSorted(entries);
+                return;
+            }
             std::vector<std::pair<std::string, IndexPointer>> sorted(entries);
-            std::sort(sorted.begin(), sorted.end(),
-                      [](const auto &lhs, const auto &rhs) {
-                          return lhs.first < rhs.first;
-                      });
-            for (const auto &entry : sorted) {
-                insertUnique(entry.first, entry.second);
+            std::stable_sort(sorted.begin(), sorted.end(), byKey);
+            std::vector<std::pair<std::string, IndexPointer>> distinct;
+            distinct.reserve(sorted.size());
+            for (auto &entry : sorted) {
+                if (!distinct.empty() && distinct.back().first == entry.first) {
+                    distinct.back() = std::move(entry);
+                } else {
+                    distinct.push_back(std::move(entry));
+                }
             }
+            sorted.clear();
+            buildFromSorted(distinct);
         }
 
         void insertUnique(const std::string &key, const IndexPointer &ptr) {
-            ensureRoot();
-            auto split = insertRecursive(rootId_, key, ptr, false);
-            if (split.has_value()) {
-                promoteToNewRoot(*split);
-            }
+            insertEntry(key, ptr, false);
         }
 
         void insertOrAssign(const std::string &key, const IndexPointer &ptr) {
-            ensureRoot();
-            auto split = insertRecursive(rootId_, key, ptr, false);
-            if (split.has_value()) {
-                promoteToNewRoot(*split);
-            }
+            insertEntry(key, ptr, false);
+        }
+
+        // Adds `ptr` to the posting list of `key`. Without duplicates this
+        // is insertOrAssign.
+        void insert(const std::string &key, const IndexPointer &ptr) {
+            insertEntry(key, ptr, duplicates_);
         }
 
         bool update(const std::string &key, const IndexPointer &ptr) {
+            if (leafLatching()) {
+                std::shared_lock<std::shared_mutex> structure(latches_->structure);
+                const auto change = updateInLeaf(key, ptr);
+                if (change != LeafChange::NeedsStructure) {
+                    return change == LeafChange::Applied;
+                }
+            }
+            const auto structure = writeStructure();
             if (rootId_ == kInvalidNode) {
                 return false;
             }
             const std::size_t leafId = locateLeaf(rootId_, key);
-            auto &leaf = nodes_.at(leafId);
-            auto it = std::lower_bound(leaf.keys.begin(), leaf.keys.end(), key);
-            if (it == leaf.keys.end() || *it != key) {
+            auto &leaf = fetchNode(leafId);
+            const std::size_t idx = leaf.keys.lowerBound(key);
+            if (!leaf.keys.matches(idx, key)) {
+                trimCache();
                 return false;
             }
-            const std::size_t idx = static_cast<std::size_t>(std::distance(leaf.keys.begin(), it));
-            leaf.values[idx] = ptr;
+            releaseOverflow(leaf.values[idx]);
+            leaf.values[idx] = Posting{ptr};
+            markDirty(leafId);
+            syncPages();
             return true;
         }
 
+        // Removes `key` together with its whole posting list.
         bool erase(const std::string &key) {
+            return eraseEntry(key, nullptr);
+        }
+
+        // Removes a single pointer from the posting list of `key`; the key
+        // goes away with its last pointer.
+        bool erase(const std::string &key, const IndexPointer &ptr) {
+            return eraseEntry(key, &ptr);
+        }
+
+        std::optional<IndexPointer> find(const std::string &key) const {
+            const auto structure = readStructure();
             if (rootId_ == kInvalidNode) {
-                return false;
+                return std::nullopt;
             }
-            const auto state = eraseRecursive(rootId_, key, kInvalidNode, 0);
-            if (state == DeleteState::NotFound) {
-                return false;
+            const std::size_t leafId = locateLeaf(rootId_, key);
+            const auto latch = readLeaf(leafId);
+            const auto &leaf = fetchNode(leafId);
+            const std::size_t idx = leaf.keys.lowerBound(key);
+            std::optional<IndexPointer> result;
+            if (leaf.keys.matches(idx, key)) {
+                result = leaf.values[idx].head;
             }
-            if (rootId_ != kInvalidNode) {
-                auto rootIt = nodes_.find(rootId_);
-                if (rootIt != nodes_.end()) {
-                    auto &root = rootIt->second;
-                    if (!root.leaf && root.keys.empty() && root.children.size() == 1) {
-                        const std::size_t oldRoot = rootId_;
-                        rootId_ = root.children.front();
-                        nodes_.erase(oldRoot);
-                    } else if (root.leaf && root.keys.empty()) {
+            trimCache();
+            return result;
+        }
 
-                    }
-                }
+        std::vector<IndexPointer> findAll(const std::string &key) const {
+            std::vector<IndexPointer> result;
+            const auto structure = readStructure();
+            if (rootId_ == kInvalidNode) {
+                return result;
             }
-            return true;
+            const std::size_t leafId = locateLeaf(rootId_, key);
+            const auto latch = readLeaf(leafId);
+            const auto &leaf = fetchNode(leafId);
+            const std::size_t idx = leaf.keys.lowerBound(key);
+            if (leaf.keys.matches(idx, key)) {
+                visitPosting(leaf.values[idx], [&](const IndexPointer &ptr) {
+                    result.push_back(ptr);
+                    return true;
+                });
+            }
+            trimCache();
+            return result;
         }
 
-        std::optional<IndexPointer> find(const std::string &key) const {
+        // Visits entries in key order starting at `lower` (or the first key
+        // when absent) by following the leaf chain, until `visit` returns
+        // false or the last leaf is exhausted. A key with several pointers
+        // is visited once per pointer.
+        void scan(const std::optional<std::string> &lower,
+                  bool lowerInclusive,
+                  const std::function<bool(const std::string &, const IndexPointer &)> &visit) const {
+            const auto structure = readStructure();
             if (rootId_ == kInvalidNode) {
-                return std::nullopt;
+                return;
             }
-            const std::size_t leafId = locateLeaf(rootId_, key);
-            const auto &leaf = nodes_.at(leafId);
-            auto it = std::lower_bound(leaf.keys.begin(), leaf.keys.end(), key);
-            if (it == leaf.keys.end() || *it != key) {
-                return std::nullopt;
+            std::size_t leafId = lower.has_value() ? locateLeaf(rootId_, *lower)
+                                                   : leftmostLeaf(rootId_);
+            bool first = true;
+            while (true) {
+                // One leaf latch at a time: the chain cannot change while
+                // the structure latch is shared.
+                const auto latch = readLeaf(leafId);
+                const auto &leaf = fetchNode(leafId);
+                std::size_t idx = 0;
+                if (first && lower.has_value()) {
+                    idx = lowerInclusive ? leaf.keys.lowerBound(*lower) : leaf.keys.upperBound(*lower);
+                }
+                first = false;
+                for (; idx < leaf.keys.size(); ++idx) {
+                    const auto &key = leaf.keys[idx];
+                    const bool more = visitPosting(leaf.values[idx], [&](const IndexPointer &ptr) {
+                        return visit(key, ptr);
+                    });
+                    if (!more) {
+                        trimCache();
+                        return;
+                    }
+                }
+                if (!leaf.hasNext) {
+                    break;
+                }
+                const std::size_t nextId = leaf.nextLeaf;
+                if (store_) {
+                    nodes_.erase(leafId);
+                }
+                leafId = nextId;
             }
-            const std::size_t idx = static_cast<std::size_t>(std::distance(leaf.keys.begin(), it));
-            return leaf.values[idx];
+            trimCache();
         }
 
     std::vector<std::string> describePages() const {
+        const auto structure = writeStructure();
         std::vector<std::string> lines;
         std::ostringstream header;
-        header << "Index file: " << nodes_.size() << " page(s), max "
+        header << "Index file: " << nodeCount() << " page(s), max "
                << maxKeys_ << " entry/entries per page.";
         lines.push_back(header.str());
-        if (rootId_ == kInvalidNode || nodes_.empty()) {
+        if (rootId_ == kInvalidNode || nodeCount() == 0) {
             lines.push_back("  [empty tree]");
             return lines;
         }
@@ -153,11 +407,10 @@ public:
         while (!bfs.empty()) {
             auto [nodeId, level] = bfs.front();
             bfs.pop();
-            const auto nodeIt = nodes_.find(nodeId);
-            if (nodeIt == nodes_.end()) {
+            if (!store_ && nodes_.find(nodeId) == nodes_.end()) {
                 continue;
             }
-            const auto &node = nodeIt->second;
+            const auto &node = fetchNode(nodeId);
             std::ostringstream meta;
             meta << "  Page #" << node.id << " (level " << level << ", "
                  << (node.leaf ? "leaf" : "internal");
@@ -189,7 +442,7 @@ public:
                         if (i != 0) {
                             ptrLine << " | ";
                         }
-                        ptrLine << pointerToString(node.values[i]);
+                        ptrLine << describePosting(node.values[i]);
                     }
                 }
                 lines.push_back(ptrLine.str());
@@ -211,54 +464,155 @@ public:
                 lines.push_back(childLine.str());
             }
         }
+        trimCache();
         return lines;
     }
 
+    // Writes a full snapshot of the tree and discards the delta log that
+    // belonged to the previous snapshot.
     void saveToFile(const std::string &path) const {
+        const auto structure = writeStructure();
+        writeSnapshot(path);
+    }
+
+    // Persists only the nodes touched since the last call by appending them to
+    // the delta log next to the snapshot. Once the log has absorbed about as
+    // many node images as the tree holds, it is folded into a fresh snapshot,
+    // so the amortized cost per change stays proportional to the nodes it
+    // touched rather than to the size of the tree.
+    //
+    // A paged tree has already written its nodes through the page store, so
+    // here it only marks the meta file dirty until the next checkpoint.
+    void persistChanges(const std::string &path) {
+        const auto structure = writeStructure();
+        persistDirtyNodes(path);
+    }
+
+    // Records that every page of a paged tree has reached disk. Callers flush
+    // the buffer pool first; a meta file left dirty forces a rebuild on load.
+    void checkpoint(const std::string &path) {
+        const auto structure = writeStructure();
+        if (!store_) {
+            persistDirtyNodes(path);
+            return;
+        }
+        writePagedMeta(path, true);
+        metaClean_ = true;
+        pagesDirty_ = false;
+        snapshotRequired_ = false;
+    }
+
+    void loadFromFile(const std::string &path,
+                      std::size_t expectedPageSize,
+                      std::size_t expectedKeyLength) {
+        const auto structure = writeStructure();
+        readSnapshot(path, expectedPageSize, expectedKeyLength);
+    }
+
+    static std::string deltaLogPath(const std::string &path) {
+        return path + ".log";
+    }
+
+private:
+    void writeSnapshot(const std::string &path) const {
         pathutil::ensureParentDirectory(path);
-        std::ofstream out(path, std::ios::binary);
+        const std::string tempPath = path + ".tmp";
+        {
+            std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+            if (!out) {
+                std::ostringstream oss;
+                oss << "failed to persist index file: " << path;
+                throw std::runtime_error(oss.str());
+            }
+            out << (duplicates_ ? "IDXTREE V4\n" : "IDXTREE V2\n");
+            out << "PAGE_SIZE " << pageSize_ << "\n";
+            out << "KEY_LENGTH " << keyLength_ << "\n";
+            out << "GENERATION " << generation_ << "\n";
+            out << "ROOT " << serializeNodeId(rootId_) << "\n";
+            out << "NEXT " << nextNodeId_ << "\n";
+            const auto nodeOrder = collectNodeIds();
+            out << "NODE_COUNT " << nodeOrder.size() << "\n";
+            for (auto nodeId : nodeOrder) {
+                writeNode(out, fetchNode(nodeId));
+            }
+            trimCache();
+            if (!out) {
+                std::ostringstream oss;
+                oss << "failed to persist index file: " << path;
+                throw std::runtime_error(oss.str());
+            }
+        }
+        replaceFile(tempPath, path);
+        std::remove(deltaLogPath(path).c_str());
+    }
+
+    void persistDirtyNodes(const std::string &path) {
+        if (store_) {
+            if (metaClean_ && pendingChanges()) {
+                writePagedMeta(path, false);
+                metaClean_ = false;
+            }
+            return;
+        }
+        if (snapshotRequired_ || !pathutil::fileExists(path) ||
+            loggedNodeWrites_ + dirtyNodes_.size() + freedNodes_.size() >
+                compactionThreshold()) {
+            ++generation_;
+            writeSnapshot(path);
+            dirtyNodes_.clear();
+            freedNodes_.clear();
+            loggedNodeWrites_ = 0;
+            logCurrent_ = false;
+            snapshotRequired_ = false;
+            return;
+        }
+        if (dirtyNodes_.empty() && freedNodes_.empty()) {
+            return;
+        }
+        const std::string logPath = deltaLogPath(path);
+        if (logCurrent_ && !pathutil::fileExists(logPath)) {
+            logCurrent_ = false;
+        }
+        std::ofstream out(logPath, logCurrent_ ? (std::ios::binary | std::ios::app)
+                                               : (std::ios::binary | std::ios::trunc));
         if (!out) {
             std::ostringstream oss;
-            oss << "failed to persist index file: " << path;
+            oss << "failed to append index delta log: " << logPath;
             throw std::runtime_error(oss.str());
         }
-        out << "IDXTREE V1\n";
-        out << "PAGE_SIZE " << pageSize_ << "\n";
-        out << "KEY_LENGTH " << keyLength_ << "\n";
-        out << "ROOT " << serializeNodeId(rootId_) << "\n";
-        out << "NEXT " << nextNodeId_ << "\n";
-        out << "NODE_COUNT " << nodes_.size() << "\n";
-        std::vector<std::size_t> nodeOrder;
-        nodeOrder.reserve(nodes_.size());
-        for (const auto &entry : nodes_) {
-            nodeOrder.push_back(entry.first);
-        }
-        std::sort(nodeOrder.begin(), nodeOrder.end());
-        for (auto nodeId : nodeOrder) {
-            const auto &node = nodes_.at(nodeId);
-            out << "NODE " << node.id << " " << (node.leaf ? 1 : 0) << " "
-                << (node.hasNext ? 1 : 0) << " "
-                << serializeNodeId(node.nextLeaf) << "\n";
-            out << "KEYS " << node.keys.size() << "\n";
-            for (const auto &key : node.keys) {
-                out << encodeHex(key) << "\n";
-            }
-            if (node.leaf) {
-                out << "VALUES " << node.values.size() << "\n";
-                for (const auto &value : node.values) {
-                    out << encodeHex(value.address.table) << " "
-                        << value.address.index << " " << value.slot << "\n";
-                }
-            } else {
-                out << "CHILDREN " << node.children.size() << "\n";
-                for (auto childId : node.children) {
-                    out << childId << "\n";
-                }
+        if (!logCurrent_) {
+            out << "IDXLOG V1 GENERATION " << generation_ << "\n";
+        }
+        std::vector<std::size_t> written;
+        written.reserve(dirtyNodes_.size());
+        for (auto nodeId : dirtyNodes_) {
+            if (nodes_.find(nodeId) != nodes_.end()) {
+                written.push_back(nodeId);
             }
         }
+        std::sort(written.begin(), written.end());
+        out << "BATCH ROOT " << serializeNodeId(rootId_) << " NEXT " << nextNodeId_
+            << " NODES " << written.size() << " FREED " << freedNodes_.size() << "\n";
+        for (auto nodeId : written) {
+            writeNode(out, fetchNode(nodeId));
+        }
+        for (auto nodeId : freedNodes_) {
+            out << "FREE " << nodeId << "\n";
+        }
+        out << "COMMIT\n";
+        out.flush();
+        if (!out) {
+            std::ostringstream oss;
+            oss << "failed to append index delta log: " << logPath;
+            throw std::runtime_error(oss.str());
+        }
+        logCurrent_ = true;
+        loggedNodeWrites_ += written.size() + freedNodes_.size();
+        dirtyNodes_.clear();
+        freedNodes_.clear();
     }
 
-    void loadFromFile(const std::string &path,
+    void readSnapshot(const std::string &path,
                       std::size_t expectedPageSize,
                       std::size_t expectedKeyLength) {
         std::ifstream in(path, std::ios::binary);
@@ -280,11 +634,21 @@ public:
             return line;
         };
         const std::string header = readLine("header");
-        if (header != "IDXTREE V1") {
+        // V4 and V5 are the snapshot and paged formats of trees that keep
+        // posting lists; V1 to V3 hold one pointer per key.
+        const bool postingFormat = header == "IDXTREE V4" || header == "IDXTREE V5";
+        const bool pagedFormat = header == "IDXTREE V3" || header == "IDXTREE V5";
+        if (header != "IDXTREE V1" && header != "IDXTREE V2" && !pagedFormat &&
+            !postingFormat) {
             std::ostringstream oss;
             oss << "unsupported index format in " << path;
             throw std::runtime_error(oss.str());
         }
+        if (postingFormat != duplicates_) {
+            std::ostringstream oss;
+            oss << "index file " << path << " does not match the index key mode";
+            throw std::runtime_error(oss.str());
+        }
         const auto pageSizeLine = readLine("page size");
         const auto filePageSize = parseHeaderValue(pageSizeLine, "PAGE_SIZE");
         if (filePageSize != expectedPageSize) {
@@ -299,6 +663,19 @@ public:
             oss << "index key length mismatch in " << path;
             throw std::runtime_error(oss.str());
         }
+        if (pagedFormat || store_) {
+            if (!pagedFormat || !store_) {
+                std::ostringstream oss;
+                oss << "index file " << path << " does not match the index storage mode";
+                throw std::runtime_error(oss.str());
+            }
+            loadPagedMeta(path, readLine, expectedPageSize, expectedKeyLength);
+            return;
+        }
+        std::size_t fileGeneration = 0;
+        if (header != "IDXTREE V1") {
+            fileGeneration = parseHeaderValue(readLine("generation"), "GENERATION");
+        }
         const auto rootLine = readLine("root");
         const auto rootValue = parseSignedHeaderValue(rootLine, "ROOT");
         const auto nextLine = readLine("next node id");
@@ -310,155 +687,314 @@ public:
         nextNodeId_ = nextValue;
         rootId_ = rootValue < 0 ? kInvalidNode : static_cast<std::size_t>(rootValue);
         for (std::size_t idx = 0; idx < nodeCount; ++idx) {
-            Node node;
-            const auto nodeDesc = readLine("node descriptor");
-            std::stringstream nodeStream(nodeDesc);
-            std::string tag;
-            int leafFlag{0};
-            int nextFlag{0};
-            long long nextLeafRaw{0};
-            nodeStream >> tag >> node.id >> leafFlag >> nextFlag >> nextLeafRaw;
-            if (tag != "NODE") {
-                throw std::runtime_error("corrupted index node descriptor");
-            }
-            node.leaf = leafFlag != 0;
-            node.hasNext = nextFlag != 0;
-            node.nextLeaf = nextLeafRaw < 0 ? kInvalidNode
-                                            : static_cast<std::size_t>(nextLeafRaw);
-            const auto keysHeader = readLine("keys header");
-            std::stringstream keyStream(keysHeader);
-            std::string keysTag;
-            std::size_t keyCount{0};
-            keyStream >> keysTag >> keyCount;
-            if (keysTag != "KEYS") {
-                throw std::runtime_error("corrupted index keys header");
-            }
-            node.keys.reserve(keyCount);
-            for (std::size_t k = 0; k < keyCount; ++k) {
-                node.keys.push_back(decodeHex(readLine("key entry")));
-            }
-            if (node.leaf) {
-                const auto valuesHeader = readLine("values header");
-                std::stringstream valueStream(valuesHeader);
-                std::string valuesTag;
-                std::size_t valueCount{0};
-                valueStream >> valuesTag >> valueCount;
-                if (valuesTag != "VALUES") {
-                    throw std::runtime_error("corrupted index values header");
-                }
-                node.values.reserve(valueCount);
-                for (std::size_t v = 0; v < valueCount; ++v) {
-                    const auto valueLine = readLine("value entry");
-                    std::stringstream vs(valueLine);
-                    std::string tableHex;
-                    std::size_t blockIdx{0};
-                    std::size_t slotIdx{0};
-                    if (!(vs >> tableHex >> blockIdx >> slotIdx)) {
-                        throw std::runtime_error("corrupted index pointer entry");
-                    }
-                    IndexPointer ptr;
-                    ptr.address.table = decodeHex(tableHex);
-                    ptr.address.index = blockIdx;
-                    ptr.slot = slotIdx;
-                    node.values.push_back(ptr);
-                }
-            } else {
-                const auto childrenHeader = readLine("children header");
-                std::stringstream childStream(childrenHeader);
-                std::string childTag;
-                std::size_t childCount{0};
-                childStream >> childTag >> childCount;
-                if (childTag != "CHILDREN") {
-                    throw std::runtime_error("corrupted child header");
-                }
-                node.children.reserve(childCount);
-                for (std::size_t c = 0; c < childCount; ++c) {
-                    const auto childLine = readLine("child entry");
-                    node.children.push_back(
-                        static_cast<std::size_t>(std::stoull(childLine)));
-                }
-            }
+            Node node = readNode(readLine);
             nodes_[node.id] = std::move(node);
         }
+        generation_ = fileGeneration;
+        snapshotRequired_ = false;
+        replayDeltaLog(deltaLogPath(path));
         if (nodes_.empty()) {
             rootId_ = kInvalidNode;
         }
     }
 
-private:
+    bool pendingChanges() const {
+        return snapshotRequired_ || pagesDirty_ || !dirtyNodes_.empty() ||
+               !freedNodes_.empty();
+    }
+
+        static constexpr std::size_t kInvalidNode = std::numeric_limits<std::size_t>::max();
+
+        // Pointers stored under one leaf key. A unique tree only uses `head`;
+        // with duplicates up to inlineLimit_ pointers stay in the leaf and
+        // the rest live on a chain of overflow pages starting at `overflow`.
+        struct Posting {
+            IndexPointer head;
+            std::vector<IndexPointer> more{};
+            std::size_t overflow{kInvalidNode};
+            std::size_t overflowCount{0};
+
+            std::size_t size() const {
+                return 1 + more.size() + overflowCount;
+            }
+        };
+
+        // Overflow pages are nodes that are neither leaf nor internal; they
+        // keep their pointers in `pointers` and chain through nextLeaf.
         struct Node {
             std::size_t id{0};
             bool leaf{true};
-            std::vector<std::string> keys;
-            std::vector<IndexPointer> values;
+            bool overflow{false};
+            NodeKeys keys;
+            std::vector<Posting> values;
+            std::vector<IndexPointer> pointers;
             std::vector<std::size_t> children;
             bool hasNext{false};
             std::size_t nextLeaf{kInvalidNode};
         };
 
         enum class DeleteState { NotFound, Balanced, NeedsRebalance };
+        enum class PostingRemoval { Missing, Removed, Emptied };
+        enum class LeafChange { Applied, Missing, NeedsStructure };
 
-        static constexpr std::size_t kInvalidNode = std::numeric_limits<std::size_t>::max();
+        // Latches of the concurrent mode. Leaves are latched through
+        // stripes picked by node id, and a thread holds at most one stripe
+        // at a time, so stripes shared by several leaves cannot deadlock.
+        struct Latches {
+            struct alignas(64) Stripe {
+                std::shared_mutex latch;
+            };
+            static constexpr std::size_t kStripes = 64;
 
-        void ensureRoot() {
-            if (maxKeys_ == 0) {
-                throw std::logic_error("B+ tree must be initialized before use");
-            }
-            if (rootId_ == kInvalidNode) {
-                rootId_ = createNode(true);
+            std::shared_mutex structure;
+            std::array<Stripe, kStripes> leaves;
+            // Guards dirtyNodes_ while leaves change side by side.
+            std::mutex dirty;
+        };
+
+        // The structure latch an operation holds: shared for one that only
+        // reads or stays inside a leaf of an in-memory tree, exclusive for
+        // one on a paged tree. Empty unless concurrent access is enabled.
+        struct StructureLatch {
+            std::shared_lock<std::shared_mutex> shared;
+            std::unique_lock<std::shared_mutex> exclusive;
+        };
+
+        bool leafLatching() const {
+            return latches_ && !store_;
+        }
+
+        StructureLatch readStructure() const {
+            StructureLatch latch;
+            if (leafLatching()) {
+                latch.shared = std::shared_lock<std::shared_mutex>(latches_->structure);
+            } else if (latches_) {
+                latch.exclusive = std::unique_lock<std::shared_mutex>(latches_->structure);
             }
+            return latch;
         }
 
-        std::size_t createNode(bool leaf) {
-            Node node;
-            node.id = nextNodeId_++;
-            node.leaf = leaf;
-            node.hasNext = false;
-            node.nextLeaf = kInvalidNode;
-            return nodes_.emplace(node.id, std::move(node)).first->second.id;
+        std::unique_lock<std::shared_mutex> writeStructure() const {
+            return latches_ ? std::unique_lock<std::shared_mutex>(latches_->structure)
+                            : std::unique_lock<std::shared_mutex>();
         }
 
-        std::size_t locateLeaf(std::size_t nodeId, const std::string &key) const {
-            const auto &node = nodes_.at(nodeId);
-            if (node.leaf) {
-                return nodeId;
-            }
-            const std::size_t childIdx = findChildIndex(node, key);
-            return locateLeaf(node.children[childIdx], key);
+        std::shared_mutex &leafLatch(std::size_t leafId) const {
+            return latches_->leaves[leafId % Latches::kStripes].latch;
         }
 
-        std::optional<std::pair<std::string, std::size_t>> insertRecursive(std::size_t nodeId,
-                                                                           const std::string &key,
-                                                                           const IndexPointer &ptr,
-                                                                           bool failOnDuplicate) {
-            auto &node = nodes_.at(nodeId);
-            if (node.leaf) {
-                auto it = std::lower_bound(node.keys.begin(), node.keys.end(), key);
-                const std::size_t idx = static_cast<std::size_t>(std::distance(node.keys.begin(), it));
-                if (it != node.keys.end() && *it == key) {
-                    if (failOnDuplicate) {
-                        std::ostringstream oss;
-                        oss << "duplicate index key '" << key << "'";
-                        throw std::runtime_error(oss.str());
+        std::shared_lock<std::shared_mutex> readLeaf(std::size_t leafId) const {
+            return leafLatching() ? std::shared_lock<std::shared_mutex>(leafLatch(leafId))
+                                  : std::shared_lock<std::shared_mutex>();
+        }
+
+        void markLeafDirty(std::size_t leafId) {
+            std::lock_guard<std::mutex> guard(latches_->dirty);
+            dirtyNodes_.insert(leafId);
+        }
+
+        void insertEntry(const std::string &key, const IndexPointer &ptr, bool appendDuplicate) {
+            if (leafLatching()) {
+                std::shared_lock<std::shared_mutex> structure(latches_->structure);
+                if (rootId_ != kInvalidNode &&
+                    insertIntoLeaf(key, ptr, appendDuplicate) == LeafChange::Applied) {
+                    return;
+                }
+            }
+            const auto structure = writeStructure();
+            ensureRoot();
+            auto split = insertRecursive(rootId_, key, ptr, false, appendDuplicate);
+            if (split.has_value()) {
+                promoteToNewRoot(*split);
+            }
+            syncPages();
+        }
+
+        // The leaf-only paths below run under a shared structure latch and
+        // the exclusive latch of their leaf. They give up, leaving the leaf
+        // as it was, when the change needs the structure latch exclusively.
+        LeafChange insertIntoLeaf(const std::string &key, const IndexPointer &ptr, bool appendDuplicate) {
+            const std::size_t leafId = locateLeaf(rootId_, key);
+            std::unique_lock<std::shared_mutex> latch(leafLatch(leafId));
+            auto &leaf = fetchNode(leafId);
+            const std::size_t idx = leaf.keys.lowerBound(key);
+            if (leaf.keys.matches(idx, key)) {
+                auto &posting = leaf.values[idx];
+                if (appendDuplicate) {
+                    if (1 + posting.more.size() >= inlineLimit_) {
+                        return LeafChange::NeedsStructure;
+                    }
+                    posting.more.push_back(ptr);
+                    if (!nodeFits(leaf)) {
+                        posting.more.pop_back();
+                        return LeafChange::NeedsStructure;
+                    }
+                } else if (posting.overflow != kInvalidNode) {
+                    return LeafChange::NeedsStructure;
+                } else {
+                    posting = Posting{ptr};
+                }
+            } else {
+                leaf.keys.insert(idx, key);
+                leaf.values.insert(leaf.values.begin() + static_cast<std::ptrdiff_t>(idx), Posting{ptr});
+                if (!nodeFits(leaf)) {
+                    leaf.keys.erase(idx);
+                    leaf.values.erase(leaf.values.begin() + static_cast<std::ptrdiff_t>(idx));
+                    return LeafChange::NeedsStructure;
+                }
+            }
+            markLeafDirty(leafId);
+            return LeafChange::Applied;
+        }
+
+        LeafChange eraseFromLeaf(const std::string &key, const IndexPointer *ptr) {
+            const std::size_t leafId = locateLeaf(rootId_, key);
+            std::unique_lock<std::shared_mutex> latch(leafLatch(leafId));
+            auto &leaf = fetchNode(leafId);
+            const std::size_t idx = leaf.keys.lowerBound(key);
+            if (!leaf.keys.matches(idx, key)) {
+                return LeafChange::Missing;
+            }
+            if (leaf.values[idx].overflow != kInvalidNode) {
+                return LeafChange::NeedsStructure;
+            }
+            if (ptr) {
+                // Without overflow pages this only touches the leaf, and an
+                // emptied posting is left as it was.
+                const auto removal = removeFromPosting(leaf.values[idx], *ptr);
+                if (removal == PostingRemoval::Missing) {
+                    return LeafChange::Missing;
+                }
+                if (removal == PostingRemoval::Removed) {
+                    markLeafDirty(leafId);
+                    return LeafChange::Applied;
+                }
+            }
+            if (leafId != rootId_ && leaf.keys.size() <= minKeys_) {
+                return LeafChange::NeedsStructure;
+            }
+            leaf.keys.erase(idx);
+            leaf.values.erase(leaf.values.begin() + static_cast<std::ptrdiff_t>(idx));
+            markLeafDirty(leafId);
+            return LeafChange::Applied;
+        }
+
+        LeafChange updateInLeaf(const std::string &key, const IndexPointer &ptr) {
+            if (rootId_ == kInvalidNode) {
+                return LeafChange::Missing;
+            }
+            const std::size_t leafId = locateLeaf(rootId_, key);
+            std::unique_lock<std::shared_mutex> latch(leafLatch(leafId));
+            auto &leaf = fetchNode(leafId);
+            const std::size_t idx = leaf.keys.lowerBound(key);
+            if (!leaf.keys.matches(idx, key)) {
+                return LeafChange::Missing;
+            }
+            if (leaf.values[idx].overflow != kInvalidNode) {
+                return LeafChange::NeedsStructure;
+            }
+            leaf.values[idx] = Posting{ptr};
+            markLeafDirty(leafId);
+            return LeafChange::Applied;
+        }
+
+        // leaf(1) hasNext(1) nextLeaf(8) count(2)
+        static constexpr std::size_t kNodeHeaderBytes = 12;
+        // block(8) slot(4)
+        static constexpr std::size_t kPointerBytes = 12;
+        // Set in the kind byte when the keys share a prefix written once:
+        // length(2) + prefix after the count, each key then only its rest.
+        static constexpr unsigned kPrefixedKeys = 0x80;
+
+        void ensureRoot() {
+            if (maxKeys_ == 0) {
+                throw std::logic_error("B+ tree must be initialized before use");
+            }
+            if (rootId_ == kInvalidNode) {
+                rootId_ = createNode(true);
+            }
+        }
+
+        std::size_t createNode(bool leaf) {
+            Node node;
+            if (!store_) {
+                node.id = nextNodeId_++;
+            } else if (!freePages_.empty()) {
+                node.id = freePages_.back();
+                freePages_.pop_back();
+            } else {
+                node.id = store_->allocatePage();
+            }
+            ++nodeCount_;
+            node.keys = NodeKeys(keyLength_);
+            node.leaf = leaf;
+            node.hasNext = false;
+            node.nextLeaf = kInvalidNode;
+            markDirty(node.id);
+            return nodes_.emplace(node.id, std::move(node)).first->second.id;
+        }
+
+        std::size_t locateLeaf(std::size_t nodeId, const std::string &key) const {
+            const auto &node = fetchNode(nodeId);
+            if (node.leaf) {
+                return nodeId;
+            }
+            const std::size_t childIdx = findChildIndex(node, key);
+            return locateLeaf(node.children[childIdx], key);
+        }
+
+        std::size_t leftmostLeaf(std::size_t nodeId) const {
+            const auto &node = fetchNode(nodeId);
+            if (node.leaf) {
+                return nodeId;
+            }
+            return leftmostLeaf(node.children.front());
+        }
+
+        std::optional<std::pair<std::string, std::size_t>> insertRecursive(std::size_t nodeId,
+                                                                           const std::string &key,
+                                                                           const IndexPointer &ptr,
+                                                                           bool failOnDuplicate,
+                                                                           bool appendDuplicate) {
+            auto &node = fetchNode(nodeId);
+            if (node.leaf) {
+                const std::size_t idx = node.keys.lowerBound(key);
+                if (node.keys.matches(idx, key)) {
+                    if (failOnDuplicate) {
+                        std::ostringstream oss;
+                        oss << "duplicate index key '" << key << "'";
+                        throw std::runtime_error(oss.str());
+                    }
+                    if (appendDuplicate) {
+                        appendToPosting(node.values[idx], ptr);
+                    } else {
+                        releaseOverflow(node.values[idx]);
+                        node.values[idx] = Posting{ptr};
+                    }
+                    markDirty(nodeId);
+                    if (!nodeFits(node)) {
+                        return splitLeaf(nodeId);
                     }
-                    node.values[idx] = ptr;
                     return std::nullopt;
                 }
-                node.keys.insert(it, key);
-                node.values.insert(node.values.begin() + idx, ptr);
-                if (node.keys.size() > maxKeys_) {
+                node.keys.insert(idx, key);
+                node.values.insert(node.values.begin() + idx, Posting{ptr});
+                markDirty(nodeId);
+                if (!nodeFits(node)) {
                     return splitLeaf(nodeId);
                 }
                 return std::nullopt;
             }
             const std::size_t childPos = findChildIndex(node, key);
-            auto split = insertRecursive(node.children[childPos], key, ptr, failOnDuplicate);
+            auto split = insertRecursive(node.children[childPos], key, ptr, failOnDuplicate,
+                                         appendDuplicate);
             if (!split.has_value()) {
                 return std::nullopt;
             }
-            node.keys.insert(node.keys.begin() + childPos, split->first);
+            node.keys.insert(childPos, split->first);
             node.children.insert(node.children.begin() + childPos + 1, split->second);
-            if (node.keys.size() > maxKeys_) {
+            markDirty(nodeId);
+            if (!nodeFits(node)) {
                 return splitInternal(nodeId);
             }
             return std::nullopt;
@@ -466,7 +1002,7 @@ private:
 
         void promoteToNewRoot(const std::pair<std::string, std::size_t> &splitInfo) {
             const std::size_t newRootId = createNode(false);
-            auto &root = nodes_.at(newRootId);
+            auto &root = fetchNode(newRootId);
             root.leaf = false;
             root.keys.push_back(splitInfo.first);
             root.children.push_back(rootId_);
@@ -475,53 +1011,358 @@ private:
         }
 
         std::optional<std::pair<std::string, std::size_t>> splitLeaf(std::size_t nodeId) {
-            auto &node = nodes_.at(nodeId);
+            auto &node = fetchNode(nodeId);
             const std::size_t newNodeId = createNode(true);
-            auto &right = nodes_.at(newNodeId);
-            const std::size_t mid = node.keys.size() / 2;
-            right.keys.assign(node.keys.begin() + mid, node.keys.end());
+            auto &right = fetchNode(newNodeId);
+            const std::size_t mid = splitPoint(node);
+            right.keys.append(node.keys, mid, node.keys.size());
             right.values.assign(node.values.begin() + mid, node.values.end());
-            node.keys.erase(node.keys.begin() + mid, node.keys.end());
+            node.keys.truncate(mid);
             node.values.erase(node.values.begin() + mid, node.values.end());
+            node.keys.compact();
+            right.keys.compact();
             right.hasNext = node.hasNext;
             right.nextLeaf = node.nextLeaf;
             node.hasNext = true;
             node.nextLeaf = newNodeId;
-            return std::make_pair(right.keys.front(), newNodeId);
+            markDirty(nodeId);
+            return std::make_pair(shortestSeparator(node.keys.back(), right.keys.front()), newNodeId);
         }
 
         std::optional<std::pair<std::string, std::size_t>> splitInternal(std::size_t nodeId) {
-            auto &node = nodes_.at(nodeId);
+            auto &node = fetchNode(nodeId);
             const std::size_t newNodeId = createNode(false);
-            auto &right = nodes_.at(newNodeId);
-            const std::size_t mid = node.keys.size() / 2;
+            auto &right = fetchNode(newNodeId);
+            const std::size_t mid = splitPoint(node);
             const std::string promote = node.keys[mid];
             right.leaf = false;
-            right.keys.assign(node.keys.begin() + mid + 1, node.keys.end());
+            right.keys.append(node.keys, mid + 1, node.keys.size());
             right.children.assign(node.children.begin() + mid + 1, node.children.end());
-            node.keys.erase(node.keys.begin() + mid, node.keys.end());
+            node.keys.truncate(mid);
             node.children.erase(node.children.begin() + mid + 1, node.children.end());
+            node.keys.compact();
+            right.keys.compact();
+            markDirty(nodeId);
             return std::make_pair(promote, newNodeId);
         }
 
         std::size_t findChildIndex(const Node &node, const std::string &key) const {
-            auto it = std::upper_bound(node.keys.begin(), node.keys.end(), key);
-            return static_cast<std::size_t>(std::distance(node.keys.begin(), it));
+            return node.keys.upperBound(key);
+        }
+
+        bool eraseEntry(const std::string &key, const IndexPointer *ptr) {
+            if (leafLatching()) {
+                std::shared_lock<std::shared_mutex> structure(latches_->structure);
+                if (rootId_ == kInvalidNode) {
+                    return false;
+                }
+                const auto change = eraseFromLeaf(key, ptr);
+                if (change != LeafChange::NeedsStructure) {
+                    return change == LeafChange::Applied;
+                }
+            }
+            const auto structure = writeStructure();
+            if (rootId_ == kInvalidNode) {
+                return false;
+            }
+            const auto state = eraseRecursive(rootId_, key, ptr, kInvalidNode, 0);
+            if (state == DeleteState::NotFound) {
+                trimCache();
+                return false;
+            }
+            if (rootId_ != kInvalidNode) {
+                auto &root = fetchNode(rootId_);
+                if (!root.leaf && root.keys.empty() && root.children.size() == 1) {
+                    const std::size_t oldRoot = rootId_;
+                    rootId_ = root.children.front();
+                    releaseNode(oldRoot);
+                }
+            }
+            syncPages();
+            return true;
+        }
+
+        // A leaf split must leave both halves within the page, which holds
+        // as long as no entry takes more than a third of it; inlineLimit_ is
+        // chosen so that a full posting plus its overflow link stays below.
+        void configurePostings(std::size_t keyBytes) {
+            const std::size_t largestEntry =
+                pageBudget_ > kNodeHeaderBytes ? (pageBudget_ - kNodeHeaderBytes) / 3 : 0;
+            const std::size_t smallestSpilled = keyBytes + 4 + 2 * kPointerBytes;
+            if (largestEntry < smallestSpilled) {
+                std::ostringstream oss;
+                oss << "index page of " << pageBudget_
+                    << " bytes cannot hold posting lists for keys of " << keyBytes << " bytes";
+                throw std::runtime_error(oss.str());
+            }
+            inlineLimit_ = 1 + (largestEntry - smallestSpilled) / kPointerBytes;
+            overflowCapacity_ = (pageBudget_ - kNodeHeaderBytes) / kPointerBytes;
+            maxKeys_ = std::min(maxKeys_,
+                                (pageBudget_ - kNodeHeaderBytes) / (keyBytes + 4 + kPointerBytes));
+        }
+
+        // Encoded size of one leaf entry's posting: pointer count(2) + inline
+        // pointers + overflow page(8) and count(4).
+        std::size_t postingBytes(const Posting &posting) const {
+            std::size_t bytes = 2 + kPointerBytes * (1 + posting.more.size());
+            if (posting.overflow != kInvalidNode) {
+                bytes += kPointerBytes;
+            }
+            return bytes;
+        }
+
+        // Bytes a node needs for what follows its keys.
+        std::size_t valueBytes(const Node &node, std::size_t first, std::size_t last) const {
+            if (!node.leaf) {
+                return 8 * (last - first + 1);
+            }
+            if (!duplicates_) {
+                return kPointerBytes * (last - first);
+            }
+            std::size_t bytes = 0;
+            for (std::size_t i = first; i < last; ++i) {
+                bytes += postingBytes(node.values[i]);
+            }
+            return bytes;
+        }
+
+        // Keys are written as length(2) + bytes; a prefix shared by all of
+        // them is written once, behind its own length, when that is shorter.
+        static bool prefixPays(std::size_t count, std::size_t prefix) {
+            return count > 1 && (count - 1) * prefix > 2;
+        }
+
+        static std::size_t keySectionBytes(std::size_t count, std::size_t keyBytes, std::size_t prefix) {
+            const std::size_t plain = 2 * count + keyBytes;
+            return prefixPays(count, prefix) ? plain + 2 - (count - 1) * prefix : plain;
+        }
+
+        static std::size_t sharedPrefixLength(const std::string &a, const std::string &b) {
+            const std::size_t limit = std::min(a.size(), b.size());
+            std::size_t shared = 0;
+            while (shared < limit && a[shared] == b[shared]) {
+                ++shared;
+            }
+            return shared;
+        }
+
+        // Encoded size of a node.
+        std::size_t nodeBytes(const Node &node) const {
+            return kNodeHeaderBytes +
+                   keySectionBytes(node.keys.size(), node.keys.totalKeyBytes(), node.keys.commonPrefixLength()) +
+                   valueBytes(node, 0, node.keys.size());
+        }
+
+        // maxKeys_ entries always fit uncompressed, so only nodes beyond that
+        // count, and leaves whose postings vary in size, are measured against
+        // the page. Compressed keys let a node hold more than maxKeys_.
+        bool nodeFits(const Node &node) const {
+            if (node.keys.size() <= 1 || (node.keys.size() <= maxKeys_ && !(duplicates_ && node.leaf))) {
+                return true;
+            }
+            return nodeBytes(node) <= pageBudget_;
+        }
+
+        // Where to split an overfull node so that the larger half is as small
+        // as possible; internal nodes promote the key at that position. Ties
+        // go to the position nearest the middle.
+        std::size_t splitPoint(const Node &node) const {
+            const std::size_t count = node.keys.size();
+            std::vector<std::string> keys;
+            keys.reserve(count);
+            std::vector<std::size_t> keyPrefix(count + 1, 0);
+            std::vector<std::size_t> valuePrefix(count + 1, 0);
+            for (std::size_t i = 0; i < count; ++i) {
+                keys.push_back(node.keys[i]);
+                keyPrefix[i + 1] = keyPrefix[i] + keys[i].size();
+                valuePrefix[i + 1] = valuePrefix[i] + (node.leaf ? valueBytes(node, i, i + 1) : 8);
+            }
+            // Bytes of a node holding keys [first, last) and their values.
+            auto rangeBytes = [&](std::size_t first, std::size_t last) {
+                const std::size_t shared = last - first > 1 ? sharedPrefixLength(keys[first], keys[last - 1]) : 0;
+                return kNodeHeaderBytes + keySectionBytes(last - first, keyPrefix[last] - keyPrefix[first], shared) +
+                       valuePrefix[last] - valuePrefix[first] + (node.leaf ? 0 : 8);
+            };
+            const std::size_t first = 1;
+            const std::size_t last = node.leaf ? count - 1 : count - 2;
+            std::size_t best = count / 2;
+            std::size_t bestBytes = std::numeric_limits<std::size_t>::max();
+            for (std::size_t at = first; at <= last; ++at) {
+                const std::size_t bytes =
+                    std::max(rangeBytes(0, at), rangeBytes(node.leaf ? at : at + 1, count));
+                const auto distance = [&](std::size_t pos) {
+                    return pos > count / 2 ? pos - count / 2 : count / 2 - pos;
+                };
+                if (bytes < bestBytes || (bytes == bestBytes && distance(at) < distance(best))) {
+                    best = at;
+                    bestBytes = bytes;
+                }
+            }
+            return best;
+        }
+
+        // Shortest key that still sorts after `left` and no later than
+        // `right`, so parents carry as few bytes as the data allows.
+        static std::string shortestSeparator(const std::string &left, const std::string &right) {
+            return right.substr(0, std::min(right.size(), sharedPrefixLength(left, right) + 1));
+        }
+
+        // Fills the leaf entry first, then the newest overflow page; a full
+        // chain grows by a page at its front.
+        void appendToPosting(Posting &posting, const IndexPointer &ptr) {
+            if (1 + posting.more.size() < inlineLimit_) {
+                posting.more.push_back(ptr);
+                return;
+            }
+            ++posting.overflowCount;
+            if (posting.overflow != kInvalidNode) {
+                auto &page = fetchNode(posting.overflow);
+                if (page.pointers.size() < overflowCapacity_) {
+                    page.pointers.push_back(ptr);
+                    markDirty(page.id);
+                    return;
+                }
+            }
+            const std::size_t pageId = createNode(false);
+            auto &page = fetchNode(pageId);
+            page.overflow = true;
+            page.hasNext = posting.overflow != kInvalidNode;
+            page.nextLeaf = posting.overflow;
+            page.pointers.push_back(ptr);
+            posting.overflow = pageId;
+        }
+
+        PostingRemoval removeFromPosting(Posting &posting, const IndexPointer &ptr) {
+            if (posting.head == ptr) {
+                if (!posting.more.empty()) {
+                    posting.head = posting.more.back();
+                    posting.more.pop_back();
+                } else if (posting.overflow != kInvalidNode) {
+                    auto &page = fetchNode(posting.overflow);
+                    posting.head = page.pointers.back();
+                    page.pointers.pop_back();
+                    --posting.overflowCount;
+                    dropOverflowPageIfEmpty(posting, kInvalidNode, page.id);
+                } else {
+                    return PostingRemoval::Emptied;
+                }
+                return PostingRemoval::Removed;
+            }
+            auto inlineIt = std::find(posting.more.begin(), posting.more.end(), ptr);
+            if (inlineIt != posting.more.end()) {
+                *inlineIt = posting.more.back();
+                posting.more.pop_back();
+                return PostingRemoval::Removed;
+            }
+            std::size_t previous = kInvalidNode;
+            for (std::size_t pageId = posting.overflow; pageId != kInvalidNode;) {
+                auto &page = fetchNode(pageId);
+                auto it = std::find(page.pointers.begin(), page.pointers.end(), ptr);
+                if (it != page.pointers.end()) {
+                    *it = page.pointers.back();
+                    page.pointers.pop_back();
+                    --posting.overflowCount;
+                    dropOverflowPageIfEmpty(posting, previous, pageId);
+                    return PostingRemoval::Removed;
+                }
+                previous = pageId;
+                pageId = page.hasNext ? page.nextLeaf : kInvalidNode;
+            }
+            return PostingRemoval::Missing;
+        }
+
+        void dropOverflowPageIfEmpty(Posting &posting, std::size_t previous, std::size_t pageId) {
+            auto &page = fetchNode(pageId);
+            if (!page.pointers.empty()) {
+                markDirty(pageId);
+                return;
+            }
+            const std::size_t next = page.hasNext ? page.nextLeaf : kInvalidNode;
+            if (previous == kInvalidNode) {
+                posting.overflow = next;
+            } else {
+                auto &prev = fetchNode(previous);
+                prev.hasNext = next != kInvalidNode;
+                prev.nextLeaf = next;
+                markDirty(previous);
+            }
+            releaseNode(pageId);
+        }
+
+        void releaseOverflow(Posting &posting) {
+            for (std::size_t pageId = posting.overflow; pageId != kInvalidNode;) {
+                const auto &page = fetchNode(pageId);
+                const std::size_t next = page.hasNext ? page.nextLeaf : kInvalidNode;
+                releaseNode(pageId);
+                pageId = next;
+            }
+            posting.overflow = kInvalidNode;
+            posting.overflowCount = 0;
+        }
+
+        void flushOverflowChain(const Posting &posting) {
+            for (std::size_t pageId = posting.overflow; pageId != kInvalidNode;) {
+                const auto &page = fetchNode(pageId);
+                const std::size_t next = page.hasNext ? page.nextLeaf : kInvalidNode;
+                flushNode(pageId);
+                pageId = next;
+            }
+        }
+
+        // Calls `visit` for every pointer of the posting until it returns
+        // false; overflow pages are dropped from the cache once read.
+        template <typename Visit>
+        bool visitPosting(const Posting &posting, Visit &&visit) const {
+            if (!visit(posting.head)) {
+                return false;
+            }
+            for (const auto &ptr : posting.more) {
+                if (!visit(ptr)) {
+                    return false;
+                }
+            }
+            for (std::size_t pageId = posting.overflow; pageId != kInvalidNode;) {
+                const auto &page = fetchNode(pageId);
+                for (const auto &ptr : page.pointers) {
+                    if (!visit(ptr)) {
+                        return false;
+                    }
+                }
+                const std::size_t next = page.hasNext ? page.nextLeaf : kInvalidNode;
+                if (store_) {
+                    nodes_.erase(pageId);
+                }
+                pageId = next;
+            }
+            return true;
         }
 
         DeleteState eraseRecursive(std::size_t nodeId,
                                    const std::string &key,
+                                   const IndexPointer *ptr,
                                    std::size_t parentId,
                                    std::size_t parentChildIndex) {
-            auto &node = nodes_.at(nodeId);
+            auto &node = fetchNode(nodeId);
             if (node.leaf) {
-                auto it = std::lower_bound(node.keys.begin(), node.keys.end(), key);
-                if (it == node.keys.end() || *it != key) {
+                const std::size_t idx = node.keys.lowerBound(key);
+                if (!node.keys.matches(idx, key)) {
                     return DeleteState::NotFound;
                 }
-                const std::size_t idx = static_cast<std::size_t>(std::distance(node.keys.begin(), it));
-                node.keys.erase(node.keys.begin() + idx);
+                if (ptr) {
+                    const auto removal = removeFromPosting(node.values[idx], *ptr);
+                    if (removal == PostingRemoval::Missing) {
+                        return DeleteState::NotFound;
+                    }
+                    if (removal == PostingRemoval::Removed) {
+                        markDirty(nodeId);
+                        return DeleteState::Balanced;
+                    }
+                } else {
+                    releaseOverflow(node.values[idx]);
+                }
+                node.keys.erase(idx);
                 node.values.erase(node.values.begin() + idx);
+                markDirty(nodeId);
                 if (nodeId == rootId_) {
                     return DeleteState::Balanced;
                 }
@@ -532,7 +1373,7 @@ private:
             if (childIndex >= node.children.size()) {
                 childIndex = node.children.size() - 1;
             }
-            auto state = eraseRecursive(node.children[childIndex], key, nodeId, childIndex);
+            auto state = eraseRecursive(node.children[childIndex], key, ptr, nodeId, childIndex);
             if (state == DeleteState::NotFound) {
                 return DeleteState::NotFound;
             }
@@ -543,7 +1384,7 @@ private:
                 if (!node.leaf && node.keys.empty() && node.children.size() == 1) {
                     const std::size_t oldRoot = rootId_;
                     rootId_ = node.children.front();
-                    nodes_.erase(oldRoot);
+                    releaseNode(oldRoot);
                 }
                 return DeleteState::Balanced;
             }
@@ -552,7 +1393,7 @@ private:
         }
 
         void rebalanceChild(std::size_t parentId, std::size_t childIndex) {
-            auto &parent = nodes_.at(parentId);
+            auto &parent = fetchNode(parentId);
             if (parent.children.empty()) {
                 return;
             }
@@ -560,123 +1401,998 @@ private:
                 childIndex = parent.children.size() - 1;
             }
             const std::size_t childId = parent.children[childIndex];
-            auto &child = nodes_.at(childId);
+            auto &child = fetchNode(childId);
             if (child.leaf) {
+                // Posting lists and compressed keys make entries uneven in
+                // size, so a leaf only borrows or merges what fits the pages
+                // involved and otherwise stays underfull.
                 if (childIndex > 0) {
-                    auto &left = nodes_.at(parent.children[childIndex - 1]);
-                    if (left.keys.size() > minKeys_) {
+                    auto &left = fetchNode(parent.children[childIndex - 1]);
+                    const std::size_t last = left.keys.size() - 1;
+                    if (left.keys.size() > minKeys_ && canTake(child, 0, left, last) &&
+                        separatorFits(parent, childIndex - 1,
+                                      shortestSeparator(left.keys[last - 1], left.keys[last]))) {
                         borrowFromLeftLeaf(parent, childIndex);
                         return;
                     }
                 }
                 if (childIndex + 1 < parent.children.size()) {
-                    auto &right = nodes_.at(parent.children[childIndex + 1]);
-                    if (right.keys.size() > minKeys_) {
+                    auto &right = fetchNode(parent.children[childIndex + 1]);
+                    if (right.keys.size() > minKeys_ && canTake(child, child.keys.size(), right, 0) &&
+                        separatorFits(parent, childIndex, shortestSeparator(right.keys[0], right.keys[1]))) {
                         borrowFromRightLeaf(parent, childIndex);
                         return;
                     }
                 }
                 if (childIndex > 0) {
-                    mergeLeaves(parentId, childIndex - 1);
+                    if (canMerge(fetchNode(parent.children[childIndex - 1]), child, nullptr)) {
+                        mergeLeaves(parentId, childIndex - 1);
+                    }
                 } else if (parent.children.size() >= 2) {
-                    mergeLeaves(parentId, 0);
+                    if (canMerge(child, fetchNode(parent.children[1]), nullptr)) {
+                        mergeLeaves(parentId, 0);
+                    }
                 }
             } else {
                 if (childIndex > 0) {
-                    auto &left = nodes_.at(parent.children[childIndex - 1]);
-                    if (left.keys.size() > minKeys_) {
+                    auto &left = fetchNode(parent.children[childIndex - 1]);
+                    if (left.keys.size() > minKeys_ &&
+                        separatorFits(parent, childIndex - 1, left.keys.back())) {
                         borrowFromLeftInternal(parent, childIndex);
                         return;
                     }
                 }
                 if (childIndex + 1 < parent.children.size()) {
-                    auto &right = nodes_.at(parent.children[childIndex + 1]);
-                    if (right.keys.size() > minKeys_) {
+                    auto &right = fetchNode(parent.children[childIndex + 1]);
+                    if (right.keys.size() > minKeys_ && separatorFits(parent, childIndex, right.keys.front())) {
                         borrowFromRightInternal(parent, childIndex);
                         return;
                     }
                 }
                 if (childIndex > 0) {
-                    mergeInternal(parentId, childIndex - 1);
+                    const std::string separator = parent.keys[childIndex - 1];
+                    if (canMerge(fetchNode(parent.children[childIndex - 1]), child, &separator)) {
+                        mergeInternal(parentId, childIndex - 1);
+                    }
                 } else if (parent.children.size() >= 2) {
-                    mergeInternal(parentId, 0);
+                    const std::string separator = parent.keys[0];
+                    if (canMerge(child, fetchNode(parent.children[1]), &separator)) {
+                        mergeInternal(parentId, 0);
+                    }
                 }
             }
         }
 
+        // Whether `node` still fits its page with entry `idx` of `from`
+        // inserted at position `at`.
+        bool canTake(const Node &node, std::size_t at, const Node &from, std::size_t idx) const {
+            if (!duplicates_ && node.keys.size() < maxKeys_) {
+                return true;
+            }
+            Node trial = node;
+            trial.keys.insert(at, from.keys[idx]);
+            trial.values.insert(trial.values.begin() + static_cast<std::ptrdiff_t>(at), from.values[idx]);
+            return nodeFits(trial);
+        }
+
+        // Whether `parent` still fits its page with separator `index`
+        // replaced by `key`.
+        bool separatorFits(const Node &parent, std::size_t index, const std::string &key) const {
+            if (parent.keys.size() <= maxKeys_) {
+                return true;
+            }
+            Node trial = parent;
+            trial.keys.set(index, key);
+            return nodeFits(trial);
+        }
+
+        // Whether `left` and `right`, joined by `separator` when they are
+        // internal, fit one page.
+        bool canMerge(const Node &left, const Node &right, const std::string *separator) const {
+            const std::size_t count = left.keys.size() + right.keys.size() + (separator ? 1 : 0);
+            if (count <= 1 || (count <= maxKeys_ && !(duplicates_ && left.leaf))) {
+                return true;
+            }
+            const std::string first =
+                !left.keys.empty() ? left.keys.front() : (separator ? *separator : right.keys.front());
+            const std::string last =
+                !right.keys.empty() ? right.keys.back() : (separator ? *separator : left.keys.back());
+            const std::size_t keyBytes =
+                left.keys.totalKeyBytes() + right.keys.totalKeyBytes() + (separator ? separator->size() : 0);
+            const std::size_t bytes = kNodeHeaderBytes +
+                                      keySectionBytes(count, keyBytes, sharedPrefixLength(first, last)) +
+                                      valueBytes(left, 0, left.keys.size()) +
+                                      valueBytes(right, 0, right.keys.size());
+            return bytes <= pageBudget_;
+        }
+
         void borrowFromLeftLeaf(Node &parent, std::size_t childIndex) {
-            auto &left = nodes_.at(parent.children[childIndex - 1]);
-            auto &child = nodes_.at(parent.children[childIndex]);
-            child.keys.insert(child.keys.begin(), left.keys.back());
+            auto &left = fetchNode(parent.children[childIndex - 1]);
+            auto &child = fetchNode(parent.children[childIndex]);
+            child.keys.insert(0, left.keys.back());
             child.values.insert(child.values.begin(), left.values.back());
             left.keys.pop_back();
             left.values.pop_back();
-            parent.keys[childIndex - 1] = child.keys.front();
+            left.keys.compact();
+            parent.keys.set(childIndex - 1, shortestSeparator(left.keys.back(), child.keys.front()));
+            markDirty(parent.id);
+            markDirty(parent.children[childIndex - 1]);
+            markDirty(parent.children[childIndex]);
         }
 
         void borrowFromRightLeaf(Node &parent, std::size_t childIndex) {
-            auto &right = nodes_.at(parent.children[childIndex + 1]);
-            auto &child = nodes_.at(parent.children[childIndex]);
+            auto &right = fetchNode(parent.children[childIndex + 1]);
+            auto &child = fetchNode(parent.children[childIndex]);
             child.keys.push_back(right.keys.front());
             child.values.push_back(right.values.front());
-            right.keys.erase(right.keys.begin());
+            right.keys.erase(0);
             right.values.erase(right.values.begin());
-            parent.keys[childIndex] = right.keys.front();
+            right.keys.compact();
+            parent.keys.set(childIndex, shortestSeparator(child.keys.back(), right.keys.front()));
+            markDirty(parent.id);
+            markDirty(parent.children[childIndex + 1]);
+            markDirty(parent.children[childIndex]);
         }
 
         void mergeLeaves(std::size_t parentId, std::size_t leftIndex) {
-            auto &parent = nodes_.at(parentId);
+            auto &parent = fetchNode(parentId);
             if (leftIndex + 1 >= parent.children.size()) {
                 return;
             }
             const std::size_t leftId = parent.children[leftIndex];
             const std::size_t rightId = parent.children[leftIndex + 1];
-            auto &left = nodes_.at(leftId);
-            auto &right = nodes_.at(rightId);
-            left.keys.insert(left.keys.end(), right.keys.begin(), right.keys.end());
+            auto &left = fetchNode(leftId);
+            auto &right = fetchNode(rightId);
+            left.keys.append(right.keys, 0, right.keys.size());
             left.values.insert(left.values.end(), right.values.begin(), right.values.end());
+            left.keys.compact();
             left.hasNext = right.hasNext;
             left.nextLeaf = right.nextLeaf;
-            parent.keys.erase(parent.keys.begin() + leftIndex);
+            parent.keys.erase(leftIndex);
             parent.children.erase(parent.children.begin() + leftIndex + 1);
-            nodes_.erase(rightId);
+            markDirty(parentId);
+            markDirty(leftId);
+            releaseNode(rightId);
         }
 
         void borrowFromLeftInternal(Node &parent, std::size_t childIndex) {
-            auto &left = nodes_.at(parent.children[childIndex - 1]);
-            auto &child = nodes_.at(parent.children[childIndex]);
-            child.keys.insert(child.keys.begin(), parent.keys[childIndex - 1]);
-            parent.keys[childIndex - 1] = left.keys.back();
+            auto &left = fetchNode(parent.children[childIndex - 1]);
+            auto &child = fetchNode(parent.children[childIndex]);
+            child.keys.insert(0, parent.keys[childIndex - 1]);
+            parent.keys.set(childIndex - 1, left.keys.back());
             child.children.insert(child.children.begin(), left.children.back());
             left.keys.pop_back();
             left.children.pop_back();
+            left.keys.compact();
+            markDirty(parent.id);
+            markDirty(parent.children[childIndex - 1]);
+            markDirty(parent.children[childIndex]);
         }
 
         void borrowFromRightInternal(Node &parent, std::size_t childIndex) {
-            auto &right = nodes_.at(parent.children[childIndex + 1]);
-            auto &child = nodes_.at(parent.children[childIndex]);
+            auto &right = fetchNode(parent.children[childIndex + 1]);
+            auto &child = fetchNode(parent.children[childIndex]);
             child.keys.push_back(parent.keys[childIndex]);
-            parent.keys[childIndex] = right.keys.front();
+            parent.keys.set(childIndex, right.keys.front());
             child.children.push_back(right.children.front());
-            right.keys.erase(right.keys.begin());
+            right.keys.erase(0);
             right.children.erase(right.children.begin());
+            right.keys.compact();
+            markDirty(parent.id);
+            markDirty(parent.children[childIndex + 1]);
+            markDirty(parent.children[childIndex]);
         }
 
         void mergeInternal(std::size_t parentId, std::size_t leftIndex) {
-            auto &parent = nodes_.at(parentId);
+            auto &parent = fetchNode(parentId);
             if (leftIndex + 1 >= parent.children.size()) {
                 return;
             }
             const std::size_t leftId = parent.children[leftIndex];
             const std::size_t rightId = parent.children[leftIndex + 1];
-            auto &left = nodes_.at(leftId);
-            auto &right = nodes_.at(rightId);
+            auto &left = fetchNode(leftId);
+            auto &right = fetchNode(rightId);
             left.keys.push_back(parent.keys[leftIndex]);
-            left.keys.insert(left.keys.end(), right.keys.begin(), right.keys.end());
+            left.keys.append(right.keys, 0, right.keys.size());
             left.children.insert(left.children.end(), right.children.begin(), right.children.end());
-            parent.keys.erase(parent.keys.begin() + leftIndex);
+            left.keys.compact();
+            parent.keys.erase(leftIndex);
             parent.children.erase(parent.children.begin() + leftIndex + 1);
-            nodes_.erase(rightId);
+            markDirty(parentId);
+            markDirty(leftId);
+            releaseNode(rightId);
+        }
+
+        // Splits `count` sorted items into nodes greedily: an item joins the
+        // current node while the node stays within the fill-factor share of
+        // maxKeys_ entries or of the page, whichever admits more, so
+        // compressible keys pack denser. A short last node takes items back
+        // from the one before it, or merges into it when both fit one page,
+        // so that no node but a lone root starts underfull. Items of an
+        // internal level are children; the key of each but a node's first
+        // becomes a separator.
+        template <typename KeyAt, typename ValueBytesAt>
+        std::vector<std::size_t> planBulkNodes(std::size_t count,
+                                               bool internal,
+                                               const KeyAt &keyAt,
+                                               const ValueBytesAt &valueBytesAt) const {
+            const std::size_t skip = internal ? 1 : 0;
+            const bool byCount = internal || !duplicates_;
+            const auto countTarget = std::max<std::size_t>(
+                minKeys_,
+                static_cast<std::size_t>(static_cast<double>(maxKeys_) * bulkFillFactor_));
+            const auto byteTarget = kNodeHeaderBytes + static_cast<std::size_t>(
+                static_cast<double>(pageBudget_ - kNodeHeaderBytes) * bulkFillFactor_);
+            // Bytes of a node holding items [first, last).
+            const auto rangeBytes = [&](std::size_t first, std::size_t last) {
+                std::size_t keyBytes = 0;
+                std::size_t values = 0;
+                for (std::size_t i = first; i < last; ++i) {
+                    keyBytes += i >= first + skip ? keyAt(i).size() : 0;
+                    values += valueBytesAt(i);
+                }
+                const std::size_t keys = last - first - skip;
+                const std::size_t shared = keys > 1 ? sharedPrefixLength(keyAt(first + skip), keyAt(last - 1)) : 0;
+                return kNodeHeaderBytes + keySectionBytes(keys, keyBytes, shared) + values;
+            };
+
+            std::vector<std::size_t> sizes;
+            std::size_t first = 0;
+            while (first < count) {
+                std::size_t last = first + 1;
+                std::size_t keyBytes = internal ? 0 : keyAt(first).size();
+                std::size_t values = valueBytesAt(first);
+                for (; last < count; ++last) {
+                    const std::size_t keys = last + 1 - first - skip;
+                    const std::size_t shared = keys > 1 ? sharedPrefixLength(keyAt(first + skip), keyAt(last)) : 0;
+                    const std::size_t bytes = kNodeHeaderBytes +
+                                              keySectionBytes(keys, keyBytes + keyAt(last).size(), shared) +
+                                              values + valueBytesAt(last);
+                    if (!(byCount && keys <= countTarget) && bytes > byteTarget) {
+                        break;
+                    }
+                    keyBytes += keyAt(last).size();
+                    values += valueBytesAt(last);
+                }
+                sizes.push_back(last - first);
+                first = last;
+            }
+
+            const std::size_t minItems = minKeys_ + skip;
+            if (byCount && sizes.size() > 1 && sizes.back() < minItems) {
+                const std::size_t tail = sizes.back();
+                const std::size_t previous = sizes[sizes.size() - 2];
+                const std::size_t keys = previous + tail - skip;
+                if (keys <= maxKeys_ || rangeBytes(count - previous - tail, count) <= pageBudget_) {
+                    sizes.pop_back();
+                    sizes.back() += tail;
+                } else {
+                    sizes[sizes.size() - 2] -= minItems - tail;
+                    sizes.back() = minItems;
+                }
+            }
+            return sizes;
+        }
+
+        void buildFromSorted(const std::vector<std::pair<std::string, IndexPointer>> &sorted) {
+            const auto leafSizes = planBulkNodes(
+                sorted.size(), false,
+                [&](std::size_t i) -> const std::string & { return sorted[i].first; },
+                [](std::size_t) { return kPointerBytes; });
+            std::vector<std::pair<std::string, std::size_t>> level;
+            level.reserve(leafSizes.size());
+            std::size_t cursor = 0;
+            std::size_t leafId = createNode(true);
+            for (std::size_t i = 0; i < leafSizes.size(); ++i) {
+                auto &leaf = fetchNode(leafId);
+                leaf.keys.reserve(leafSizes[i]);
+                leaf.values.reserve(leafSizes[i]);
+                level.emplace_back(cursor == 0 ? sorted[cursor].first
+                                               : shortestSeparator(sorted[cursor - 1].first, sorted[cursor].first),
+                                   leafId);
+                for (std::size_t k = 0; k < leafSizes[i]; ++k, ++cursor) {
+                    leaf.keys.push_back(sorted[cursor].first);
+                    leaf.values.push_back(Posting{sorted[cursor].second});
+                }
+                leaf.keys.compact();
+                const std::size_t builtId = leafId;
+                if (i + 1 < leafSizes.size()) {
+                    leafId = createNode(true);
+                    auto &built = fetchNode(builtId);
+                    built.hasNext = true;
+                    built.nextLeaf = leafId;
+                }
+                flushNode(builtId);
+            }
+            buildInternalLevels(std::move(level));
+        }
+
+        // Groups the pointers of each key into a posting, spilling each one
+        // beyond inlineLimit_ pointers to overflow pages as it goes, then
+        // packs the postings into leaves by bytes.
+        void buildPostingsFromSorted(const std::vector<std::pair<std::string, IndexPointer>> &sorted) {
+            std::vector<std::pair<std::string, Posting>> postings;
+            std::size_t cursor = 0;
+            while (cursor < sorted.size()) {
+                const std::string &key = sorted[cursor].first;
+                Posting posting{sorted[cursor].second};
+                for (++cursor; cursor < sorted.size() && sorted[cursor].first == key; ++cursor) {
+                    appendToPosting(posting, sorted[cursor].second);
+                }
+                flushOverflowChain(posting);
+                postings.emplace_back(key, std::move(posting));
+            }
+            const auto leafSizes = planBulkNodes(
+                postings.size(), false,
+                [&](std::size_t i) -> const std::string & { return postings[i].first; },
+                [&](std::size_t i) { return postingBytes(postings[i].second); });
+            std::vector<std::pair<std::string, std::size_t>> level;
+            level.reserve(leafSizes.size());
+            cursor = 0;
+            std::size_t leafId = createNode(true);
+            for (std::size_t i = 0; i < leafSizes.size(); ++i) {
+                auto &leaf = fetchNode(leafId);
+                level.emplace_back(cursor == 0 ? postings[cursor].first
+                                               : shortestSeparator(postings[cursor - 1].first, postings[cursor].first),
+                                   leafId);
+                for (std::size_t k = 0; k < leafSizes[i]; ++k, ++cursor) {
+                    leaf.keys.push_back(postings[cursor].first);
+                    leaf.values.push_back(std::move(postings[cursor].second));
+                }
+                leaf.keys.compact();
+                const std::size_t builtId = leafId;
+                if (i + 1 < leafSizes.size()) {
+                    leafId = createNode(true);
+                    auto &built = fetchNode(builtId);
+                    built.hasNext = true;
+                    built.nextLeaf = leafId;
+                }
+                flushNode(builtId);
+            }
+            buildInternalLevels(std::move(level));
+        }
+
+        // Each entry of `level` is a child and the separator that precedes
+        // it; a node's first child passes its separator up instead.
+        void buildInternalLevels(std::vector<std::pair<std::string, std::size_t>> level) {
+            while (level.size() > 1) {
+                std::vector<std::pair<std::string, std::size_t>> parents;
+                const auto fanouts = planBulkNodes(
+                    level.size(), true,
+                    [&](std::size_t i) -> const std::string & { return level[i].first; },
+                    [](std::size_t) { return std::size_t{8}; });
+                parents.reserve(fanouts.size());
+                std::size_t child = 0;
+                for (auto fanout : fanouts) {
+                    const std::size_t nodeId = createNode(false);
+                    auto &node = fetchNode(nodeId);
+                    node.leaf = false;
+                    node.children.reserve(fanout);
+                    node.keys.reserve(fanout - 1);
+                    for (std::size_t c = 0; c < fanout; ++c, ++child) {
+                        if (c != 0) {
+                            node.keys.push_back(level[child].first);
+                        }
+                        node.children.push_back(level[child].second);
+                    }
+                    node.keys.compact();
+                    parents.emplace_back(level[child - fanout].first, nodeId);
+                    flushNode(nodeId);
+                }
+                level = std::move(parents);
+            }
+            rootId_ = level.front().second;
+            syncPages();
+        }
+
+        // Writes a finished node to its page right away so a paged bulk
+        // build never holds more than a couple of decoded nodes.
+        void flushNode(std::size_t nodeId) {
+            if (!store_) {
+                return;
+            }
+            store_->writePage(nodeId, encodeNode(fetchNode(nodeId)));
+            dirtyNodes_.erase(nodeId);
+            nodes_.erase(nodeId);
+            pagesDirty_ = true;
+        }
+
+        void markDirty(std::size_t nodeId) {
+            dirtyNodes_.insert(nodeId);
+        }
+
+        void releaseNode(std::size_t nodeId) {
+            nodes_.erase(nodeId);
+            dirtyNodes_.erase(nodeId);
+            freedNodes_.insert(nodeId);
+            if (store_) {
+                freePages_.push_back(nodeId);
+            }
+            if (nodeCount_ > 0) {
+                --nodeCount_;
+            }
+        }
+
+        std::size_t nodeCount() const {
+            return store_ ? nodeCount_ : nodes_.size();
+        }
+
+        Node &fetchNode(std::size_t nodeId) const {
+            auto it = nodes_.find(nodeId);
+            if (it != nodes_.end()) {
+                return it->second;
+            }
+            if (!store_) {
+                std::ostringstream oss;
+                oss << "index node #" << nodeId << " does not exist";
+                throw std::out_of_range(oss.str());
+            }
+            Node node = decodeNode(nodeId, store_->readPage(nodeId));
+            return nodes_.emplace(nodeId, std::move(node)).first->second;
+        }
+
+        // Decoded nodes of a paged tree only live for the duration of one
+        // operation; the buffer pool decides which pages stay resident.
+        void trimCache() const {
+            if (store_) {
+                nodes_.clear();
+            }
+        }
+
+        void syncPages() {
+            if (!store_) {
+                return;
+            }
+            if (!dirtyNodes_.empty() || !freedNodes_.empty()) {
+                pagesDirty_ = true;
+            }
+            std::vector<std::size_t> written(dirtyNodes_.begin(), dirtyNodes_.end());
+            std::sort(written.begin(), written.end());
+            for (auto nodeId : written) {
+                store_->writePage(nodeId, encodeNode(fetchNode(nodeId)));
+            }
+            dirtyNodes_.clear();
+            freedNodes_.clear();
+            trimCache();
+        }
+
+        std::vector<std::size_t> collectNodeIds() const {
+            std::vector<std::size_t> ids;
+            if (!store_) {
+                ids.reserve(nodes_.size());
+                for (const auto &entry : nodes_) {
+                    ids.push_back(entry.first);
+                }
+            } else if (rootId_ != kInvalidNode) {
+                std::queue<std::size_t> pending;
+                pending.push(rootId_);
+                while (!pending.empty()) {
+                    const std::size_t nodeId = pending.front();
+                    pending.pop();
+                    ids.push_back(nodeId);
+                    const auto &node = fetchNode(nodeId);
+                    for (auto childId : node.children) {
+                        pending.push(childId);
+                    }
+                    for (const auto &posting : node.values) {
+                        for (std::size_t pageId = posting.overflow; pageId != kInvalidNode;) {
+                            ids.push_back(pageId);
+                            const auto &page = fetchNode(pageId);
+                            pageId = page.hasNext ? page.nextLeaf : kInvalidNode;
+                        }
+                    }
+                }
+            }
+            std::sort(ids.begin(), ids.end());
+            return ids;
+        }
+
+        static void replaceFile(const std::string &tempPath, const std::string &path) {
+            if (std::rename(tempPath.c_str(), path.c_str()) != 0) {
+                std::remove(path.c_str());
+                if (std::rename(tempPath.c_str(), path.c_str()) != 0) {
+                    std::ostringstream oss;
+                    oss << "failed to replace index file: " << path;
+                    throw std::runtime_error(oss.str());
+                }
+            }
+        }
+
+        void writePagedMeta(const std::string &path, bool clean) const {
+            pathutil::ensureParentDirectory(path);
+            const std::string tempPath = path + ".tmp";
+            {
+                std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+                out << (duplicates_ ? "IDXTREE V5\n" : "IDXTREE V3\n");
+                out << "PAGE_SIZE " << pageSize_ << "\n";
+                out << "KEY_LENGTH " << keyLength_ << "\n";
+                out << "ROOT " << serializeNodeId(rootId_) << "\n";
+                out << "NODE_COUNT " << nodeCount_ << "\n";
+                out << "CLEAN " << (clean ? 1 : 0) << "\n";
+                out << "FREE " << freePages_.size() << "\n";
+                for (auto pageId : freePages_) {
+                    out << pageId << "\n";
+                }
+                if (!out) {
+                    std::ostringstream oss;
+                    oss << "failed to persist index file: " << path;
+                    throw std::runtime_error(oss.str());
+                }
+            }
+            replaceFile(tempPath, path);
+        }
+
+        template <typename ReadLine>
+        void loadPagedMeta(const std::string &path,
+                           ReadLine &readLine,
+                           std::size_t expectedPageSize,
+                           std::size_t expectedKeyLength) {
+            const auto rootValue = parseSignedHeaderValue(readLine("root"), "ROOT");
+            const auto nodeCount = parseHeaderValue(readLine("node count"), "NODE_COUNT");
+            const auto clean = parseHeaderValue(readLine("clean flag"), "CLEAN");
+            const auto freeCount = parseHeaderValue(readLine("free list"), "FREE");
+            if (clean == 0) {
+                std::ostringstream oss;
+                oss << "index file " << path << " was not checkpointed";
+                throw std::runtime_error(oss.str());
+            }
+            initialize(expectedPageSize, expectedKeyLength);
+            freePages_.clear();
+            freePages_.reserve(freeCount);
+            for (std::size_t idx = 0; idx < freeCount; ++idx) {
+                freePages_.push_back(
+                    static_cast<std::size_t>(std::stoull(readLine("free page"))));
+            }
+            rootId_ = rootValue < 0 ? kInvalidNode : static_cast<std::size_t>(rootValue);
+            nodeCount_ = nodeCount;
+            snapshotRequired_ = false;
+            pagesDirty_ = false;
+            metaClean_ = true;
+        }
+
+        static void appendUint(std::string &out, std::uint64_t value, std::size_t bytes) {
+            for (std::size_t i = 0; i < bytes; ++i) {
+                out.push_back(static_cast<char>((value >> (8U * i)) & 0xFFU));
+            }
+        }
+
+        static std::uint64_t readUint(const std::string &in,
+                                      std::size_t &pos,
+                                      std::size_t bytes,
+                                      std::size_t nodeId) {
+            if (pos + bytes > in.size()) {
+                std::ostringstream oss;
+                oss << "corrupted index page #" << nodeId;
+                throw std::runtime_error(oss.str());
+            }
+            std::uint64_t value = 0;
+            for (std::size_t i = 0; i < bytes; ++i) {
+                value |= static_cast<std::uint64_t>(static_cast<unsigned char>(in[pos + i]))
+                         << (8U * i);
+            }
+            pos += bytes;
+            return value;
+        }
+
+        // Page layout: kind(1) hasNext(1) nextLeaf(8) count(2), where kind is
+        // 0 internal, 1 leaf, 2 leaf with posting lists, 3 overflow page. Then
+        // each key as length(2)+bytes, then per key block(8)+slot(4) for
+        // leaves, or keyCount+1 child ids(8) for internal nodes. A posting
+        // is its inline pointer count(2), with the top bit set when an
+        // overflow page(8) and overflow count(4) follow the pointers. An
+        // overflow page holds `count` pointers and no keys.
+        std::string encodeNode(const Node &node) const {
+            std::string out;
+            out.reserve(12 + node.keys.size() * (keyLength_ + 14) + 8);
+            std::uint64_t kind = 0;
+            if (node.overflow) {
+                kind = 3;
+            } else if (node.leaf) {
+                kind = duplicates_ ? 2 : 1;
+            }
+            const std::size_t prefix = node.overflow ? 0 : node.keys.commonPrefixLength();
+            const bool prefixed = prefixPays(node.keys.size(), prefix);
+            appendUint(out, kind | (prefixed ? kPrefixedKeys : 0U), 1);
+            appendUint(out, node.hasNext ? 1 : 0, 1);
+            appendUint(out, node.nextLeaf == kInvalidNode
+                                ? std::numeric_limits<std::uint64_t>::max()
+                                : static_cast<std::uint64_t>(node.nextLeaf),
+                       8);
+            if (node.overflow) {
+                appendUint(out, node.pointers.size(), 2);
+                for (const auto &ptr : node.pointers) {
+                    appendPointer(out, ptr);
+                }
+                return out;
+            }
+            appendUint(out, node.keys.size(), 2);
+            if (prefixed) {
+                appendUint(out, prefix, 2);
+                out.append(node.keys.front(), 0, prefix);
+            }
+            const std::size_t from = prefixed ? prefix : 0;
+            for (std::size_t k = 0; k < node.keys.size(); ++k) {
+                appendUint(out, node.keys.keySize(k) - from, 2);
+                node.keys.appendKey(out, k, from);
+            }
+            if (kind == 2) {
+                for (const auto &posting : node.values) {
+                    const bool spilled = posting.overflow != kInvalidNode;
+                    appendUint(out, (1 + posting.more.size()) | (spilled ? 0x8000U : 0U), 2);
+                    appendPointer(out, posting.head);
+                    for (const auto &ptr : posting.more) {
+                        appendPointer(out, ptr);
+                    }
+                    if (spilled) {
+                        appendUint(out, posting.overflow, 8);
+                        appendUint(out, posting.overflowCount, 4);
+                    }
+                }
+            } else if (node.leaf) {
+                for (const auto &value : node.values) {
+                    appendPointer(out, value.head);
+                }
+            } else {
+                for (auto childId : node.children) {
+                    appendUint(out, childId, 8);
+                }
+            }
+            return out;
+        }
+
+        Node decodeNode(std::size_t nodeId, const std::string &page) const {
+            Node node;
+            node.id = nodeId;
+            node.keys = NodeKeys(keyLength_);
+            std::size_t pos = 0;
+            const auto flags = readUint(page, pos, 1, nodeId);
+            const auto kind = flags & ~static_cast<std::uint64_t>(kPrefixedKeys);
+            node.leaf = kind == 1 || kind == 2;
+            node.overflow = kind == 3;
+            node.hasNext = readUint(page, pos, 1, nodeId) != 0;
+            const std::uint64_t nextLeaf = readUint(page, pos, 8, nodeId);
+            node.nextLeaf = nextLeaf == std::numeric_limits<std::uint64_t>::max()
+                                ? kInvalidNode
+                                : static_cast<std::size_t>(nextLeaf);
+            const auto keyCount = static_cast<std::size_t>(readUint(page, pos, 2, nodeId));
+            if (node.overflow) {
+                node.pointers.reserve(keyCount);
+                for (std::size_t p = 0; p < keyCount; ++p) {
+                    node.pointers.push_back(readPointer(page, pos, nodeId));
+                }
+                return node;
+            }
+            const auto readBytes = [&]() {
+                const auto length = static_cast<std::size_t>(readUint(page, pos, 2, nodeId));
+                if (pos + length > page.size()) {
+                    std::ostringstream oss;
+                    oss << "corrupted index page #" << nodeId;
+                    throw std::runtime_error(oss.str());
+                }
+                pos += length;
+                return page.substr(pos - length, length);
+            };
+            const std::string prefix = (flags & kPrefixedKeys) != 0 ? readBytes() : std::string();
+            node.keys.reserve(keyCount);
+            for (std::size_t k = 0; k < keyCount; ++k) {
+                node.keys.push_back(prefix + readBytes());
+            }
+            node.keys.compact();
+            if (kind == 2) {
+                node.values.reserve(keyCount);
+                for (std::size_t v = 0; v < keyCount; ++v) {
+                    const auto header = readUint(page, pos, 2, nodeId);
+                    const auto inlineCount = static_cast<std::size_t>(header & 0x7FFFU);
+                    if (inlineCount == 0) {
+                        std::ostringstream oss;
+                        oss << "corrupted index page #" << nodeId;
+                        throw std::runtime_error(oss.str());
+                    }
+                    Posting posting{readPointer(page, pos, nodeId)};
+                    posting.more.reserve(inlineCount - 1);
+                    for (std::size_t p = 1; p < inlineCount; ++p) {
+                        posting.more.push_back(readPointer(page, pos, nodeId));
+                    }
+                    if ((header & 0x8000U) != 0) {
+                        posting.overflow = static_cast<std::size_t>(readUint(page, pos, 8, nodeId));
+                        posting.overflowCount =
+                            static_cast<std::size_t>(readUint(page, pos, 4, nodeId));
+                    }
+                    node.values.push_back(std::move(posting));
+                }
+            } else if (node.leaf) {
+                node.values.reserve(keyCount);
+                for (std::size_t v = 0; v < keyCount; ++v) {
+                    node.values.push_back(Posting{readPointer(page, pos, nodeId)});
+                }
+            } else {
+                node.children.reserve(keyCount + 1);
+                for (std::size_t c = 0; c <= keyCount; ++c) {
+                    node.children.push_back(static_cast<std::size_t>(readUint(page, pos, 8, nodeId)));
+                }
+            }
+            return node;
+        }
+
+        static void appendPointer(std::string &out, const IndexPointer &ptr) {
+            appendUint(out, ptr.address.index, 8);
+            appendUint(out, ptr.slot, 4);
+        }
+
+        IndexPointer readPointer(const std::string &page, std::size_t &pos, std::size_t nodeId) const {
+            IndexPointer ptr;
+            ptr.address.table = pointerTable_;
+            ptr.address.index = static_cast<std::size_t>(readUint(page, pos, 8, nodeId));
+            ptr.slot = static_cast<std::size_t>(readUint(page, pos, 4, nodeId));
+            return ptr;
+        }
+
+        static std::size_t computePagedMaxKeys(std::size_t capacity, std::size_t keyBytes) {
+            constexpr std::size_t headerBytes = 12 + 8;
+            const std::size_t perEntry = keyBytes + 2 + 8 + 4;
+            if (capacity <= headerBytes) {
+                return 0;
+            }
+            return (capacity - headerBytes) / perEntry;
+        }
+
+        std::size_t compactionThreshold() const {
+            return std::max<std::size_t>(64, nodes_.size());
+        }
+
+        // Leaves whose keys all have a single pointer keep the VALUES form;
+        // otherwise each posting is written as "inline overflow count" and
+        // its inline pointers. Overflow pages use node kind 2.
+        static void writeNode(std::ostream &out, const Node &node) {
+            out << "NODE " << node.id << " " << (node.overflow ? 2 : (node.leaf ? 1 : 0)) << " "
+                << (node.hasNext ? 1 : 0) << " "
+                << serializeNodeId(node.nextLeaf) << "\n";
+            out << "KEYS " << node.keys.size() << "\n";
+            for (std::size_t k = 0; k < node.keys.size(); ++k) {
+                out << encodeHex(node.keys[k]) << "\n";
+            }
+            if (node.overflow) {
+                out << "VALUES " << node.pointers.size() << "\n";
+                for (const auto &ptr : node.pointers) {
+                    writePointer(out, ptr);
+                }
+            } else if (node.leaf) {
+                const bool single = std::all_of(node.values.begin(), node.values.end(),
+                                                [](const Posting &posting) {
+                                                    return posting.size() == 1;
+                                                });
+                if (single) {
+                    out << "VALUES " << node.values.size() << "\n";
+                    for (const auto &value : node.values) {
+                        writePointer(out, value.head);
+                    }
+                    return;
+                }
+                out << "POSTINGS " << node.values.size() << "\n";
+                for (const auto &posting : node.values) {
+                    out << 1 + posting.more.size() << " " << serializeNodeId(posting.overflow)
+                        << " " << posting.overflowCount << "\n";
+                    writePointer(out, posting.head);
+                    for (const auto &ptr : posting.more) {
+                        writePointer(out, ptr);
+                    }
+                }
+            } else {
+                out << "CHILDREN " << node.children.size() << "\n";
+                for (auto childId : node.children) {
+                    out << childId << "\n";
+                }
+            }
+        }
+
+        template <typename ReadLine>
+        static Node readNode(ReadLine &readLine) {
+            Node node;
+            const auto nodeDesc = readLine("node descriptor");
+            std::stringstream nodeStream(nodeDesc);
+            std::string tag;
+            int leafFlag{0};
+            int nextFlag{0};
+            long long nextLeafRaw{0};
+            nodeStream >> tag >> node.id >> leafFlag >> nextFlag >> nextLeafRaw;
+            if (tag != "NODE") {
+                throw std::runtime_error("corrupted index node descriptor");
+            }
+            node.leaf = leafFlag == 1;
+            node.overflow = leafFlag == 2;
+            node.hasNext = nextFlag != 0;
+            node.nextLeaf = nextLeafRaw < 0 ? kInvalidNode
+                                            : static_cast<std::size_t>(nextLeafRaw);
+            const auto keysHeader = readLine("keys header");
+            std::stringstream keyStream(keysHeader);
+            std::string keysTag;
+            std::size_t keyCount{0};
+            keyStream >> keysTag >> keyCount;
+            if (keysTag != "KEYS") {
+                throw std::runtime_error("corrupted index keys header");
+            }
+            node.keys.reserve(keyCount);
+            for (std::size_t k = 0; k < keyCount; ++k) {
+                node.keys.push_back(decodeHex(readLine("key entry")));
+            }
+            node.keys.compact();
+            if (node.leaf || node.overflow) {
+                const auto valuesHeader = readLine("values header");
+                std::stringstream valueStream(valuesHeader);
+                std::string valuesTag;
+                std::size_t valueCount{0};
+                valueStream >> valuesTag >> valueCount;
+                if (valuesTag == "POSTINGS" && node.leaf) {
+                    node.values.reserve(valueCount);
+                    for (std::size_t v = 0; v < valueCount; ++v) {
+                        std::stringstream ps(readLine("posting entry"));
+                        std::size_t inlineCount{0};
+                        long long overflowRaw{0};
+                        std::size_t overflowCount{0};
+                        if (!(ps >> inlineCount >> overflowRaw >> overflowCount) ||
+                            inlineCount == 0) {
+                            throw std::runtime_error("corrupted index posting entry");
+                        }
+                        Posting posting{readPointer(readLine)};
+                        for (std::size_t p = 1; p < inlineCount; ++p) {
+                            posting.more.push_back(readPointer(readLine));
+                        }
+                        posting.overflow = overflowRaw < 0 ? kInvalidNode
+                                                           : static_cast<std::size_t>(overflowRaw);
+                        posting.overflowCount = overflowCount;
+                        node.values.push_back(std::move(posting));
+                    }
+                    return node;
+                }
+                if (valuesTag != "VALUES") {
+                    throw std::runtime_error("corrupted index values header");
+                }
+                for (std::size_t v = 0; v < valueCount; ++v) {
+                    if (node.overflow) {
+                        node.pointers.push_back(readPointer(readLine));
+                    } else {
+                        node.values.push_back(Posting{readPointer(readLine)});
+                    }
+                }
+            } else {
+                const auto childrenHeader = readLine("children header");
+                std::stringstream childStream(childrenHeader);
+                std::string childTag;
+                std::size_t childCount{0};
+                childStream >> childTag >> childCount;
+                if (childTag != "CHILDREN") {
+                    throw std::runtime_error("corrupted child header");
+                }
+                node.children.reserve(childCount);
+                for (std::size_t c = 0; c < childCount; ++c) {
+                    const auto childLine = readLine("child entry");
+                    node.children.push_back(
+                        static_cast<std::size_t>(std::stoull(childLine)));
+                }
+            }
+            return node;
+        }
+
+        static void writePointer(std::ostream &out, const IndexPointer &ptr) {
+            out << encodeHex(ptr.address.table) << " " << ptr.address.index << " " << ptr.slot
+                << "\n";
+        }
+
+        template <typename ReadLine>
+        static IndexPointer readPointer(ReadLine &readLine) {
+            std::stringstream vs(readLine("value entry"));
+            std::string tableHex;
+            std::size_t blockIdx{0};
+            std::size_t slotIdx{0};
+            if (!(vs >> tableHex >> blockIdx >> slotIdx)) {
+                throw std::runtime_error("corrupted index pointer entry");
+            }
+            IndexPointer ptr;
+            ptr.address.table = decodeHex(tableHex);
+            ptr.address.index = blockIdx;
+            ptr.slot = slotIdx;
+            return ptr;
+        }
+
+        // Applies the committed batches of the delta log on top of the
+        // snapshot that was just loaded. A log written for another generation
+        // is stale and ignored; a batch without its COMMIT line is a torn
+        // write and ends the replay, forcing the next persist to snapshot.
+        void replayDeltaLog(const std::string &logPath) {
+            logCurrent_ = false;
+            loggedNodeWrites_ = 0;
+            std::ifstream in(logPath, std::ios::binary);
+            if (!in) {
+                return;
+            }
+            auto readLine = [&](const char *context) {
+                std::string line;
+                if (!std::getline(in, line)) {
+                    std::ostringstream oss;
+                    oss << "truncated index delta log '" << logPath << "' missing " << context;
+                    throw std::runtime_error(oss.str());
+                }
+                if (!line.empty() && line.back() == '\r') {
+                    line.pop_back();
+                }
+                return line;
+            };
+            std::string header;
+            if (!std::getline(in, header)) {
+                return;
+            }
+            if (!header.empty() && header.back() == '\r') {
+                header.pop_back();
+            }
+            std::stringstream headerStream(header);
+            std::string magic;
+            std::string version;
+            std::string tag;
+            std::size_t logGeneration{0};
+            if (!(headerStream >> magic >> version >> tag >> logGeneration) ||
+                magic != "IDXLOG" || version != "V1" || tag != "GENERATION" ||
+                logGeneration != generation_) {
+                return;
+            }
+            logCurrent_ = true;
+            std::string batchLine;
+            while (std::getline(in, batchLine)) {
+                if (!batchLine.empty() && batchLine.back() == '\r') {
+                    batchLine.pop_back();
+                }
+                if (batchLine.empty()) {
+                    continue;
+                }
+                try {
+                    std::stringstream batchStream(batchLine);
+                    std::string batchTag;
+                    std::string rootTag;
+                    std::string nextTag;
+                    std::string nodesTag;
+                    std::string freedTag;
+                    long long rootValue{0};
+                    std::size_t nextValue{0};
+                    std::size_t nodeCount{0};
+                    std::size_t freedCount{0};
+                    if (!(batchStream >> batchTag >> rootTag >> rootValue >> nextTag >> nextValue >>
+                          nodesTag >> nodeCount >> freedTag >> freedCount) ||
+                        batchTag != "BATCH") {
+                        throw std::runtime_error("corrupted index delta batch header");
+                    }
+                    std::vector<Node> batchNodes;
+                    batchNodes.reserve(nodeCount);
+                    for (std::size_t idx = 0; idx < nodeCount; ++idx) {
+                        batchNodes.push_back(readNode(readLine));
+                    }
+                    std::vector<std::size_t> freed;
+                    freed.reserve(freedCount);
+                    for (std::size_t idx = 0; idx < freedCount; ++idx) {
+                        std::stringstream freeStream(readLine("free entry"));
+                        std::string freeTag;
+                        std::size_t nodeId{0};
+                        if (!(freeStream >> freeTag >> nodeId) || freeTag != "FREE") {
+                            throw std::runtime_error("corrupted index delta free entry");
+                        }
+                        freed.push_back(nodeId);
+                    }
+                    if (readLine("commit marker") != "COMMIT") {
+                        throw std::runtime_error("corrupted index delta commit marker");
+                    }
+                    for (auto &node : batchNodes) {
+                        const std::size_t nodeId = node.id;
+                        nodes_[nodeId] = std::move(node);
+                    }
+                    for (auto nodeId : freed) {
+                        nodes_.erase(nodeId);
+                    }
+                    rootId_ = rootValue < 0 ? kInvalidNode : static_cast<std::size_t>(rootValue);
+                    nextNodeId_ = nextValue;
+                    loggedNodeWrites_ += nodeCount + freedCount;
+                } catch (const std::exception &) {
+                    snapshotRequired_ = true;
+                    return;
+                }
+            }
         }
 
         static std::size_t computeMaxKeys(std::size_t pageSizeBytes, std::size_t keyBytes) {
@@ -697,6 +2413,20 @@ private:
         return oss.str();
     }
 
+    static std::string describePosting(const Posting &posting) {
+        std::string text = pointerToString(posting.head);
+        if (posting.size() > 1) {
+            std::ostringstream oss;
+            oss << " (+" << posting.size() - 1;
+            if (posting.overflow != kInvalidNode) {
+                oss << ", overflow -> #" << posting.overflow;
+            }
+            oss << ")";
+            text += oss.str();
+        }
+        return text;
+    }
+
     static std::string encodeHex(const std::string &input) {
         static constexpr char kDigits[] = "0123456789ABCDEF";
         std::string output;
@@ -768,13 +2498,31 @@ private:
         return value;
     }
 
-    std::unordered_map<std::size_t, Node> nodes_;
+    mutable std::unordered_map<std::size_t, Node> nodes_;
     std::size_t rootId_{kInvalidNode};
     std::size_t nextNodeId_{1};
     std::size_t maxKeys_{0};
         std::size_t minKeys_{0};
         std::size_t pageSize_{0};
         std::size_t keyLength_{0};
+        std::unordered_set<std::size_t> dirtyNodes_;
+        std::unordered_set<std::size_t> freedNodes_;
+        bool snapshotRequired_{true};
+        bool logCurrent_{false};
+        std::size_t loggedNodeWrites_{0};
+        std::size_t generation_{0};
+        IndexPageStore *store_{nullptr};
+        std::string pointerTable_;
+        std::vector<std::size_t> freePages_;
+        std::size_t nodeCount_{0};
+        bool pagesDirty_{false};
+        bool metaClean_{true};
+        double bulkFillFactor_{1.0};
+        bool duplicates_{false};
+        std::size_t pageBudget_{0};
+        std::size_t inlineLimit_{1};
+        std::size_t overflowCapacity_{0};
+        std::unique_ptr<Latches> latches_;
     };
 
 
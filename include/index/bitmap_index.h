@@ -0,0 +1,955 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <optional>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "common/types.h"
+#include "common/utils.h"
+#include "index/b_plus_tree.h"
+
+namespace dbms {
+
+// Set of row positions in one table, laid out like a roaring bitmap: the
+// block number selects a container and the slot is the 16-bit value stored
+// in it. A container is a sorted slot array while it holds at most
+// kArrayLimit slots and a 65536-bit bitmap beyond that, so sparse blocks
+// cost two bytes per row and AND/OR work container by container, skipping
+// blocks present on one side only.
+class RowBitmap {
+public:
+    static constexpr std::size_t kArrayLimit = 4096;
+    static constexpr std::size_t kMaxSlot = 0xFFFF;
+
+    bool empty() const {
+        return blocks_.empty();
+    }
+
+    // Number of blocks holding at least one row.
+    std::size_t blockCount() const {
+        return blocks_.size();
+    }
+
+    std::size_t cardinality() const {
+        std::size_t total = 0;
+        for (const auto &container : containers_) {
+            total += container.count;
+        }
+        return total;
+    }
+
+    // Bytes the containers occupy.
+    std::size_t sizeInBytes() const {
+        std::size_t bytes = 0;
+        for (const auto &container : containers_) {
+            bytes += sizeof(std::size_t) + (container.dense() ? container.words.size() * sizeof(std::uint64_t)
+                                                              : container.slots.size() * sizeof(std::uint16_t));
+        }
+        return bytes;
+    }
+
+    bool add(std::size_t block, std::size_t slot) {
+        const auto value = checkedSlot(slot);
+        auto it = std::lower_bound(blocks_.begin(), blocks_.end(), block);
+        const auto at = static_cast<std::size_t>(std::distance(blocks_.begin(), it));
+        if (it == blocks_.end() || *it != block) {
+            blocks_.insert(it, block);
+            containers_.insert(containers_.begin() + static_cast<std::ptrdiff_t>(at), Container{});
+        }
+        return containers_[at].add(value);
+    }
+
+    bool remove(std::size_t block, std::size_t slot) {
+        if (slot > kMaxSlot) {
+            return false;
+        }
+        auto it = std::lower_bound(blocks_.begin(), blocks_.end(), block);
+        if (it == blocks_.end() || *it != block) {
+            return false;
+        }
+        const auto at = static_cast<std::size_t>(std::distance(blocks_.begin(), it));
+        if (!containers_[at].remove(static_cast<std::uint16_t>(slot))) {
+            return false;
+        }
+        if (containers_[at].count == 0) {
+            blocks_.erase(it);
+            containers_.erase(containers_.begin() + static_cast<std::ptrdiff_t>(at));
+        }
+        return true;
+    }
+
+    bool contains(std::size_t block, std::size_t slot) const {
+        if (slot > kMaxSlot) {
+            return false;
+        }
+        auto it = std::lower_bound(blocks_.begin(), blocks_.end(), block);
+        return it != blocks_.end() && *it == block &&
+               containers_[static_cast<std::size_t>(std::distance(blocks_.begin(), it))].contains(
+                   static_cast<std::uint16_t>(slot));
+    }
+
+    static RowBitmap intersect(const RowBitmap &a, const RowBitmap &b) {
+        RowBitmap result;
+        std::size_t i = 0;
+        std::size_t j = 0;
+        while (i < a.blocks_.size() && j < b.blocks_.size()) {
+            if (a.blocks_[i] < b.blocks_[j]) {
+                ++i;
+            } else if (b.blocks_[j] < a.blocks_[i]) {
+                ++j;
+            } else {
+                Container both = Container::intersect(a.containers_[i], b.containers_[j]);
+                if (both.count != 0) {
+                    result.blocks_.push_back(a.blocks_[i]);
+                    result.containers_.push_back(std::move(both));
+                }
+                ++i;
+                ++j;
+            }
+        }
+        return result;
+    }
+
+    static RowBitmap unite(const RowBitmap &a, const RowBitmap &b) {
+        RowBitmap result;
+        std::size_t i = 0;
+        std::size_t j = 0;
+        while (i < a.blocks_.size() || j < b.blocks_.size()) {
+            if (j == b.blocks_.size() || (i < a.blocks_.size() && a.blocks_[i] < b.blocks_[j])) {
+                result.blocks_.push_back(a.blocks_[i]);
+                result.containers_.push_back(a.containers_[i++]);
+            } else if (i == a.blocks_.size() || b.blocks_[j] < a.blocks_[i]) {
+                result.blocks_.push_back(b.blocks_[j]);
+                result.containers_.push_back(b.containers_[j++]);
+            } else {
+                result.blocks_.push_back(a.blocks_[i]);
+                result.containers_.push_back(Container::unite(a.containers_[i++], b.containers_[j++]));
+            }
+        }
+        return result;
+    }
+
+    // Calls visit(block, slots) for every block in ascending order with its
+    // slots ascending.
+    template <typename Visit>
+    void forEachBlock(Visit visit) const {
+        for (std::size_t i = 0; i < blocks_.size(); ++i) {
+            visit(blocks_[i], containers_[i].values());
+        }
+    }
+
+private:
+    struct Container {
+        std::vector<std::uint16_t> slots;  // sorted, while sparse
+        std::vector<std::uint64_t> words;  // one bit per slot, once dense
+        std::size_t count{0};
+
+        bool dense() const {
+            return !words.empty();
+        }
+
+        bool contains(std::uint16_t slot) const {
+            if (dense()) {
+                return (words[slot >> 6] >> (slot & 63U)) & 1U;
+            }
+            return std::binary_search(slots.begin(), slots.end(), slot);
+        }
+
+        bool add(std::uint16_t slot) {
+            if (dense()) {
+                auto &word = words[slot >> 6];
+                const std::uint64_t bit = std::uint64_t{1} << (slot & 63U);
+                if (word & bit) {
+                    return false;
+                }
+                word |= bit;
+                ++count;
+                return true;
+            }
+            auto it = std::lower_bound(slots.begin(), slots.end(), slot);
+            if (it != slots.end() && *it == slot) {
+                return false;
+            }
+            slots.insert(it, slot);
+            ++count;
+            if (count > kArrayLimit) {
+                toBitmap();
+            }
+            return true;
+        }
+
+        bool remove(std::uint16_t slot) {
+            if (dense()) {
+                auto &word = words[slot >> 6];
+                const std::uint64_t bit = std::uint64_t{1} << (slot & 63U);
+                if (!(word & bit)) {
+                    return false;
+                }
+                word &= ~bit;
+                --count;
+                if (count <= kArrayLimit) {
+                    toArray();
+                }
+                return true;
+            }
+            auto it = std::lower_bound(slots.begin(), slots.end(), slot);
+            if (it == slots.end() || *it != slot) {
+                return false;
+            }
+            slots.erase(it);
+            --count;
+            return true;
+        }
+
+        std::vector<std::uint16_t> values() const {
+            if (!dense()) {
+                return slots;
+            }
+            std::vector<std::uint16_t> out;
+            out.reserve(count);
+            for (std::size_t w = 0; w < words.size(); ++w) {
+                for (std::uint64_t bits = words[w]; bits != 0; bits &= bits - 1) {
+                    out.push_back(static_cast<std::uint16_t>(w * 64 + static_cast<std::size_t>(__builtin_ctzll(bits))));
+                }
+            }
+            return out;
+        }
+
+        void toBitmap() {
+            words.assign((kMaxSlot + 1) / 64, 0);
+            for (auto slot : slots) {
+                words[slot >> 6] |= std::uint64_t{1} << (slot & 63U);
+            }
+            slots.clear();
+            slots.shrink_to_fit();
+        }
+
+        void toArray() {
+            slots = values();
+            words.clear();
+            words.shrink_to_fit();
+        }
+
+        // Recounts a bitmap container and drops back to an array if small.
+        void normalize() {
+            if (!dense()) {
+                count = slots.size();
+                return;
+            }
+            count = 0;
+            for (auto word : words) {
+                count += static_cast<std::size_t>(__builtin_popcountll(word));
+            }
+            if (count <= kArrayLimit) {
+                toArray();
+            }
+        }
+
+        static Container intersect(const Container &a, const Container &b) {
+            Container result;
+            if (a.dense() && b.dense()) {
+                result.words.resize(a.words.size());
+                for (std::size_t w = 0; w < a.words.size(); ++w) {
+                    result.words[w] = a.words[w] & b.words[w];
+                }
+            } else if (a.dense() || b.dense()) {
+                const Container &sparse = a.dense() ? b : a;
+                const Container &full = a.dense() ? a : b;
+                for (auto slot : sparse.slots) {
+                    if (full.contains(slot)) {
+                        result.slots.push_back(slot);
+                    }
+                }
+            } else {
+                std::set_intersection(a.slots.begin(), a.slots.end(), b.slots.begin(), b.slots.end(),
+                                      std::back_inserter(result.slots));
+            }
+            result.normalize();
+            return result;
+        }
+
+        static Container unite(const Container &a, const Container &b) {
+            Container result;
+            if (!a.dense() && !b.dense()) {
+                std::set_union(a.slots.begin(), a.slots.end(), b.slots.begin(), b.slots.end(),
+                               std::back_inserter(result.slots));
+                result.count = result.slots.size();
+                if (result.count > kArrayLimit) {
+                    result.toBitmap();
+                }
+                return result;
+            }
+            result.words.assign((kMaxSlot + 1) / 64, 0);
+            for (const Container *side : {&a, &b}) {
+                if (side->dense()) {
+                    for (std::size_t w = 0; w < side->words.size(); ++w) {
+                        result.words[w] |= side->words[w];
+                    }
+                } else {
+                    for (auto slot : side->slots) {
+                        result.words[slot >> 6] |= std::uint64_t{1} << (slot & 63U);
+                    }
+                }
+            }
+            result.normalize();
+            return result;
+        }
+    };
+
+    static std::uint16_t checkedSlot(std::size_t slot) {
+        if (slot > kMaxSlot) {
+            throw std::out_of_range("slot " + std::to_string(slot) + " does not fit a bitmap container");
+        }
+        return static_cast<std::uint16_t>(slot);
+    }
+
+    std::vector<std::size_t> blocks_;
+    std::vector<Container> containers_;
+};
+
+// Bitmap index: one RowBitmap per distinct key, for columns with few
+// distinct values where a B+ tree would store long posting lists. Lookups
+// return the bitmap itself so that predicates on several bitmap-indexed
+// columns combine with RowBitmap::intersect/unite before any block is read.
+//
+// The containers of a key are stored on pages, each holding the containers
+// of a run of consecutive blocks, so they go through an IndexPageStore like
+// the nodes of a paged BPlusTree and count against the same buffer pool.
+// Only the run directory, one entry per page, stays in memory. An index
+// without a store keeps its pages in memory and saves them with its meta
+// file.
+class BitmapIndex {
+public:
+    BitmapIndex() = default;
+
+    // Empties the index. Pages are only written once something is inserted.
+    void initialize(std::size_t pageSizeBytes, std::size_t keyBytes) {
+        configure(pageSizeBytes, keyBytes);
+        clear();
+    }
+
+    // Table the returned pointers refer to.
+    void setPointerTable(std::string table) {
+        pointerTable_ = std::move(table);
+    }
+
+    // Moves the index onto the pages of `store`, dropping its contents.
+    void attachPageStore(IndexPageStore *store) {
+        store_ = store;
+        initialize(pageSize_, keyLength_);
+    }
+
+    // Drops every value. All pages the store owns become free for reuse.
+    void clear() {
+        values_.clear();
+        usedPages_ = 0;
+        freePages_.clear();
+        if (store_) {
+            freePages_ = store_->pageIds();
+            std::reverse(freePages_.begin(), freePages_.end());
+        } else {
+            localStore_ = std::make_unique<LocalPageStore>(pageSize_);
+        }
+        changed_ = true;
+    }
+
+    std::size_t pageSizeBytes() const {
+        return pageSize_;
+    }
+
+    // Row positions of one block a single page can hold.
+    std::size_t entriesPerPage() const {
+        return (capacity_ - kPageHeaderBytes - kContainerHeaderBytes) / sizeof(std::uint16_t);
+    }
+
+    std::size_t pageCount() const {
+        return usedPages_;
+    }
+
+    std::size_t distinctValues() const {
+        return values_.size();
+    }
+
+    std::size_t size() const {
+        std::size_t total = 0;
+        for (const auto &entry : values_) {
+            for (const auto &run : entry.second) {
+                total += run.rows;
+            }
+        }
+        return total;
+    }
+
+    // Bytes of the run directory, the part of the index held in memory.
+    std::size_t residentBytes() const {
+        std::size_t bytes = 0;
+        for (const auto &entry : values_) {
+            bytes += entry.first.size() + entry.second.size() * sizeof(Run);
+        }
+        return bytes;
+    }
+
+    void bulkInsert(const std::vector<std::pair<std::string, IndexPointer>> &entries) {
+        clear();
+        std::map<std::string, RowBitmap> grouped;
+        for (const auto &entry : entries) {
+            grouped[entry.first].add(entry.second.address.index, entry.second.slot);
+        }
+        for (const auto &entry : grouped) {
+            writeRuns(values_[entry.first], entry.second);
+        }
+    }
+
+    void insert(const std::string &key, const IndexPointer &ptr) {
+        add(key, ptr.address.index, checkedSlot(ptr.slot));
+    }
+
+    // Makes `ptr` the only row of `key`.
+    void insertUnique(const std::string &key, const IndexPointer &ptr) {
+        const auto slot = checkedSlot(ptr.slot);
+        erase(key);
+        add(key, ptr.address.index, slot);
+    }
+
+    bool update(const std::string &key, const IndexPointer &ptr) {
+        if (values_.find(key) == values_.end()) {
+            return false;
+        }
+        insertUnique(key, ptr);
+        return true;
+    }
+
+    bool erase(const std::string &key) {
+        auto it = values_.find(key);
+        if (it == values_.end()) {
+            return false;
+        }
+        for (const auto &run : it->second) {
+            releasePage(run.pageId);
+        }
+        values_.erase(it);
+        changed_ = true;
+        return true;
+    }
+
+    bool erase(const std::string &key, const IndexPointer &ptr) {
+        auto it = values_.find(key);
+        if (it == values_.end() || ptr.slot > RowBitmap::kMaxSlot) {
+            return false;
+        }
+        auto &runs = it->second;
+        const std::size_t at = runFor(runs, ptr.address.index);
+        auto containers = readPage(runs[at].pageId);
+        auto container = std::lower_bound(containers.begin(), containers.end(), ptr.address.index,
+                                          [](const Container &c, std::size_t block) { return c.first < block; });
+        if (container == containers.end() || container->first != ptr.address.index) {
+            return false;
+        }
+        auto &slots = container->second;
+        auto slot = std::lower_bound(slots.begin(), slots.end(), static_cast<std::uint16_t>(ptr.slot));
+        if (slot == slots.end() || *slot != ptr.slot) {
+            return false;
+        }
+        slots.erase(slot);
+        if (slots.empty()) {
+            containers.erase(container);
+        }
+        --runs[at].rows;
+        if (containers.empty()) {
+            releasePage(runs[at].pageId);
+            runs.erase(runs.begin() + static_cast<std::ptrdiff_t>(at));
+            if (runs.empty()) {
+                values_.erase(it);
+            }
+        } else {
+            writePage(runs[at].pageId, containers);
+        }
+        changed_ = true;
+        return true;
+    }
+
+    // Rows stored under `key`; empty when the key is absent.
+    RowBitmap rows(const std::string &key) const {
+        RowBitmap result;
+        auto it = values_.find(key);
+        if (it == values_.end()) {
+            return result;
+        }
+        for (const auto &run : it->second) {
+            for (const auto &container : readPage(run.pageId)) {
+                for (auto slot : container.second) {
+                    result.add(container.first, slot);
+                }
+            }
+        }
+        return result;
+    }
+
+    std::optional<IndexPointer> find(const std::string &key) const {
+        auto pointers = findAll(key);
+        if (pointers.empty()) {
+            return std::nullopt;
+        }
+        return pointers.front();
+    }
+
+    std::vector<IndexPointer> findAll(const std::string &key) const {
+        std::vector<IndexPointer> pointers;
+        rows(key).forEachBlock([&](std::size_t block, const std::vector<std::uint16_t> &slots) {
+            for (auto slot : slots) {
+                pointers.push_back(IndexPointer{BlockAddress{pointerTable_, block}, slot});
+            }
+        });
+        return pointers;
+    }
+
+    std::vector<std::string> describePages() const {
+        std::vector<std::string> lines;
+        std::ostringstream header;
+        header << "Bitmap index: " << values_.size() << " distinct value(s), " << size() << " row(s), "
+               << usedPages_ << " page(s); run directory " << residentBytes() << " bytes in memory.";
+        lines.push_back(header.str());
+        for (const auto &entry : values_) {
+            std::ostringstream line;
+            std::size_t rows = 0;
+            for (const auto &run : entry.second) {
+                rows += run.rows;
+            }
+            line << "  Value [" << entry.first << "] rows=" << rows << " -> page(s)";
+            for (const auto &run : entry.second) {
+                line << " #" << run.pageId;
+            }
+            lines.push_back(line.str());
+        }
+        return lines;
+    }
+
+    // Writes the meta file, and for an in-memory index every page with it.
+    void saveToFile(const std::string &path) const {
+        writeMeta(path, true);
+    }
+
+    // Pages are written through the store as they change, so a stored index
+    // only marks its meta file dirty until the next checkpoint. An in-memory
+    // index saves itself.
+    void persistChanges(const std::string &path) {
+        if (!store_) {
+            if (changed_ || !pathutil::fileExists(path)) {
+                writeMeta(path, true);
+                changed_ = false;
+            }
+            return;
+        }
+        if (metaClean_ && changed_) {
+            writeMeta(path, false);
+            metaClean_ = false;
+        }
+    }
+
+    // Records that every page of a stored index has reached disk. Callers
+    // flush the buffer pool first; a meta file left dirty forces a rebuild.
+    void checkpoint(const std::string &path) {
+        writeMeta(path, true);
+        metaClean_ = true;
+        changed_ = false;
+    }
+
+    void loadFromFile(const std::string &path,
+                      std::size_t expectedPageSize,
+                      std::size_t expectedKeyLength) {
+        std::ifstream in(path, std::ios::binary);
+        if (!in) {
+            throw std::runtime_error("failed to open index file: " + path);
+        }
+        auto readLine = [&](const char *context) {
+            std::string line;
+            if (!std::getline(in, line)) {
+                std::ostringstream oss;
+                oss << "corrupted index file '" << path << "' missing " << context;
+                throw std::runtime_error(oss.str());
+            }
+            if (!line.empty() && line.back() == '\r') {
+                line.pop_back();
+            }
+            return line;
+        };
+        auto readValue = [&](const char *name) {
+            const std::string line = readLine(name);
+            const std::string prefix = std::string(name) + " ";
+            if (line.compare(0, prefix.size(), prefix) != 0) {
+                std::ostringstream oss;
+                oss << "corrupted index file '" << path << "' expected " << name;
+                throw std::runtime_error(oss.str());
+            }
+            return static_cast<std::size_t>(std::stoull(line.substr(prefix.size())));
+        };
+        if (readLine("header") != "IDXBITMAP V2") {
+            throw std::runtime_error("unsupported index format in " + path);
+        }
+        if (readValue("PAGE_SIZE") != expectedPageSize) {
+            throw std::runtime_error("index page size mismatch in " + path);
+        }
+        if (readValue("KEY_LENGTH") != expectedKeyLength) {
+            throw std::runtime_error("index key length mismatch in " + path);
+        }
+        const bool local = readValue("LOCAL") != 0;
+        if (local != (store_ == nullptr)) {
+            throw std::runtime_error("index file " + path + " does not match the index storage mode");
+        }
+        const std::size_t usedPages = readValue("USED");
+        if (readValue("CLEAN") == 0) {
+            throw std::runtime_error("index file " + path + " was not checkpointed");
+        }
+        configure(expectedPageSize, expectedKeyLength);
+        std::map<std::string, std::vector<Run>> values;
+        const std::size_t valueCount = readValue("VALUES");
+        for (std::size_t v = 0; v < valueCount; ++v) {
+            std::istringstream header(readLine("value"));
+            std::string keyHex;
+            std::size_t runCount = 0;
+            if (!(header >> keyHex >> runCount)) {
+                throw std::runtime_error("corrupted index file '" + path + "' value header");
+            }
+            auto &runs = values[decodeHex(keyHex, path)];
+            runs.resize(runCount);
+            for (auto &run : runs) {
+                std::istringstream line(readLine("run"));
+                if (!(line >> run.firstBlock >> run.pageId >> run.rows)) {
+                    throw std::runtime_error("corrupted index file '" + path + "' run entry");
+                }
+            }
+        }
+        std::vector<std::size_t> freePages(readValue("FREE"));
+        for (auto &pageId : freePages) {
+            pageId = static_cast<std::size_t>(std::stoull(readLine("free page")));
+        }
+        if (local) {
+            localStore_ = std::make_unique<LocalPageStore>(expectedPageSize);
+            const std::size_t pageCount = readValue("PAGES");
+            for (std::size_t i = 0; i < pageCount; ++i) {
+                std::istringstream line(readLine("page"));
+                std::size_t pageId = 0;
+                std::string hex;
+                line >> pageId >> hex;
+                localStore_->restore(pageId, decodeHex(hex, path));
+            }
+        }
+        values_ = std::move(values);
+        freePages_ = std::move(freePages);
+        usedPages_ = usedPages;
+        metaClean_ = true;
+        changed_ = false;
+    }
+
+private:
+    // Pages of one key cover consecutive block ranges: a run holds the
+    // containers of blocks from firstBlock up to the next run's firstBlock.
+    struct Run {
+        std::size_t firstBlock{0};
+        std::size_t pageId{0};
+        std::size_t rows{0};
+    };
+
+    // Block number and its sorted slots.
+    using Container = std::pair<std::size_t, std::vector<std::uint16_t>>;
+
+    static constexpr std::uint64_t kBitmapPageKind = 5;
+    // kind(1) count(2)
+    static constexpr std::size_t kPageHeaderBytes = 3;
+    // block(8) count(2)
+    static constexpr std::size_t kContainerHeaderBytes = 10;
+
+    static std::uint16_t checkedSlot(std::size_t slot) {
+        if (slot > RowBitmap::kMaxSlot) {
+            throw std::out_of_range("slot " + std::to_string(slot) + " does not fit a bitmap container");
+        }
+        return static_cast<std::uint16_t>(slot);
+    }
+
+    static std::size_t encodedSize(const Container &container) {
+        return kContainerHeaderBytes + container.second.size() * sizeof(std::uint16_t);
+    }
+
+    IndexPageStore &pages() const {
+        return store_ ? *store_ : *localStore_;
+    }
+
+    void configure(std::size_t pageSizeBytes, std::size_t keyBytes) {
+        pageSize_ = pageSizeBytes;
+        keyLength_ = keyBytes;
+        capacity_ = store_ ? store_->pageCapacity() : pageSizeBytes;
+        if (capacity_ < kPageHeaderBytes + kContainerHeaderBytes + sizeof(std::uint16_t)) {
+            std::ostringstream oss;
+            oss << "bitmap index page of " << capacity_ << " bytes cannot hold a container";
+            throw std::runtime_error(oss.str());
+        }
+    }
+
+    // Run of `runs` whose block range holds `block`; blocks before the
+    // first run belong to it.
+    static std::size_t runFor(const std::vector<Run> &runs, std::size_t block) {
+        auto it = std::upper_bound(runs.begin(), runs.end(), block,
+                                   [](std::size_t b, const Run &run) { return b < run.firstBlock; });
+        return it == runs.begin() ? 0 : static_cast<std::size_t>(std::distance(runs.begin(), it)) - 1;
+    }
+
+    void add(const std::string &key, std::size_t block, std::uint16_t slot) {
+        auto &runs = values_[key];
+        if (runs.empty()) {
+            runs.push_back(Run{block, allocatePage(), 0});
+        }
+        const std::size_t at = runFor(runs, block);
+        auto containers = readPage(runs[at].pageId);
+        auto container = std::lower_bound(containers.begin(), containers.end(), block,
+                                          [](const Container &c, std::size_t b) { return c.first < b; });
+        if (container == containers.end() || container->first != block) {
+            container = containers.insert(container, Container{block, {}});
+        }
+        auto &slots = container->second;
+        auto pos = std::lower_bound(slots.begin(), slots.end(), slot);
+        if (pos != slots.end() && *pos == slot) {
+            return;
+        }
+        slots.insert(pos, slot);
+        ++runs[at].rows;
+        runs[at].firstBlock = std::min(runs[at].firstBlock, block);
+        storeRun(runs, at, std::move(containers));
+        changed_ = true;
+    }
+
+    // Writes the containers of run `at`, moving the upper half onto a new
+    // page that follows it when they no longer fit one page.
+    void storeRun(std::vector<Run> &runs, std::size_t at, std::vector<Container> containers) {
+        std::size_t bytes = kPageHeaderBytes;
+        for (const auto &container : containers) {
+            bytes += encodedSize(container);
+        }
+        if (bytes <= capacity_) {
+            writePage(runs[at].pageId, containers);
+            return;
+        }
+        if (containers.size() < 2) {
+            throwOversized(containers.front());
+        }
+        std::size_t split = 0;
+        for (std::size_t lower = kPageHeaderBytes; split + 1 < containers.size() && lower * 2 < bytes; ++split) {
+            lower += encodedSize(containers[split]);
+        }
+        split = std::max<std::size_t>(split, 1);
+        std::vector<Container> upper(std::make_move_iterator(containers.begin() + static_cast<std::ptrdiff_t>(split)),
+                                     std::make_move_iterator(containers.end()));
+        containers.erase(containers.begin() + static_cast<std::ptrdiff_t>(split), containers.end());
+        Run next{upper.front().first, allocatePage(), 0};
+        for (const auto &container : upper) {
+            next.rows += container.second.size();
+        }
+        runs[at].rows -= next.rows;
+        writePage(runs[at].pageId, containers);
+        writePage(next.pageId, upper);
+        runs.insert(runs.begin() + static_cast<std::ptrdiff_t>(at + 1), next);
+    }
+
+    // Packs `rows` onto fresh pages, block by block.
+    void writeRuns(std::vector<Run> &runs, const RowBitmap &rows) {
+        std::vector<Container> page;
+        std::size_t bytes = kPageHeaderBytes;
+        std::size_t count = 0;
+        auto flush = [&] {
+            runs.push_back(Run{page.front().first, allocatePage(), count});
+            writePage(runs.back().pageId, page);
+            page.clear();
+            bytes = kPageHeaderBytes;
+            count = 0;
+        };
+        rows.forEachBlock([&](std::size_t block, const std::vector<std::uint16_t> &slots) {
+            Container container{block, slots};
+            if (bytes + encodedSize(container) > capacity_) {
+                if (page.empty()) {
+                    throwOversized(container);
+                }
+                flush();
+            }
+            bytes += encodedSize(container);
+            count += slots.size();
+            page.push_back(std::move(container));
+        });
+        if (!page.empty()) {
+            flush();
+        }
+    }
+
+    void throwOversized(const Container &container) const {
+        std::ostringstream oss;
+        oss << "bitmap container of block " << container.first << " outgrows an index page of " << capacity_
+            << " bytes";
+        throw std::runtime_error(oss.str());
+    }
+
+    std::size_t allocatePage() {
+        std::size_t pageId = 0;
+        if (!freePages_.empty()) {
+            pageId = freePages_.back();
+            freePages_.pop_back();
+        } else {
+            pageId = pages().allocatePage();
+        }
+        ++usedPages_;
+        writePage(pageId, {});
+        return pageId;
+    }
+
+    void releasePage(std::size_t pageId) {
+        freePages_.push_back(pageId);
+        --usedPages_;
+    }
+
+    // Page layout: kind(1) count(2), then per container block(8) count(2)
+    // and its slots, two bytes each.
+    void writePage(std::size_t pageId, const std::vector<Container> &containers) {
+        std::string out;
+        appendUint(out, kBitmapPageKind, 1);
+        appendUint(out, containers.size(), 2);
+        for (const auto &container : containers) {
+            appendUint(out, container.first, 8);
+            appendUint(out, container.second.size(), 2);
+            for (auto slot : container.second) {
+                appendUint(out, slot, 2);
+            }
+        }
+        pages().writePage(pageId, out);
+    }
+
+    std::vector<Container> readPage(std::size_t pageId) const {
+        const std::string in = pages().readPage(pageId);
+        std::size_t pos = 0;
+        if (readUint(in, pos, 1, pageId) != kBitmapPageKind) {
+            std::ostringstream oss;
+            oss << "index page #" << pageId << " is not a bitmap page";
+            throw std::runtime_error(oss.str());
+        }
+        std::vector<Container> containers(static_cast<std::size_t>(readUint(in, pos, 2, pageId)));
+        for (auto &container : containers) {
+            container.first = static_cast<std::size_t>(readUint(in, pos, 8, pageId));
+            container.second.resize(static_cast<std::size_t>(readUint(in, pos, 2, pageId)));
+            for (auto &slot : container.second) {
+                slot = static_cast<std::uint16_t>(readUint(in, pos, 2, pageId));
+            }
+        }
+        return containers;
+    }
+
+    void writeMeta(const std::string &path, bool clean) const {
+        pathutil::ensureParentDirectory(path);
+        const std::string tempPath = path + ".tmp";
+        {
+            std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+            out << "IDXBITMAP V2\n";
+            out << "PAGE_SIZE " << pageSize_ << "\n";
+            out << "KEY_LENGTH " << keyLength_ << "\n";
+            out << "LOCAL " << (store_ ? 0 : 1) << "\n";
+            out << "USED " << usedPages_ << "\n";
+            out << "CLEAN " << (clean ? 1 : 0) << "\n";
+            out << "VALUES " << values_.size() << "\n";
+            for (const auto &entry : values_) {
+                out << encodeHex(entry.first) << " " << entry.second.size() << "\n";
+                for (const auto &run : entry.second) {
+                    out << run.firstBlock << " " << run.pageId << " " << run.rows << "\n";
+                }
+            }
+            out << "FREE " << freePages_.size() << "\n";
+            for (auto pageId : freePages_) {
+                out << pageId << "\n";
+            }
+            if (!store_) {
+                const auto ids = localStore_->pageIds();
+                out << "PAGES " << ids.size() << "\n";
+                for (auto pageId : ids) {
+                    out << pageId << " " << encodeHex(localStore_->readPage(pageId)) << "\n";
+                }
+            }
+            if (!out) {
+                throw std::runtime_error("failed to persist index file: " + path);
+            }
+        }
+        if (std::rename(tempPath.c_str(), path.c_str()) != 0) {
+            std::remove(path.c_str());
+            if (std::rename(tempPath.c_str(), path.c_str()) != 0) {
+                throw std::runtime_error("failed to replace index file: " + path);
+            }
+        }
+    }
+
+    static void appendUint(std::string &out, std::uint64_t value, std::size_t bytes) {
+        for (std::size_t i = 0; i < bytes; ++i) {
+            out.push_back(static_cast<char>((value >> (8U * i)) & 0xFFU));
+        }
+    }
+
+    static std::uint64_t readUint(const std::string &in, std::size_t &pos, std::size_t bytes, std::size_t pageId) {
+        if (pos + bytes > in.size()) {
+            std::ostringstream oss;
+            oss << "corrupted index page #" << pageId;
+            throw std::runtime_error(oss.str());
+        }
+        std::uint64_t value = 0;
+        for (std::size_t i = 0; i < bytes; ++i) {
+            value |= static_cast<std::uint64_t>(static_cast<unsigned char>(in[pos + i])) << (8U * i);
+        }
+        pos += bytes;
+        return value;
+    }
+
+    static std::string encodeHex(const std::string &input) {
+        static const char *digits = "0123456789abcdef";
+        std::string out;
+        out.reserve(input.size() * 2 + 1);
+        out.push_back('x');  // keeps an empty key from being an empty token
+        for (unsigned char ch : input) {
+            out.push_back(digits[ch >> 4]);
+            out.push_back(digits[ch & 0x0F]);
+        }
+        return out;
+    }
+
+    static std::string decodeHex(const std::string &input, const std::string &path) {
+        if (input.empty() || input[0] != 'x' || input.size() % 2 == 0) {
+            throw std::runtime_error("corrupted index file '" + path + "' hex field");
+        }
+        auto nibble = [&](char ch) {
+            if (ch >= '0' && ch <= '9') return ch - '0';
+            if (ch >= 'a' && ch <= 'f') return ch - 'a' + 10;
+            throw std::runtime_error("corrupted index file '" + path + "' hex field");
+        };
+        std::string out;
+        out.reserve(input.size() / 2);
+        for (std::size_t i = 1; i < input.size(); i += 2) {
+            out.push_back(static_cast<char>((nibble(input[i]) << 4) | nibble(input[i + 1])));
+        }
+        return out;
+    }
+
+    std::size_t pageSize_{0};
+    std::size_t keyLength_{0};
+    std::size_t capacity_{0};
+    IndexPageStore *store_{nullptr};
+    std::unique_ptr<LocalPageStore> localStore_;
+    std::string pointerTable_;
+    std::map<std::string, std::vector<Run>> values_;
+    std::vector<std::size_t> freePages_;
+    std::size_t usedPages_{0};
+    bool changed_{false};
+    bool metaClean_{false};
+};
+
+} // namespace dbms
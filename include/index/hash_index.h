@@ -0,0 +1,715 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "common/types.h"
+#include "common/utils.h"
+#include "index/b_plus_tree.h"
+
+namespace dbms {
+
+// Linear hash table for equality lookups. Keys hash to one of a growing
+// number of buckets; bucket b lives on a chain of pages, a primary page and
+// overflow pages behind it. Once the entries outgrow kMaxLoadFactor of the
+// bucket capacity the bucket at the split pointer is split in two, so the
+// table grows one bucket at a time and a lookup reads a single chain, which
+// is one page unless the bucket overflowed. Keys are not ordered, so there
+// is no range scan.
+//
+// Pages go through an IndexPageStore like the nodes of a paged BPlusTree; a
+// table without one keeps its pages in memory and saves them with its meta
+// file.
+class LinearHashIndex {
+public:
+    LinearHashIndex() = default;
+
+    LinearHashIndex(std::size_t pageSizeBytes, std::size_t keyBytes) {
+        initialize(pageSizeBytes, keyBytes);
+    }
+
+    // Empties the table. Pages are only written once something is inserted,
+    // so a table about to be loaded leaves its store untouched.
+    void initialize(std::size_t pageSizeBytes, std::size_t keyBytes) {
+        configure(pageSizeBytes, keyBytes);
+        clear();
+    }
+
+    // Lets a key map to many pointers; otherwise inserting an existing key
+    // replaces its pointer. Resets the table.
+    void setAllowDuplicates(bool allow) {
+        duplicates_ = allow;
+        if (entriesPerPage_ != 0) {
+            clear();
+        }
+    }
+
+    bool allowsDuplicates() const {
+        return duplicates_;
+    }
+
+    // Moves the table onto the pages of `store`. Pointers are stored without
+    // their table name, which is restored from pointerTable on decode.
+    void attachPageStore(IndexPageStore *store, std::string pointerTable) {
+        store_ = store;
+        pointerTable_ = std::move(pointerTable);
+        initialize(pageSize_, keyLength_);
+    }
+
+    std::size_t entriesPerPage() const {
+        return entriesPerPage_;
+    }
+
+    std::size_t pageSizeBytes() const {
+        return pageSize_;
+    }
+
+    std::size_t pageCount() const {
+        return usedPages_;
+    }
+
+    std::size_t bucketCount() const {
+        return buckets_.size();
+    }
+
+    std::size_t size() const {
+        return entries_;
+    }
+
+    // Replaces the contents with `entries`, sized up front so that no bucket
+    // splits while loading. Without duplicates the last entry of a key wins.
+    void bulkInsert(const std::vector<std::pair<std::string, IndexPointer>> &entries) {
+        clear();
+        const std::size_t perBucket =
+            std::max<std::size_t>(1, static_cast<std::size_t>(entriesPerPage_ * kMaxLoadFactor));
+        const std::size_t wanted = std::max(kInitialBuckets, (entries.size() + perBucket - 1) / perBucket);
+        while ((kInitialBuckets << (level_ + 1)) <= wanted) {
+            ++level_;
+        }
+        split_ = wanted - (kInitialBuckets << level_);
+        std::vector<std::vector<Entry>> contents(wanted);
+        std::unordered_map<std::string, std::pair<std::size_t, std::size_t>> placed;
+        for (const auto &entry : entries) {
+            const std::uint32_t hash = hashKey(entry.first);
+            const std::size_t bucket = bucketFor(hash);
+            if (!duplicates_) {
+                auto found = placed.find(entry.first);
+                if (found != placed.end()) {
+                    contents[found->second.first][found->second.second].pointer = entry.second;
+                    continue;
+                }
+                placed.emplace(entry.first, std::make_pair(bucket, contents[bucket].size()));
+            }
+            contents[bucket].push_back(Entry{hash, entry.first, entry.second});
+        }
+        for (auto &bucket : contents) {
+            buckets_.push_back(allocatePage());
+            writeChain(buckets_.back(), bucket);
+            entries_ += bucket.size();
+        }
+        changed_ = true;
+    }
+
+    void insert(const std::string &key, const IndexPointer &ptr) {
+        if (!duplicates_ && update(key, ptr)) {
+            return;
+        }
+        append(key, ptr);
+    }
+
+    // Inserts or replaces the single entry of `key`.
+    void insertUnique(const std::string &key, const IndexPointer &ptr) {
+        if (!update(key, ptr)) {
+            append(key, ptr);
+        }
+    }
+
+    // Points the first entry of `key` at `ptr`; false when the key is absent.
+    bool update(const std::string &key, const IndexPointer &ptr) {
+        if (buckets_.empty()) {
+            return false;
+        }
+        const std::uint32_t hash = hashKey(key);
+        for (std::size_t pageId = buckets_[bucketFor(hash)]; pageId != kNoPage;) {
+            Page page = readPage(pageId);
+            for (auto &entry : page.entries) {
+                if (entry.hash == hash && entry.key == key) {
+                    entry.pointer = ptr;
+                    writePage(pageId, page);
+                    changed_ = true;
+                    return true;
+                }
+            }
+            pageId = page.next;
+        }
+        return false;
+    }
+
+    bool erase(const std::string &key) {
+        return eraseEntries(key, nullptr);
+    }
+
+    // Removes a single pointer stored under `key`.
+    bool erase(const std::string &key, const IndexPointer &ptr) {
+        return eraseEntries(key, &ptr);
+    }
+
+    std::optional<IndexPointer> find(const std::string &key) const {
+        std::optional<IndexPointer> result;
+        visitKey(key, [&](const IndexPointer &ptr) {
+            result = ptr;
+            return false;
+        });
+        return result;
+    }
+
+    std::vector<IndexPointer> findAll(const std::string &key) const {
+        std::vector<IndexPointer> result;
+        visitKey(key, [&](const IndexPointer &ptr) {
+            result.push_back(ptr);
+            return true;
+        });
+        return result;
+    }
+
+    std::vector<std::string> describePages() const {
+        std::vector<std::string> lines;
+        std::ostringstream header;
+        header << "Hash index: " << buckets_.size() << " bucket(s), " << usedPages_
+               << " page(s), max " << entriesPerPage_ << " entry/entries per page.";
+        lines.push_back(header.str());
+        for (std::size_t bucket = 0; bucket < buckets_.size(); ++bucket) {
+            std::ostringstream pagesLine;
+            std::ostringstream keysLine;
+            pagesLine << "  Bucket " << bucket << " -> page(s)";
+            keysLine << "    Keys: ";
+            std::size_t count = 0;
+            for (std::size_t pageId = buckets_[bucket]; pageId != kNoPage;) {
+                const Page page = readPage(pageId);
+                pagesLine << " #" << pageId;
+                for (const auto &entry : page.entries) {
+                    keysLine << (count++ == 0 ? "" : " | ") << "[" << entry.key << "]";
+                }
+                pageId = page.next;
+            }
+            pagesLine << " entries=" << count;
+            lines.push_back(pagesLine.str());
+            lines.push_back(count == 0 ? "    Keys: []" : keysLine.str());
+        }
+        return lines;
+    }
+
+    // Writes the meta file, and for an in-memory table every page with it.
+    void saveToFile(const std::string &path) const {
+        writeMeta(path, true);
+    }
+
+    // Pages are written through the store as they change, so a stored table
+    // only marks its meta file dirty until the next checkpoint. An in-memory
+    // table saves itself.
+    void persistChanges(const std::string &path) {
+        if (!store_) {
+            if (changed_ || !pathutil::fileExists(path)) {
+                writeMeta(path, true);
+                changed_ = false;
+            }
+            return;
+        }
+        if (metaClean_ && changed_) {
+            writeMeta(path, false);
+            metaClean_ = false;
+        }
+    }
+
+    // Records that every page of a stored table has reached disk. Callers
+    // flush the buffer pool first; a meta file left dirty forces a rebuild.
+    void checkpoint(const std::string &path) {
+        writeMeta(path, true);
+        metaClean_ = true;
+        changed_ = false;
+    }
+
+    void loadFromFile(const std::string &path,
+                      std::size_t expectedPageSize,
+                      std::size_t expectedKeyLength) {
+        std::ifstream in(path, std::ios::binary);
+        if (!in) {
+            throw std::runtime_error("failed to open index file: " + path);
+        }
+        auto readLine = [&](const char *context) {
+            std::string line;
+            if (!std::getline(in, line)) {
+                std::ostringstream oss;
+                oss << "corrupted index file '" << path << "' missing " << context;
+                throw std::runtime_error(oss.str());
+            }
+            if (!line.empty() && line.back() == '\r') {
+                line.pop_back();
+            }
+            return line;
+        };
+        auto readValue = [&](const char *name) {
+            const std::string line = readLine(name);
+            const std::string prefix = std::string(name) + " ";
+            if (line.compare(0, prefix.size(), prefix) != 0) {
+                std::ostringstream oss;
+                oss << "corrupted index file '" << path << "' expected " << name;
+                throw std::runtime_error(oss.str());
+            }
+            return static_cast<std::size_t>(std::stoull(line.substr(prefix.size())));
+        };
+        if (readLine("header") != "IDXHASH V1") {
+            throw std::runtime_error("unsupported index format in " + path);
+        }
+        if (readValue("PAGE_SIZE") != expectedPageSize) {
+            throw std::runtime_error("index page size mismatch in " + path);
+        }
+        if (readValue("KEY_LENGTH") != expectedKeyLength) {
+            throw std::runtime_error("index key length mismatch in " + path);
+        }
+        if ((readValue("DUPLICATES") != 0) != duplicates_) {
+            throw std::runtime_error("index file " + path + " does not match the index key mode");
+        }
+        const bool local = readValue("LOCAL") != 0;
+        if (local != (store_ == nullptr)) {
+            throw std::runtime_error("index file " + path + " does not match the index storage mode");
+        }
+        const std::size_t level = readValue("LEVEL");
+        const std::size_t split = readValue("SPLIT");
+        const std::size_t entries = readValue("ENTRIES");
+        const std::size_t usedPages = readValue("USED");
+        if (readValue("CLEAN") == 0) {
+            throw std::runtime_error("index file " + path + " was not checkpointed");
+        }
+        configure(expectedPageSize, expectedKeyLength);
+        if (local) {
+            localStore_ = std::make_unique<LocalPageStore>(expectedPageSize);
+        }
+        std::vector<std::size_t> buckets(readValue("BUCKETS"));
+        for (auto &pageId : buckets) {
+            pageId = static_cast<std::size_t>(std::stoull(readLine("bucket page")));
+        }
+        std::vector<std::size_t> freePages(readValue("FREE"));
+        for (auto &pageId : freePages) {
+            pageId = static_cast<std::size_t>(std::stoull(readLine("free page")));
+        }
+        if (local) {
+            const std::size_t pageCount = readValue("PAGES");
+            for (std::size_t i = 0; i < pageCount; ++i) {
+                std::istringstream line(readLine("page"));
+                std::size_t pageId = 0;
+                std::string hex;
+                line >> pageId >> hex;
+                localStore_->restore(pageId, decodeHex(hex, path));
+            }
+        }
+        if (!buckets.empty() && buckets.size() != (kInitialBuckets << level) + split) {
+            throw std::runtime_error("corrupted index file '" + path + "' bucket count");
+        }
+        level_ = level;
+        split_ = split;
+        entries_ = entries;
+        usedPages_ = usedPages;
+        buckets_ = std::move(buckets);
+        freePages_ = std::move(freePages);
+        metaClean_ = true;
+        changed_ = false;
+    }
+
+private:
+    struct Entry {
+        std::uint32_t hash{0};
+        std::string key;
+        IndexPointer pointer;
+    };
+
+    struct Page {
+        std::size_t next{kNoPage};
+        std::vector<Entry> entries;
+    };
+
+    static constexpr std::size_t kNoPage = std::numeric_limits<std::size_t>::max();
+    static constexpr std::size_t kInitialBuckets = 4;
+    static constexpr double kMaxLoadFactor = 0.75;
+    static constexpr std::uint64_t kBucketPageKind = 4;
+    // kind(1) next(8) count(2)
+    static constexpr std::size_t kPageHeaderBytes = 11;
+    // hash(4) key length(2) block(8) slot(4)
+    static constexpr std::size_t kEntryOverheadBytes = 18;
+
+    // FNV-1a with a final avalanche, so both the bits the bucket number is
+    // taken from and the layout persisted with them stay stable across
+    // builds, unlike std::hash.
+    static std::uint32_t hashKey(const std::string &key) {
+        std::uint32_t hash = 2166136261u;
+        for (unsigned char byte : key) {
+            hash = (hash ^ byte) * 16777619u;
+        }
+        hash ^= hash >> 16;
+        hash *= 0x85ebca6bu;
+        hash ^= hash >> 13;
+        hash *= 0xc2b2ae35u;
+        hash ^= hash >> 16;
+        return hash;
+    }
+
+    std::size_t bucketFor(std::uint32_t hash) const {
+        const std::size_t round = kInitialBuckets << level_;
+        const std::size_t bucket = hash % round;
+        return bucket < split_ ? hash % (2 * round) : bucket;
+    }
+
+    IndexPageStore &pages() const {
+        return store_ ? *store_ : *localStore_;
+    }
+
+    void configure(std::size_t pageSizeBytes, std::size_t keyBytes) {
+        pageSize_ = pageSizeBytes;
+        keyLength_ = keyBytes;
+        const std::size_t capacity = store_ ? store_->pageCapacity() : pageSizeBytes;
+        const std::size_t entryBytes = kEntryOverheadBytes + keyBytes;
+        entriesPerPage_ = capacity > kPageHeaderBytes ? (capacity - kPageHeaderBytes) / entryBytes : 0;
+        if (entriesPerPage_ == 0) {
+            std::ostringstream oss;
+            oss << "hash index page of " << capacity << " bytes cannot hold a key of " << keyBytes
+                << " bytes";
+            throw std::runtime_error(oss.str());
+        }
+    }
+
+    // Drops every entry. All pages the store owns become free for reuse.
+    void clear() {
+        buckets_.clear();
+        level_ = 0;
+        split_ = 0;
+        entries_ = 0;
+        usedPages_ = 0;
+        freePages_.clear();
+        if (store_) {
+            freePages_ = store_->pageIds();
+            std::reverse(freePages_.begin(), freePages_.end());
+        } else {
+            localStore_ = std::make_unique<LocalPageStore>(pageSize_);
+        }
+        changed_ = true;
+    }
+
+    void append(const std::string &key, const IndexPointer &ptr) {
+        if (buckets_.empty()) {
+            for (std::size_t i = 0; i < kInitialBuckets; ++i) {
+                buckets_.push_back(allocatePage());
+            }
+        }
+        const std::uint32_t hash = hashKey(key);
+        std::size_t pageId = buckets_[bucketFor(hash)];
+        while (true) {
+            Page page = readPage(pageId);
+            if (page.entries.size() < entriesPerPage_) {
+                page.entries.push_back(Entry{hash, key, ptr});
+                writePage(pageId, page);
+                break;
+            }
+            if (page.next == kNoPage) {
+                page.next = allocatePage();
+                writePage(pageId, page);
+                writePage(page.next, Page{kNoPage, {Entry{hash, key, ptr}}});
+                break;
+            }
+            pageId = page.next;
+        }
+        ++entries_;
+        changed_ = true;
+        if (entries_ > kMaxLoadFactor * static_cast<double>(entriesPerPage_ * buckets_.size())) {
+            splitBucket();
+        }
+    }
+
+
+    std::size_t allocatePage() {
+        std::size_t pageId = 0;
+        if (!freePages_.empty()) {
+            pageId = freePages_.back();
+            freePages_.pop_back();
+        } else {
+            pageId = pages().allocatePage();
+        }
+        ++usedPages_;
+        writePage(pageId, Page{});
+        return pageId;
+    }
+
+    // Returns the chain starting at `pageId` to the free list.
+    void releasePage(std::size_t pageId) {
+        while (pageId != kNoPage) {
+            const std::size_t next = readPage(pageId).next;
+            freePages_.push_back(pageId);
+            --usedPages_;
+            pageId = next;
+        }
+    }
+
+    // Calls visit for each pointer stored under `key` until it returns false.
+    template <typename Visit>
+    void visitKey(const std::string &key, Visit visit) const {
+        if (buckets_.empty()) {
+            return;
+        }
+        const std::uint32_t hash = hashKey(key);
+        for (std::size_t pageId = buckets_[bucketFor(hash)]; pageId != kNoPage;) {
+            const Page page = readPage(pageId);
+            for (const auto &entry : page.entries) {
+                if (entry.hash == hash && entry.key == key && !visit(entry.pointer)) {
+                    return;
+                }
+            }
+            pageId = page.next;
+        }
+    }
+
+    bool eraseEntries(const std::string &key, const IndexPointer *ptr) {
+        if (buckets_.empty()) {
+            return false;
+        }
+        const std::uint32_t hash = hashKey(key);
+        const std::size_t head = buckets_[bucketFor(hash)];
+        std::vector<Entry> kept;
+        bool erased = false;
+        for (std::size_t pageId = head; pageId != kNoPage;) {
+            Page page = readPage(pageId);
+            for (auto &entry : page.entries) {
+                const bool match = entry.hash == hash && entry.key == key &&
+                                   (!ptr || (!erased && entry.pointer == *ptr));
+                if (match) {
+                    erased = true;
+                    --entries_;
+                } else {
+                    kept.push_back(std::move(entry));
+                }
+            }
+            pageId = page.next;
+        }
+        if (erased) {
+            writeChain(head, kept);
+            changed_ = true;
+        }
+        return erased;
+    }
+
+    // Splits the bucket at the split pointer: its entries whose hash picks
+    // the bucket one round further up move there.
+    void splitBucket() {
+        const std::size_t round = kInitialBuckets << level_;
+        const std::size_t source = split_;
+        std::vector<Entry> stay;
+        std::vector<Entry> move;
+        for (std::size_t pageId = buckets_[source]; pageId != kNoPage;) {
+            Page page = readPage(pageId);
+            for (auto &entry : page.entries) {
+                (entry.hash % (2 * round) == source ? stay : move).push_back(std::move(entry));
+            }
+            pageId = page.next;
+        }
+        buckets_.push_back(allocatePage());
+        writeChain(buckets_[source], stay);
+        writeChain(buckets_.back(), move);
+        if (++split_ == round) {
+            ++level_;
+            split_ = 0;
+        }
+    }
+
+    // Stores `entries` on the chain starting at `head`, reusing its pages
+    // and releasing any it no longer needs.
+    void writeChain(std::size_t head, const std::vector<Entry> &entries) {
+        std::size_t pageId = head;
+        std::size_t next = readPage(head).next;
+        std::size_t offset = 0;
+        while (true) {
+            Page page;
+            const std::size_t take = std::min(entriesPerPage_, entries.size() - offset);
+            page.entries.assign(entries.begin() + static_cast<std::ptrdiff_t>(offset),
+                                entries.begin() + static_cast<std::ptrdiff_t>(offset + take));
+            offset += take;
+            if (offset == entries.size()) {
+                writePage(pageId, page);
+                releasePage(next);
+                return;
+            }
+            if (next == kNoPage) {
+                next = allocatePage();
+            }
+            page.next = next;
+            writePage(pageId, page);
+            pageId = next;
+            next = readPage(pageId).next;
+        }
+    }
+
+    // Page layout: kind(1) next(8) count(2), then per entry hash(4) key
+    // length(2) key, block(8) slot(4).
+    void writePage(std::size_t pageId, const Page &page) {
+        std::string out;
+        out.reserve(kPageHeaderBytes + page.entries.size() * (kEntryOverheadBytes + keyLength_));
+        appendUint(out, kBucketPageKind, 1);
+        appendUint(out, page.next == kNoPage ? std::numeric_limits<std::uint64_t>::max() : page.next, 8);
+        appendUint(out, page.entries.size(), 2);
+        for (const auto &entry : page.entries) {
+            appendUint(out, entry.hash, 4);
+            appendUint(out, entry.key.size(), 2);
+            out += entry.key;
+            appendUint(out, entry.pointer.address.index, 8);
+            appendUint(out, entry.pointer.slot, 4);
+        }
+        pages().writePage(pageId, out);
+    }
+
+    Page readPage(std::size_t pageId) const {
+        const std::string in = pages().readPage(pageId);
+        std::size_t pos = 0;
+        if (readUint(in, pos, 1, pageId) != kBucketPageKind) {
+            std::ostringstream oss;
+            oss << "index page #" << pageId << " is not a hash bucket page";
+            throw std::runtime_error(oss.str());
+        }
+        Page page;
+        const std::uint64_t next = readUint(in, pos, 8, pageId);
+        page.next = next == std::numeric_limits<std::uint64_t>::max() ? kNoPage : static_cast<std::size_t>(next);
+        const std::size_t count = static_cast<std::size_t>(readUint(in, pos, 2, pageId));
+        page.entries.resize(count);
+        for (auto &entry : page.entries) {
+            entry.hash = static_cast<std::uint32_t>(readUint(in, pos, 4, pageId));
+            const std::size_t length = static_cast<std::size_t>(readUint(in, pos, 2, pageId));
+            if (pos + length > in.size()) {
+                std::ostringstream oss;
+                oss << "corrupted index page #" << pageId;
+                throw std::runtime_error(oss.str());
+            }
+            entry.key = in.substr(pos, length);
+            pos += length;
+            entry.pointer.address = BlockAddress{pointerTable_, static_cast<std::size_t>(readUint(in, pos, 8, pageId))};
+            entry.pointer.slot = static_cast<std::size_t>(readUint(in, pos, 4, pageId));
+        }
+        return page;
+    }
+
+    void writeMeta(const std::string &path, bool clean) const {
+        pathutil::ensureParentDirectory(path);
+        const std::string tempPath = path + ".tmp";
+        {
+            std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+            out << "IDXHASH V1\n";
+            out << "PAGE_SIZE " << pageSize_ << "\n";
+            out << "KEY_LENGTH " << keyLength_ << "\n";
+            out << "DUPLICATES " << (duplicates_ ? 1 : 0) << "\n";
+            out << "LOCAL " << (store_ ? 0 : 1) << "\n";
+            out << "LEVEL " << level_ << "\n";
+            out << "SPLIT " << split_ << "\n";
+            out << "ENTRIES " << entries_ << "\n";
+            out << "USED " << usedPages_ << "\n";
+            out << "CLEAN " << (clean ? 1 : 0) << "\n";
+            out << "BUCKETS " << buckets_.size() << "\n";
+            for (auto pageId : buckets_) {
+                out << pageId << "\n";
+            }
+            out << "FREE " << freePages_.size() << "\n";
+            for (auto pageId : freePages_) {
+                out << pageId << "\n";
+            }
+            if (!store_) {
+                const auto ids = localStore_->pageIds();
+                out << "PAGES " << ids.size() << "\n";
+                for (auto pageId : ids) {
+                    out << pageId << " " << encodeHex(localStore_->readPage(pageId)) << "\n";
+                }
+            }
+            if (!out) {
+                throw std::runtime_error("failed to persist index file: " + path);
+            }
+        }
+        if (std::rename(tempPath.c_str(), path.c_str()) != 0) {
+            std::remove(path.c_str());
+            if (std::rename(tempPath.c_str(), path.c_str()) != 0) {
+                throw std::runtime_error("failed to replace index file: " + path);
+            }
+        }
+    }
+
+    static void appendUint(std::string &out, std::uint64_t value, std::size_t bytes) {
+        for (std::size_t i = 0; i < bytes; ++i) {
+            out.push_back(static_cast<char>((value >> (8U * i)) & 0xFFU));
+        }
+    }
+
+    static std::uint64_t readUint(const std::string &in, std::size_t &pos, std::size_t bytes, std::size_t pageId) {
+        if (pos + bytes > in.size()) {
+            std::ostringstream oss;
+            oss << "corrupted index page #" << pageId;
+            throw std::runtime_error(oss.str());
+        }
+        std::uint64_t value = 0;
+        for (std::size_t i = 0; i < bytes; ++i) {
+            value |= static_cast<std::uint64_t>(static_cast<unsigned char>(in[pos + i])) << (8U * i);
+        }
+        pos += bytes;
+        return value;
+    }
+
+    static std::string encodeHex(const std::string &input) {
+        static const char *digits = "0123456789abcdef";
+        std::string out;
+        out.reserve(input.size() * 2 + 1);
+        out.push_back('x');  // keeps an empty page from being an empty token
+        for (unsigned char ch : input) {
+            out.push_back(digits[ch >> 4]);
+            out.push_back(digits[ch & 0x0F]);
+        }
+        return out;
+    }
+
+    static std::string decodeHex(const std::string &input, const std::string &path) {
+        if (input.empty() || input[0] != 'x' || input.size() % 2 == 0) {
+            throw std::runtime_error("corrupted index file '" + path + "' page payload");
+        }
+        auto nibble = [&](char ch) {
+            if (ch >= '0' && ch <= '9') return ch - '0';
+            if (ch >= 'a' && ch <= 'f') return ch - 'a' + 10;
+            throw std::runtime_error("corrupted index file '" + path + "' page payload");
+        };
+        std::string out;
+        out.reserve(input.size() / 2);
+        for (std::size_t i = 1; i < input.size(); i += 2) {
+            out.push_back(static_cast<char>((nibble(input[i]) << 4) | nibble(input[i + 1])));
+        }
+        return out;
+    }
+
+    std::size_t pageSize_{0};
+    std::size_t keyLength_{0};
+    std::size_t entriesPerPage_{0};
+    bool duplicates_{false};
+    IndexPageStore *store_{nullptr};
+    std::unique_ptr<LocalPageStore> localStore_;
+    std::string pointerTable_;
+    std::vector<std::size_t> buckets_;
+    std::vector<std::size_t> freePages_;
+    std::size_t level_{0};
+    std::size_t split_{0};
+    std::size_t entries_{0};
+    std::size_t usedPages_{0};
+    bool changed_{false};
+    bool metaClean_{false};
+};
+
+} // namespace dbms
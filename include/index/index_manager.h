@@ -1,15 +1,44 @@
 #pragma once
 
+#include <algorithm>
+#include <functional>
+#include <memory>
 #include <optional>
+#include <stdexcept>
 #include <string>
 #include <utility>
 #include <vector>
 
 #include "common/types.h"
 #include "index/b_plus_tree.h"
+#include "index/bitmap_index.h"
+#include "index/hash_index.h"
 
 namespace dbms {
 
+// Structure behind an index: a B+ tree serves equality and ranges, a hash
+// table only equality, and bitmaps equality on few distinct values, with
+// AND/OR of several predicates combined before the table is read.
+enum class IndexMethod {
+    BPlusTree,
+    Hash,
+    Bitmap
+};
+
+struct IndexKeyColumn {
+    std::string name;
+    std::size_t index{0};
+    ColumnType type{ColumnType::String};
+    std::size_t keyLength{0};
+};
+
+// columnName, columnIndex and columnType describe the leading key column and
+// keyLength the whole key. A composite index lists every key column, in key
+// order, in compositeColumns; a single-column index leaves it empty. An index
+// with INCLUDE columns lists its key columns and then the included ones in
+// coveredColumns, each with its declared column length as keyLength, and
+// stores their values verbatim behind the key so it can answer queries on
+// them without reading the table.
 struct IndexDefinition {
     std::string name;
     std::string tableName;
@@ -17,19 +46,153 @@ struct IndexDefinition {
     std::size_t columnIndex{0};
     std::size_t keyLength{0};
     bool unique{true};
+    ColumnType columnType{ColumnType::String};
+    std::vector<IndexKeyColumn> compositeColumns{};
+    std::vector<IndexKeyColumn> coveredColumns{};
+    IndexMethod method{IndexMethod::BPlusTree};
+
+    bool composite() const {
+        return compositeColumns.size() > 1;
+    }
+
+    bool covering() const {
+        return !coveredColumns.empty();
+    }
+
+    bool hashed() const {
+        return method == IndexMethod::Hash;
+    }
+
+    bool bitmapped() const {
+        return method == IndexMethod::Bitmap;
+    }
+
+    // Whether keys can be visited in order.
+    bool ordered() const {
+        return method == IndexMethod::BPlusTree;
+    }
+
+    bool covers(const std::string &column) const {
+        return std::any_of(coveredColumns.begin(), coveredColumns.end(),
+                           [&](const IndexKeyColumn &covered) { return covered.name == column; });
+    }
+
+    // Longest key the tree stores: the key padded to keyLength, then each
+    // covered value behind a two-byte length.
+    std::size_t storedKeyLength() const {
+        std::size_t length = keyLength;
+        for (const auto &column : coveredColumns) {
+            length += 2 + column.keyLength;
+        }
+        return length;
+    }
+
+    std::vector<IndexKeyColumn> keyColumns() const {
+        if (composite()) {
+            return compositeColumns;
+        }
+        return {IndexKeyColumn{columnName, columnIndex, columnType, keyLength}};
+    }
+
+    // "a" or "a, b" for display.
+    std::string columnList() const {
+        std::string list;
+        for (const auto &column : keyColumns()) {
+            list += (list.empty() ? "" : ", ") + column.name;
+        }
+        return list;
+    }
+
+    // INCLUDE columns for display, empty when there are none.
+    std::string includeList() const {
+        std::string list;
+        for (std::size_t i = keyColumns().size(); i < coveredColumns.size(); ++i) {
+            list += (list.empty() ? "" : ", ") + coveredColumns[i].name;
+        }
+        return list;
+    }
 };
 
+// A composite key concatenates the keys of its columns, each part but the
+// last padded with zero bytes to its full width, so keys compare column by
+// column. Encoding fewer values than there are columns yields the prefix
+// shared by every key that starts with those values.
+inline std::string encodeCompositeIndexKey(const std::vector<std::string> &values,
+                                           const std::vector<IndexKeyColumn> &columns) {
+    std::string key;
+    for (std::size_t i = 0; i < values.size() && i < columns.size(); ++i) {
+        std::string part = encodeIndexKey(values[i], columns[i].type, columns[i].keyLength);
+        if (i + 1 < columns.size()) {
+            part.resize(columns[i].keyLength, '\0');
+        }
+        key += part;
+    }
+    return key;
+}
+
+// Values of the covered columns stored behind the key of a covering index,
+// in coveredColumns order.
+inline std::vector<std::string> decodeCoveredIndexValues(const std::string &storedKey,
+                                                         const IndexDefinition &definition) {
+    std::vector<std::string> values;
+    values.reserve(definition.coveredColumns.size());
+    std::size_t pos = definition.keyLength;
+    for (std::size_t i = 0; i < definition.coveredColumns.size(); ++i) {
+        if (pos + 2 > storedKey.size()) {
+            throw std::runtime_error("covering index key of " + definition.name + " is truncated");
+        }
+        const std::size_t length = (static_cast<unsigned char>(storedKey[pos]) << 8) |
+                                   static_cast<unsigned char>(storedKey[pos + 1]);
+        pos += 2;
+        if (pos + length > storedKey.size()) {
+            throw std::runtime_error("covering index key of " + definition.name + " is truncated");
+        }
+        values.push_back(storedKey.substr(pos, length));
+        pos += length;
+    }
+    return values;
+}
+
+// An index over one table, kept in a B+ tree, a linear hash table or a
+// bitmap per key as its IndexMethod says; all of them store the same encoded
+// keys.
 class BPlusTreeIndex {
 public:
     BPlusTreeIndex() = default;
 
-    BPlusTreeIndex(IndexDefinition def, std::size_t pageSizeBytes)
-        : definition_(std::move(def)),
-          tree_(pageSizeBytes, definition_.keyLength) {}
+    BPlusTreeIndex(IndexDefinition def, std::size_t pageSizeBytes) {
+        initialize(std::move(def), pageSizeBytes);
+    }
 
     void initialize(IndexDefinition def, std::size_t pageSizeBytes) {
         definition_ = std::move(def);
-        tree_.initialize(pageSizeBytes, definition_.keyLength);
+        if (definition_.hashed()) {
+            hash_.initialize(pageSizeBytes, definition_.storedKeyLength());
+            hash_.setAllowDuplicates(!definition_.unique);
+            return;
+        }
+        if (definition_.bitmapped()) {
+            bitmap_.initialize(pageSizeBytes, definition_.storedKeyLength());
+            bitmap_.setPointerTable(definition_.tableName);
+            return;
+        }
+        tree_.initialize(pageSizeBytes, definition_.storedKeyLength());
+        tree_.setAllowDuplicates(!definition_.unique);
+    }
+
+    // Stores the index as pages of `store` from now on. The current
+    // contents are dropped; callers load or rebuild afterwards.
+    void attachPageStore(std::unique_ptr<IndexPageStore> store) {
+        pageStore_ = std::move(store);
+        if (definition_.bitmapped()) {
+            bitmap_.attachPageStore(pageStore_.get());
+            return;
+        }
+        if (definition_.hashed()) {
+            hash_.attachPageStore(pageStore_.get(), definition_.tableName);
+            return;
+        }
+        tree_.attachPageStore(pageStore_.get(), definition_.tableName);
     }
 
     const IndexDefinition &definition() const {
@@ -37,68 +200,332 @@ public:
     }
 
     std::size_t entriesPerPage() const {
-        return tree_.entriesPerPage();
+        switch (definition_.method) {
+        case IndexMethod::Hash:
+            return hash_.entriesPerPage();
+        case IndexMethod::Bitmap:
+            return bitmap_.entriesPerPage();
+        default:
+            return tree_.entriesPerPage();
+        }
+    }
+
+    // B+ tree only; a hash index sizes its buckets by load factor.
+    void setBulkLoadFillFactor(double fillFactor) {
+        tree_.setBulkLoadFillFactor(fillFactor);
+    }
+
+    std::size_t pageCount() const {
+        switch (definition_.method) {
+        case IndexMethod::Hash:
+            return hash_.pageCount();
+        case IndexMethod::Bitmap:
+            return bitmap_.pageCount();
+        default:
+            return tree_.pageCount();
+        }
     }
 
     void rebuild(const std::vector<std::pair<std::string, IndexPointer>> &entries) {
-        tree_.bulkInsert(entries);
+        switch (definition_.method) {
+        case IndexMethod::Hash:
+            hash_.bulkInsert(entries);
+            break;
+        case IndexMethod::Bitmap:
+            bitmap_.bulkInsert(entries);
+            break;
+        default:
+            tree_.bulkInsert(entries);
+            break;
+        }
     }
 
     void insertRecord(const Record &record,
                       const BlockAddress &addr,
                       std::size_t slot) {
         const auto key = extractKey(record);
-        tree_.insertUnique(key, IndexPointer{addr, slot});
+        switch (definition_.method) {
+        case IndexMethod::Hash:
+            hash_.insert(key, IndexPointer{addr, slot});
+            break;
+        case IndexMethod::Bitmap:
+            bitmap_.insert(key, IndexPointer{addr, slot});
+            break;
+        default:
+            tree_.insert(key, IndexPointer{addr, slot});
+            break;
+        }
     }
 
+    // Records are updated in place, so a non-unique index only has to move
+    // the pointer when the key changes.
     void updateRecord(const Record &before,
                       const Record &after,
                       const BlockAddress &addr,
                       std::size_t slot) {
         const auto oldKey = extractKey(before);
         const auto newKey = extractKey(after);
-        if (oldKey == newKey) {
-            tree_.update(newKey, IndexPointer{addr, slot});
-            return;
+        const IndexPointer ptr{addr, slot};
+        switch (definition_.method) {
+        case IndexMethod::Hash:
+            applyUpdate(hash_, oldKey, newKey, ptr);
+            break;
+        case IndexMethod::Bitmap:
+            applyUpdate(bitmap_, oldKey, newKey, ptr);
+            break;
+        default:
+            applyUpdate(tree_, oldKey, newKey, ptr);
+            break;
         }
-        tree_.erase(oldKey);
-        tree_.insertUnique(newKey, IndexPointer{addr, slot});
     }
 
-    void deleteRecord(const Record &record) {
+    void deleteRecord(const Record &record, const BlockAddress &addr, std::size_t slot) {
         const auto key = extractKey(record);
-        tree_.erase(key);
+        switch (definition_.method) {
+        case IndexMethod::Hash:
+            applyDelete(hash_, key, IndexPointer{addr, slot});
+            break;
+        case IndexMethod::Bitmap:
+            applyDelete(bitmap_, key, IndexPointer{addr, slot});
+            break;
+        default:
+            applyDelete(tree_, key, IndexPointer{addr, slot});
+            break;
+        }
     }
 
+    // `key` is an encodeKey() result. A covering index stores it as the
+    // prefix of each key, ahead of the covered values.
     std::optional<IndexPointer> find(const std::string &key) const {
-        return tree_.find(key);
+        if (definition_.hashed()) {
+            return hash_.find(key);
+        }
+        if (definition_.bitmapped()) {
+            return bitmap_.find(key);
+        }
+        if (!definition_.covering()) {
+            return tree_.find(key);
+        }
+        std::optional<IndexPointer> result;
+        tree_.scan(key, true, [&](const std::string &stored, const IndexPointer &ptr) {
+            if (stored.compare(0, key.size(), key) == 0) {
+                result = ptr;
+            }
+            return false;
+        });
+        return result;
+    }
+
+    std::vector<IndexPointer> findAll(const std::string &key) const {
+        if (definition_.hashed()) {
+            return hash_.findAll(key);
+        }
+        if (definition_.bitmapped()) {
+            return bitmap_.findAll(key);
+        }
+        if (!definition_.covering()) {
+            return tree_.findAll(key);
+        }
+        std::vector<IndexPointer> result;
+        tree_.scan(key, true, [&](const std::string &stored, const IndexPointer &ptr) {
+            if (stored.compare(0, key.size(), key) != 0) {
+                return false;
+            }
+            result.push_back(ptr);
+            return true;
+        });
+        return result;
+    }
+
+    void scan(const std::optional<std::string> &lower,
+              bool lowerInclusive,
+              const std::function<bool(const std::string &, const IndexPointer &)> &visit) const {
+        if (!definition_.ordered()) {
+            throw std::logic_error("index " + definition_.name + " keeps no key order to scan");
+        }
+        tree_.scan(lower, lowerInclusive, visit);
+    }
+
+    // Rows of a bitmap index stored under `key`.
+    RowBitmap rowBitmap(const std::string &key) const {
+        if (!definition_.bitmapped()) {
+            throw std::logic_error("index " + definition_.name + " is not a bitmap index");
+        }
+        return bitmap_.rows(key);
     }
 
     std::vector<std::string> describePages() const {
-        return tree_.describePages();
+        switch (definition_.method) {
+        case IndexMethod::Hash:
+            return hash_.describePages();
+        case IndexMethod::Bitmap:
+            return bitmap_.describePages();
+        default:
+            return tree_.describePages();
+        }
     }
 
+    // Key stored for `record`.
     std::string projectKey(const Record &record) const {
         return extractKey(record);
     }
 
+    // Part of the stored key that lookups compare, as encodeKey() yields it
+    // for the record's key column values.
+    std::string projectSearchKey(const Record &record) const {
+        return searchKey(record);
+    }
+
+    // Maps a column value to the key it is stored under. For a composite
+    // index the value belongs to the leading column and the result is the
+    // prefix of every key starting with it.
+    std::string encodeKey(const std::string &value) const {
+        return encodeKey(std::vector<std::string>{value});
+    }
+
+    // Maps the values of the leading key columns to their key (prefix).
+    std::string encodeKey(const std::vector<std::string> &values) const {
+        std::string key;
+        if (!definition_.composite()) {
+            key = values.empty() ? std::string()
+                                 : encodeIndexKey(values.front(), definition_.columnType, definition_.keyLength);
+        } else {
+            key = encodeCompositeIndexKey(values, definition_.compositeColumns);
+        }
+        // Covered values follow a key padded to its full width.
+        if (definition_.covering() && !values.empty() && values.size() >= definition_.keyColumns().size()) {
+            key.resize(definition_.keyLength, '\0');
+        }
+        return key;
+    }
+
     void saveToFile(const std::string &path) const {
-        tree_.saveToFile(path);
+        switch (definition_.method) {
+        case IndexMethod::Hash:
+            hash_.saveToFile(path);
+            break;
+        case IndexMethod::Bitmap:
+            bitmap_.saveToFile(path);
+            break;
+        default:
+            tree_.saveToFile(path);
+            break;
+        }
+    }
+
+    void persistChanges(const std::string &path) {
+        switch (definition_.method) {
+        case IndexMethod::Hash:
+            hash_.persistChanges(path);
+            break;
+        case IndexMethod::Bitmap:
+            bitmap_.persistChanges(path);
+            break;
+        default:
+            tree_.persistChanges(path);
+            break;
+        }
+    }
+
+    void checkpoint(const std::string &path) {
+        switch (definition_.method) {
+        case IndexMethod::Hash:
+            hash_.checkpoint(path);
+            break;
+        case IndexMethod::Bitmap:
+            bitmap_.checkpoint(path);
+            break;
+        default:
+            tree_.checkpoint(path);
+            break;
+        }
     }
 
     void loadFromFile(const std::string &path) {
-        tree_.loadFromFile(path, tree_.pageSizeBytes(), definition_.keyLength);
+        switch (definition_.method) {
+        case IndexMethod::Hash:
+            hash_.loadFromFile(path, hash_.pageSizeBytes(), definition_.storedKeyLength());
+            break;
+        case IndexMethod::Bitmap:
+            bitmap_.loadFromFile(path, bitmap_.pageSizeBytes(), definition_.storedKeyLength());
+            break;
+        default:
+            tree_.loadFromFile(path, tree_.pageSizeBytes(), definition_.storedKeyLength());
+            break;
+        }
     }
 
 private:
+    template <typename Structure>
+    void applyUpdate(Structure &structure,
+                     const std::string &oldKey,
+                     const std::string &newKey,
+                     const IndexPointer &ptr) {
+        if (!definition_.unique) {
+            if (oldKey != newKey) {
+                structure.erase(oldKey, ptr);
+                structure.insert(newKey, ptr);
+            }
+            return;
+        }
+        if (oldKey == newKey) {
+            structure.update(newKey, ptr);
+            return;
+        }
+        structure.erase(oldKey);
+        structure.insertUnique(newKey, ptr);
+    }
+
+    template <typename Structure>
+    void applyDelete(Structure &structure, const std::string &key, const IndexPointer &ptr) {
+        if (!definition_.unique) {
+            structure.erase(key, ptr);
+            return;
+        }
+        structure.erase(key);
+    }
+
     std::string extractKey(const Record &record) const {
-        return sliceIndexKey(record,
-                             definition_.columnIndex,
-                             definition_.keyLength);
+        std::string key = searchKey(record);
+        for (const auto &column : definition_.coveredColumns) {
+            const std::string value = column.index < record.values.size() ? record.values[column.index]
+                                                                          : std::string();
+            key.push_back(static_cast<char>((value.size() >> 8) & 0xFF));
+            key.push_back(static_cast<char>(value.size() & 0xFF));
+            key += value;
+        }
+        return key;
+    }
+
+    std::string searchKey(const Record &record) const {
+        if (definition_.covering()) {
+            std::vector<std::string> values;
+            for (const auto &column : definition_.keyColumns()) {
+                values.push_back(column.index < record.values.size() ? record.values[column.index]
+                                                                     : std::string());
+            }
+            return encodeKey(values);
+        }
+        if (!definition_.composite()) {
+            return sliceIndexKey(record,
+                                 definition_.columnIndex,
+                                 definition_.keyLength,
+                                 definition_.columnType);
+        }
+        std::vector<std::string> values;
+        values.reserve(definition_.compositeColumns.size());
+        for (const auto &column : definition_.compositeColumns) {
+            values.push_back(column.index < record.values.size() ? record.values[column.index]
+                                                                 : std::string());
+        }
+        return encodeCompositeIndexKey(values, definition_.compositeColumns);
     }
 
     IndexDefinition definition_;
+    std::unique_ptr<IndexPageStore> pageStore_;
     BPlusTree tree_;
+    LinearHashIndex hash_;
+    BitmapIndex bitmap_;
 };
 
 } // namespace dbms
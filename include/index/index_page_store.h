@@ -0,0 +1,117 @@
+#pragma once
+
+#include <cstddef>
+#include <optional>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "common/types.h"
+#include "index/b_plus_tree.h"
+#include "storage/buffer_pool.h"
+#include "storage/disk_manager.h"
+#include "storage/page.h"
+#include "storage/page_guard.h"
+
+namespace dbms {
+
+// Keeps each B+ tree node as a single record inside its own block of the
+// segment `idx.<index name>`, so index pages are allocated by DiskStorage
+// and cached, evicted and flushed by the shared BufferPool like table blocks.
+// Its fetches go through the pool's PageGuards, so that table blocks held by
+// a caller are fetched again if an index page evicts them.
+class BufferPoolIndexPageStore : public IndexPageStore {
+public:
+    BufferPoolIndexPageStore(PageGuards &guards,
+                             DiskStorage &disk,
+                             std::string segment,
+                             std::size_t blockSizeBytes)
+        : guards_(guards),
+          disk_(disk),
+          segment_(std::move(segment)),
+          blockSize_(blockSizeBytes) {
+        for (const auto &block : disk_.loadExistingBlocks(segment_)) {
+            pages_.push_back(block.address.index);
+        }
+    }
+
+    static std::string segmentFor(const std::string &indexName) {
+        return "idx." + indexName;
+    }
+
+    std::size_t pageCapacity() const override {
+        Record empty;
+        empty.values.emplace_back();
+        const std::size_t overhead =
+            VariableLengthPage::estimatePayload(empty) + VariableLengthPage::kSlotOverheadBytes;
+        return blockSize_ > overhead ? blockSize_ - overhead : 0;
+    }
+
+    std::vector<std::size_t> pageIds() const override {
+        return pages_;
+    }
+
+    std::size_t allocatePage() override {
+        const auto addr = disk_.allocateBlock(segment_);
+        pages_.push_back(addr.index);
+        return addr.index;
+    }
+
+    std::string readPage(std::size_t pageId) override {
+        auto fetchResult = guards_.fetch(BlockAddress{segment_, pageId}, false);
+        fetchResult.block.ensureInitialized(blockSize_);
+        const auto slots = fetchResult.block.slotCount();
+        for (std::size_t slot = 0; slot < slots; ++slot) {
+            const Record *record = fetchResult.block.getRecord(slot);
+            if (record && record->values.size() == 1) {
+                return record->values.front();
+            }
+        }
+        std::ostringstream oss;
+        oss << "index page " << segment_ << "#" << pageId << " is empty";
+        throw std::runtime_error(oss.str());
+    }
+
+    void writePage(std::size_t pageId, const std::string &payload) override {
+        auto fetchResult = guards_.fetch(BlockAddress{segment_, pageId}, true);
+        Block &block = fetchResult.block;
+        block.ensureInitialized(blockSize_);
+        Record record;
+        record.values.push_back(payload);
+        const auto slots = block.slotCount();
+        std::size_t live = 0;
+        std::optional<std::size_t> liveSlot;
+        for (std::size_t slot = 0; slot < slots; ++slot) {
+            if (block.getRecord(slot)) {
+                ++live;
+                liveSlot = slot;
+            }
+        }
+        if (live == 1 && block.updateRecord(*liveSlot, record)) {
+            return;
+        }
+        for (std::size_t slot = 0; slot < slots; ++slot) {
+            if (block.getRecord(slot)) {
+                block.eraseRecord(slot);
+            }
+        }
+        block.vacuumDeletedSlots();
+        if (!block.insertRecord(std::move(record)).has_value()) {
+            std::ostringstream oss;
+            oss << "index page " << segment_ << "#" << pageId << " overflows its block ("
+                << payload.size() << " bytes)";
+            throw std::runtime_error(oss.str());
+        }
+    }
+
+private:
+    PageGuards &guards_;
+    DiskStorage &disk_;
+    std::string segment_;
+    std::size_t blockSize_;
+    std::vector<std::size_t> pages_;
+};
+
+} // namespace dbms
@@ -0,0 +1,348 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#include <immintrin.h>
+#define DBMS_NODE_KEYS_X86 1
+#endif
+
+namespace dbms {
+
+namespace detail {
+
+// Three-way comparison of two equally long byte ranges, like memcmp. The
+// vector kernels may read up to 31 bytes past either range; NodeKeys keeps
+// that much slack behind its slots and its probe buffers.
+using KeyCompareKernel = int (*)(const unsigned char *, const unsigned char *, std::size_t);
+
+inline int compareKeyBytesPortable(const unsigned char *a, const unsigned char *b, std::size_t n) {
+    return std::memcmp(a, b, n);
+}
+
+#ifdef DBMS_NODE_KEYS_X86
+__attribute__((target("sse2"))) inline int compareKeyBytesSse2(const unsigned char *a,
+                                                               const unsigned char *b,
+                                                               std::size_t n) {
+    for (std::size_t i = 0; i < n; i += 16) {
+        const __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i *>(a + i));
+        const __m128i y = _mm_loadu_si128(reinterpret_cast<const __m128i *>(b + i));
+        unsigned differ = ~static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(x, y))) & 0xFFFFu;
+        if (n - i < 16) {
+            differ &= (1u << (n - i)) - 1u;
+        }
+        if (differ != 0) {
+            const std::size_t at = i + static_cast<std::size_t>(__builtin_ctz(differ));
+            return a[at] < b[at] ? -1 : 1;
+        }
+    }
+    return 0;
+}
+
+__attribute__((target("avx2"))) inline int compareKeyBytesAvx2(const unsigned char *a,
+                                                               const unsigned char *b,
+                                                               std::size_t n) {
+    for (std::size_t i = 0; i < n; i += 32) {
+        const __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + i));
+        const __m256i y = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(b + i));
+        std::uint32_t differ = ~static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(x, y)));
+        if (n - i < 32) {
+            differ &= (1u << (n - i)) - 1u;
+        }
+        if (differ != 0) {
+            const std::size_t at = i + static_cast<std::size_t>(__builtin_ctz(differ));
+            return a[at] < b[at] ? -1 : 1;
+        }
+    }
+    return 0;
+}
+#endif
+
+inline KeyCompareKernel selectKeyCompareKernel() {
+#ifdef DBMS_NODE_KEYS_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return compareKeyBytesAvx2;
+    }
+    if (__builtin_cpu_supports("sse2")) {
+        return compareKeyBytesSse2;
+    }
+#endif
+    return compareKeyBytesPortable;
+}
+
+// Picked once per process from what the CPU supports.
+inline KeyCompareKernel keyCompareKernel() {
+    static const KeyCompareKernel kernel = selectKeyCompareKernel();
+    return kernel;
+}
+
+} // namespace detail
+
+// Sorted keys of one B+ tree node, stored back to back in fixed-width,
+// zero-padded slots of a single buffer instead of one heap string per key.
+// Two padded slots compare like the keys they hold once equal slots are
+// ordered by length, so a probe is a binary search of block compares over
+// contiguous memory. A prefix shared by every key is kept once and the slots
+// only hold what follows it; compact() lengthens it to the longest common
+// prefix, and inserting a key outside it shortens it again. The slot width
+// starts at the index key length less the prefix and grows if a longer
+// suffix arrives.
+class NodeKeys {
+public:
+    NodeKeys() = default;
+
+    explicit NodeKeys(std::size_t width)
+        : widthHint_(width),
+          width_(width) {}
+
+    std::size_t size() const {
+        return lengths_.size();
+    }
+
+    bool empty() const {
+        return lengths_.empty();
+    }
+
+    void reserve(std::size_t count) {
+        lengths_.reserve(count);
+        slab_.reserve(count * width_ + kSlack);
+    }
+
+    const std::string &prefix() const {
+        return prefix_;
+    }
+
+    // Key bytes after prefix().
+    std::string_view suffix(std::size_t index) const {
+        return std::string_view(slot(index), lengths_[index]);
+    }
+
+    std::size_t keySize(std::size_t index) const {
+        return prefix_.size() + lengths_[index];
+    }
+
+    // Sum of the full key lengths.
+    std::size_t totalKeyBytes() const {
+        return suffixBytes_ + prefix_.size() * size();
+    }
+
+    // Longest prefix shared by every key, which for sorted keys is the one
+    // shared by the first and the last.
+    std::size_t commonPrefixLength() const {
+        if (size() < 2) {
+            return size() == 1 ? keySize(0) : prefix_.size();
+        }
+        return prefix_.size() + sharedPrefixLength(suffix(0), suffix(size() - 1));
+    }
+
+    std::string operator[](std::size_t index) const {
+        std::string key;
+        key.reserve(keySize(index));
+        key += prefix_;
+        key.append(slot(index), lengths_[index]);
+        return key;
+    }
+
+    std::string front() const {
+        return (*this)[0];
+    }
+
+    std::string back() const {
+        return (*this)[size() - 1];
+    }
+
+    // Appends the bytes of key `index` from offset `from` on to `out`.
+    void appendKey(std::string &out, std::size_t index, std::size_t from = 0) const {
+        if (from < prefix_.size()) {
+            out.append(prefix_, from, std::string::npos);
+            from = prefix_.size();
+        }
+        out.append(slot(index) + (from - prefix_.size()), keySize(index) - from);
+    }
+
+    void set(std::size_t index, const std::string &key) {
+        admit(key);
+        suffixBytes_ -= lengths_[index];
+        write(index, key);
+    }
+
+    void insert(std::size_t index, const std::string &key) {
+        admit(key);
+        slab_.resize((size() + 1) * width_ + kSlack, '\0');
+        char *base = &slab_[0];
+        std::memmove(base + (index + 1) * width_, base + index * width_, (size() - index) * width_);
+        lengths_.insert(lengths_.begin() + static_cast<std::ptrdiff_t>(index), 0);
+        write(index, key);
+    }
+
+    void push_back(const std::string &key) {
+        insert(size(), key);
+    }
+
+    void pop_back() {
+        truncate(size() - 1);
+    }
+
+    void erase(std::size_t index) {
+        suffixBytes_ -= lengths_[index];
+        char *base = &slab_[0];
+        std::memmove(base + index * width_, base + (index + 1) * width_, (size() - index - 1) * width_);
+        lengths_.erase(lengths_.begin() + static_cast<std::ptrdiff_t>(index));
+        slab_.resize(size() * width_ + kSlack);
+    }
+
+    // Keeps the first `count` keys.
+    void truncate(std::size_t count) {
+        for (std::size_t i = count; i < size(); ++i) {
+            suffixBytes_ -= lengths_[i];
+        }
+        lengths_.resize(count);
+        slab_.resize(count * width_ + kSlack);
+    }
+
+    // Appends keys [first, last) of `other`.
+    void append(const NodeKeys &other, std::size_t first, std::size_t last) {
+        for (std::size_t i = first; i < last; ++i) {
+            push_back(other[i]);
+        }
+    }
+
+    // Moves every byte the keys share into prefix() and narrows the slots.
+    void compact() {
+        const std::size_t shared = size() == 0 ? prefix_.size() : commonPrefixLength();
+        if (shared == prefix_.size() && !slab_.empty()) {
+            return;
+        }
+        relayout(size() == 0 ? prefix_ : (*this)[0].substr(0, shared));
+    }
+
+    // First position whose key is not less than `key`.
+    std::size_t lowerBound(const std::string &key) const {
+        return search(key, false);
+    }
+
+    // First position whose key is greater than `key`.
+    std::size_t upperBound(const std::string &key) const {
+        return search(key, true);
+    }
+
+    bool matches(std::size_t index, const std::string &key) const {
+        return index < size() && key.size() == keySize(index) &&
+               key.compare(0, prefix_.size(), prefix_) == 0 &&
+               std::memcmp(key.data() + prefix_.size(), slot(index), lengths_[index]) == 0;
+    }
+
+private:
+    static constexpr std::size_t kSlack = 32;
+    static constexpr std::size_t kInlineProbe = 256;
+
+    static std::size_t sharedPrefixLength(std::string_view a, std::string_view b) {
+        const std::size_t limit = std::min(a.size(), b.size());
+        std::size_t shared = 0;
+        while (shared < limit && a[shared] == b[shared]) {
+            ++shared;
+        }
+        return shared;
+    }
+
+    const char *slot(std::size_t index) const {
+        return slab_.data() + index * width_;
+    }
+
+    // Writes the part of `key` after the prefix into slot `index`.
+    void write(std::size_t index, const std::string &key) {
+        const std::size_t length = key.size() - prefix_.size();
+        char *target = &slab_[index * width_];
+        std::memcpy(target, key.data() + prefix_.size(), length);
+        std::memset(target + length, 0, width_ - length);
+        lengths_[index] = static_cast<std::uint32_t>(length);
+        suffixBytes_ += length;
+    }
+
+    // Shortens the prefix to what `key` shares with it and widens the slots
+    // until the suffix of `key` fits.
+    void admit(const std::string &key) {
+        const std::size_t shared = sharedPrefixLength(prefix_, key);
+        if (shared < prefix_.size()) {
+            relayout(prefix_.substr(0, shared));
+        }
+        if (key.size() - prefix_.size() > width_ || slab_.empty()) {
+            relayout(prefix_, key.size() - prefix_.size());
+        }
+    }
+
+    void relayout(const std::string &prefix, std::size_t minWidth = 0) {
+        std::size_t width = std::max(minWidth, widthHint_ > prefix.size() ? widthHint_ - prefix.size() : 0);
+        std::vector<std::string> keys;
+        keys.reserve(size());
+        for (std::size_t i = 0; i < size(); ++i) {
+            keys.push_back((*this)[i]);
+            width = std::max(width, keys.back().size() - prefix.size());
+        }
+        prefix_ = prefix;
+        width_ = width;
+        slab_.assign(keys.size() * width_ + kSlack, '\0');
+        suffixBytes_ = 0;
+        for (std::size_t i = 0; i < keys.size(); ++i) {
+            write(i, keys[i]);
+        }
+    }
+
+    std::size_t search(const std::string &key, bool upper) const {
+        // Keys outside the shared prefix sort before or after all of them.
+        const std::size_t head = std::min(key.size(), prefix_.size());
+        const int order = key.compare(0, head, prefix_, 0, head);
+        if (order != 0) {
+            return order < 0 ? 0 : size();
+        }
+        if (key.size() < prefix_.size()) {
+            return 0;
+        }
+        const std::size_t probeLength = key.size() - prefix_.size();
+
+        std::array<unsigned char, kInlineProbe + kSlack> inlineProbe;
+        std::vector<unsigned char> heapProbe;
+        unsigned char *probe = inlineProbe.data();
+        if (width_ > kInlineProbe) {
+            heapProbe.resize(width_ + kSlack);
+            probe = heapProbe.data();
+        }
+        const std::size_t copied = std::min(probeLength, width_);
+        std::memcpy(probe, key.data() + prefix_.size(), copied);
+        std::memset(probe + copied, 0, width_ + kSlack - copied);
+
+        const auto kernel = detail::keyCompareKernel();
+        std::size_t low = 0;
+        std::size_t high = size();
+        while (low < high) {
+            const std::size_t mid = low + (high - low) / 2;
+            int cmp = kernel(reinterpret_cast<const unsigned char *>(slot(mid)), probe, width_);
+            if (cmp == 0) {
+                cmp = lengths_[mid] < probeLength ? -1 : (lengths_[mid] > probeLength ? 1 : 0);
+            }
+            if (cmp < 0 || (upper && cmp == 0)) {
+                low = mid + 1;
+            } else {
+                high = mid;
+            }
+        }
+        return low;
+    }
+
+    std::size_t widthHint_{0};
+    std::size_t width_{0};
+    std::string prefix_;
+    std::string slab_;
+    std::vector<std::uint32_t> lengths_;
+    std::size_t suffixBytes_{0};
+};
+
+} // namespace dbms
@@ -18,7 +18,7 @@ enum class TokenType {
     // Keywords
     SELECT, FROM, WHERE, AND, OR, NOT, JOIN, ON, INNER, LEFT, RIGHT,
     ORDER, BY, GROUP, HAVING, AS, DISTINCT, ALL, LIMIT, OFFSET,
-    INSERT, INTO, VALUES, UPDATE, SET, DELETE,
+    INSERT, INTO, VALUES, UPDATE, SET, DELETE, BETWEEN, LIKE,
     // Operators
     EQUAL, NOT_EQUAL, LESS, LESS_EQUAL, GREATER, GREATER_EQUAL,
     PLUS, MINUS, STAR, SLASH, PERCENT,
@@ -122,11 +122,13 @@ struct RelAlgNode {
 enum class PhysicalOpType {
     kTableScan,
     kIndexScan,
+    kBitmapScan,
     kFilter,
     kProjection,
     kDistinct,
     kNestedLoopJoin,
     kHashJoin,
+    kIndexNestedLoopJoin,
     kMergeJoin,
     kSort,
     kAggregate,
@@ -246,6 +248,31 @@ private:
     std::shared_ptr<RelAlgNode> applyRule(std::shared_ptr<RelAlgNode> node);
 };
 
+// Key interval on one column, derived from the conjuncts of a selection
+struct ColumnKeyRange {
+    std::string column;
+    std::optional<std::string> lower;
+    bool lowerInclusive{true};
+    std::optional<std::string> upper;
+    bool upperInclusive{true};
+};
+
+// Equality values for the leading columns of a composite index and the key
+// interval on the column after them
+struct CompositeKeyRange {
+    std::string index;
+    std::vector<std::string> prefix;
+    ColumnKeyRange next;
+};
+
+// Equality predicates answered by bitmap indexes: each conjunct lists
+// (index, value) terms that are ORed together. `complete` is set when every
+// conjunct of the selection could be expressed this way
+struct BitmapCondition {
+    std::vector<std::vector<std::pair<std::string, std::string>>> conjuncts;
+    bool complete{false};
+};
+
 // Physical Plan Generator
 class PhysicalPlanGenerator {
 public:
@@ -256,10 +283,19 @@ private:
     std::shared_ptr<PhysicalPlanNode> convertNode(std::shared_ptr<RelAlgNode> node);
     std::shared_ptr<PhysicalPlanNode> chooseScanMethod(std::shared_ptr<RelAlgNode> node);
     std::shared_ptr<PhysicalPlanNode> chooseJoinMethod(std::shared_ptr<RelAlgNode> node);
+    std::shared_ptr<PhysicalPlanNode> chooseIndexJoin(std::shared_ptr<RelAlgNode> node);
+    std::optional<std::size_t> estimateRows(std::shared_ptr<RelAlgNode> node);
+    void chooseIndexOnlyScan(std::shared_ptr<PhysicalPlanNode> projection);
     int estimateCost(std::shared_ptr<PhysicalPlanNode> node);
     bool hasIndex(const std::string& tableName, const std::string& columnName);
     std::optional<std::pair<std::string, std::string>> extractColumnLiteralEquality(const std::string& condition);
     std::optional<std::pair<std::string, std::string>> extractJoinColumns(const std::string& condition);
+    std::optional<std::pair<ColumnKeyRange, std::string>> extractIndexedRange(const std::string& table,
+                                                                              const std::string& condition);
+    std::optional<CompositeKeyRange> extractCompositeRange(const std::string& table,
+                                                           const std::string& condition);
+    std::optional<BitmapCondition> extractBitmapCondition(const std::string& table, const std::string& condition);
+    std::vector<ColumnKeyRange> collectColumnRanges(const std::string& table, const std::string& condition);
     static std::string stripTablePrefix(const std::string& name);
 };
 
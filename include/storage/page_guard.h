@@ -0,0 +1,196 @@
+#pragma once
+
+#include <cstddef>
+#include <unordered_map>
+#include <utility>
+
+#include "common/types.h"
+#include "storage/buffer_pool.h"
+#include "storage/page.h"
+
+namespace dbms {
+
+class PageGuards;
+
+// A block held by a caller until the guard is destroyed or released. The
+// Block reference it hands out stays valid only until the next fetch from
+// the same pool, so callers go back through the guard after anything that
+// may fetch (index maintenance, a second block) instead of keeping it.
+class PageGuard {
+public:
+    PageGuard(PageGuard &&other) noexcept
+        : owner_(std::exchange(other.owner_, nullptr)),
+          address_(std::move(other.address_)),
+          block_(other.block_),
+          generation_(other.generation_),
+          forWrite_(other.forWrite_) {}
+
+    PageGuard &operator=(PageGuard &&other) noexcept {
+        if (this != &other) {
+            release();
+            owner_ = std::exchange(other.owner_, nullptr);
+            address_ = std::move(other.address_);
+            block_ = other.block_;
+            generation_ = other.generation_;
+            forWrite_ = other.forWrite_;
+        }
+        return *this;
+    }
+
+    PageGuard(const PageGuard &) = delete;
+    PageGuard &operator=(const PageGuard &) = delete;
+
+    ~PageGuard() {
+        release();
+    }
+
+    const BlockAddress &address() const {
+        return address_;
+    }
+
+    explicit operator bool() const {
+        return owner_ != nullptr;
+    }
+
+    inline void release();
+
+protected:
+    inline PageGuard(PageGuards &owner, const BlockAddress &address, bool forWrite);
+
+    inline Block &current() const;
+
+private:
+    PageGuards *owner_;
+    BlockAddress address_;
+    mutable Block *block_{nullptr};
+    mutable std::size_t generation_{0};
+    bool forWrite_;
+};
+
+class ReadPageGuard : public PageGuard {
+public:
+    const Block &block() const {
+        return current();
+    }
+
+    const Block *operator->() const {
+        return &current();
+    }
+
+private:
+    friend class PageGuards;
+    ReadPageGuard(PageGuards &owner, const BlockAddress &address) : PageGuard(owner, address, false) {}
+};
+
+class WritePageGuard : public PageGuard {
+public:
+    Block &block() {
+        return current();
+    }
+
+    Block *operator->() {
+        return &current();
+    }
+
+private:
+    friend class PageGuards;
+    WritePageGuard(PageGuards &owner, const BlockAddress &address) : PageGuard(owner, address, true) {}
+};
+
+// Fetches blocks from a BufferPool on behalf of guards. The pool pins
+// nothing and may evict a guarded block when a later fetch needs its frame.
+// Every fetch of the pool therefore goes through here. When one evicts a
+// guarded block, its guards fetch it again the next time they are used. A
+// write guard's changes reach the files with the evicted dirty frame, so
+// the block it gets back carries them.
+class PageGuards {
+public:
+    PageGuards(BufferPool &pool, std::size_t blockSize) : pool_(pool), blockSize_(blockSize) {}
+
+    ReadPageGuard read(const BlockAddress &address) {
+        return ReadPageGuard(*this, address);
+    }
+
+    WritePageGuard write(const BlockAddress &address) {
+        return WritePageGuard(*this, address);
+    }
+
+    // For callers that are done with the block before their next fetch.
+    BufferPool::FetchResult fetch(const BlockAddress &address, bool forWrite) {
+        auto result = pool_.fetch(address, forWrite);
+        if (result.evicted) {
+            auto it = pins_.find(*result.evicted);
+            if (it != pins_.end()) {
+                ++it->second.generation;
+            }
+        }
+        result.block.ensureInitialized(blockSize_);
+        return result;
+    }
+
+    // Blocks that currently have at least one guard.
+    std::size_t guardedBlocks() const {
+        return pins_.size();
+    }
+
+    // Times a guard found its block evicted and fetched it again.
+    std::size_t refetches() const {
+        return refetches_;
+    }
+
+private:
+    friend class PageGuard;
+
+    struct Pin {
+        std::size_t guards{0};
+        std::size_t generation{0};
+    };
+
+    std::size_t pin(const BlockAddress &address) {
+        auto &pin = pins_[address];
+        ++pin.guards;
+        return pin.generation;
+    }
+
+    void unpin(const BlockAddress &address) {
+        auto it = pins_.find(address);
+        if (it != pins_.end() && --it->second.guards == 0) {
+            pins_.erase(it);
+        }
+    }
+
+    std::size_t generation(const BlockAddress &address) const {
+        return pins_.at(address).generation;
+    }
+
+    BufferPool &pool_;
+    std::size_t blockSize_;
+    std::unordered_map<BlockAddress, Pin, BlockAddressHash> pins_;
+    std::size_t refetches_{0};
+};
+
+PageGuard::PageGuard(PageGuards &owner, const BlockAddress &address, bool forWrite)
+    : owner_(&owner), address_(address), forWrite_(forWrite) {
+    generation_ = owner_->pin(address_);
+    block_ = &owner_->fetch(address_, forWrite_).block;
+}
+
+void PageGuard::release() {
+    if (owner_ != nullptr) {
+        owner_->unpin(address_);
+        owner_ = nullptr;
+        block_ = nullptr;
+    }
+}
+
+Block &PageGuard::current() const {
+    const std::size_t generation = owner_->generation(address_);
+    if (generation != generation_) {
+        block_ = &owner_->fetch(address_, forWrite_).block;
+        generation_ = owner_->generation(address_);
+        ++owner_->refetches_;
+    }
+    return *block_;
+}
+
+} // namespace dbms
@@ -71,8 +71,18 @@ public:
                 const auto &info = entry.second;
                 oss << "  * " << info.definition.name << " ON "
                     << info.definition.tableName << "("
-                    << info.definition.columnName << ") -> "
-                    << info.entriesPerPage << " entry/entries per page\n";
+                    << info.definition.columnList() << ")";
+                if (info.definition.covering()) {
+                    oss << " INCLUDE (" << info.definition.includeList() << ")";
+                }
+                if (!info.definition.ordered()) {
+                    oss << (info.definition.hashed() ? " USING HASH" : " USING BITMAP");
+                }
+                if (info.entriesPerPage == 0) {
+                    oss << " -> not opened\n";
+                } else {
+                    oss << " -> " << info.entriesPerPage << " entry/entries per page\n";
+                }
             }
         }
         return oss.str();
@@ -98,8 +108,18 @@ public:
             std::ostringstream oss;
             oss << "SYS_INDEXES | " << info.definition.name
                 << " | table=" << info.definition.tableName
-                << " | column=" << info.definition.columnName
-                << " | entries/page=" << info.entriesPerPage;
+                << " | column=" << info.definition.columnList();
+            if (info.definition.covering()) {
+                oss << " | include=" << info.definition.includeList();
+            }
+            if (!info.definition.ordered()) {
+                oss << " | method=" << (info.definition.hashed() ? "hash" : "bitmap");
+            }
+            if (info.entriesPerPage == 0) {
+                oss << " | not opened";
+            } else {
+                oss << " | entries/page=" << info.entriesPerPage;
+            }
             rows.push_back(oss.str());
         }
         if (rows.empty()) {
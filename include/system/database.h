@@ -3,13 +3,19 @@
 #include <algorithm>
 #include <cstddef>
 #include <deque>
+#include <exception>
 #include <fstream>
+#include <functional>
 #include <iostream>
+#include <iterator>
+#include <map>
+#include <memory>
 #include <optional>
 #include <random>
 #include <sstream>
 #include <stdexcept>
 #include <string>
+#include <thread>
 #include <unordered_map>
 #include <unordered_set>
 #include <utility>
@@ -18,10 +24,14 @@
 #include "common/types.h"
 #include "common/utils.h"
 #include "index/index_manager.h"
+#include "index/index_page_store.h"
 #include "storage/buffer_pool.h"
 #include "storage/disk_manager.h"
+#include "storage/page_guard.h"
 #include "storage/write_ahead_log.h"
 #include "system/catalog.h"
+#include "system/read_ahead.h"
+#include "system/scan_ring.h"
 #include "system/table.h"
 #include "parser/query_processor.h"
 
@@ -59,6 +69,14 @@ namespace dbms {
             bool active{false};
         };
 
+        // One row's history in the committed part of the WAL: every image it
+        // had, oldest first.
+        struct WalRowChain {
+            std::vector<Record> images;
+            bool inserted{false};  // the row did not exist before the chain
+            bool deleted{false};
+        };
+
     public:
         struct TableDumpRow {
             std::size_t blockIndex{0};
@@ -84,6 +102,7 @@ namespace dbms {
                     storagePath_,
                     blockSizeBytes),
               buffer_(computeBufferCapacity(mainMemoryBytes, blockSizeBytes), disk_),
+              pages_(buffer_, blockSizeBytes),
               dictionary_(static_cast<std::size_t>(mainMemoryBytes * 0.15)),
           planCache_(static_cast<std::size_t>(mainMemoryBytes * 0.15),
                      planCacheFilePath(storagePath_)),
@@ -183,10 +202,83 @@ namespace dbms {
             return disk_.freeBlocks();
         }
 
+        // Worker threads used to scan and sort when an index is built or
+        // rebuilt; 0 picks one per hardware thread.
+        void setIndexBuildThreads(std::size_t threads) {
+            indexBuildThreads_ = threads == 0 ? defaultIndexBuildThreads() : threads;
+        }
+
+        std::size_t indexBuildThreads() const {
+            return indexBuildThreads_;
+        }
+
+        // Most blocks a sequential table scan has read ahead of it on a
+        // background thread; 0 turns read-ahead off. The reader's copy of
+        // each block competes with the scan on a single core, so it is off
+        // by default there.
+        static std::size_t defaultReadAheadDepth() {
+            return std::thread::hardware_concurrency() > 1 ? kDefaultReadAheadDepth : 0;
+        }
+
+        void setReadAheadDepth(std::size_t blocks) {
+            readAheadDepth_ = blocks;
+        }
+
+        std::size_t readAheadDepth() const {
+            return readAheadDepth_;
+        }
+
+        const ReadAheadStats &readAheadStats() const {
+            return readAheadStats_;
+        }
+
+        // Bulk reads of a table larger than a quarter of the shared pool go
+        // through a private ring, so that one scan cannot evict the working
+        // set. Returns null for smaller tables. The shared pool is flushed
+        // first so that the ring reads current block files.
+        std::unique_ptr<ScanRing> startBulkRead(std::size_t tableBlocks) {
+            if (tableBlocks <= buffer_.capacity() / 4) {
+                return nullptr;
+            }
+            buffer_.flush();
+            return std::make_unique<ScanRing>(disk_.totalBlocks(), storagePath_, blockSize_, tableBlockWrites_);
+        }
+
+        // Reads a block for a bulk read: through `ring` while no table block
+        // has been written since it was opened, through the shared pool
+        // otherwise, so a statement that writes while it scans sees its own
+        // changes.
+        BufferPool::FetchResult fetchBulk(ScanRing *ring, const BlockAddress &addr) {
+            if (ring != nullptr && ring->writeEpoch() == tableBlockWrites_) {
+                ++bulkRingFetches_;
+                return ring->pool().fetch(addr, false);
+            }
+            return pages_.fetch(addr, false);
+        }
+
+        std::size_t bulkRingFetches() const {
+            return bulkRingFetches_;
+        }
+
+        // Starts a reader for a scan over `blocks`, or returns null when
+        // read-ahead is off or the table is too small to gain from it.
+        std::unique_ptr<BlockReadAhead> startReadAhead(const std::vector<BlockAddress> &blocks) {
+            if (readAheadDepth_ == 0 || blocks.size() < kMinReadAheadBlocks) {
+                return nullptr;
+            }
+            return std::make_unique<BlockReadAhead>(blocks, disk_.totalBlocks(), storagePath_, blockSize_,
+                                                    readAheadDepth_, readAheadStats_);
+        }
+
         BufferPool &buffer() {
             return buffer_;
         }
 
+        // Every fetch from the shared pool goes through here; see PageGuards.
+        PageGuards &pages() {
+            return pages_;
+        }
+
         bool inTransaction() const {
             return transactionActive_;
         }
@@ -216,7 +308,7 @@ namespace dbms {
             currentTxnId_.reset();
             logBuffer_.append("commit");
             logBuffer_.flushToDisk();
-            buffer_.flush();
+            checkpoint();
         }
 
         void rollbackTransaction() {
@@ -239,7 +331,7 @@ namespace dbms {
             currentTxnId_.reset();
             logBuffer_.append("rollback");
             logBuffer_.flushToDisk();
-            buffer_.flush();
+            checkpoint();
         }
 
 
@@ -264,35 +356,37 @@ namespace dbms {
                 table.addBlock(addr);
             }
 
-            auto fetchResult = buffer_.fetch(table.lastBlock(), true);
-            fetchResult.block.ensureInitialized(blockSize_);
-            Block *targetBlock = &fetchResult.block;
-            if (!targetBlock->hasSpaceFor(record)) {
+            auto target = writeTableBlock(table.lastBlock());
+            if (!target->hasSpaceFor(record)) {
                 auto addr = disk_.allocateBlock(tableName);
                 table.addBlock(addr);
-                auto newFetch = buffer_.fetch(addr, true);
-                newFetch.block.ensureInitialized(blockSize_);
-                targetBlock = &newFetch.block;
-                if (!targetBlock->hasSpaceFor(record)) {
+                target = writeTableBlock(addr);
+                if (!target->hasSpaceFor(record)) {
                     std::ostringstream oss;
                     oss << "record cannot be placed even in an empty block for "
                         << tableName;
                     throw std::runtime_error(oss.str());
                 }
             }
-            auto slotId = targetBlock->insertRecord(std::move(record));
+            auto slotId = target->insertRecord(std::move(record));
             if (!slotId.has_value()) {
                 std::ostringstream oss;
-                oss << "failed to insert record into block " << targetBlock->address.table
-                    << "#" << targetBlock->address.index;
+                oss << "failed to insert record into block " << target.address().table
+                    << "#" << target.address().index;
                 throw std::runtime_error(oss.str());
             }
-            const Record *stored = targetBlock->getRecord(*slotId);
+            const BlockAddress targetAddr = target.address();
+            std::optional<Record> stored;
+            if (const Record *storedPtr = target->getRecord(*slotId)) {
+                stored = *storedPtr;
+            }
             if (stored) {
                 try {
-                    applyIndexInsert(tableName, *stored, targetBlock->address, *slotId);
+                    applyIndexInsert(tableName, *stored, targetAddr, *slotId);
                 } catch (...) {
-                    targetBlock->eraseRecord(*slotId);
+                    // Index pages share the buffer pool; if maintenance evicted
+                    // the block, the guard fetches it again.
+                    target->eraseRecord(*slotId);
                     throw;
                 }
             }
@@ -303,7 +397,7 @@ namespace dbms {
             if (transactionActive_ && !suppressUndo_) {
                 UndoEntry entry;
                 entry.type = UndoType::Insert;
-                entry.address = targetBlock->address;
+                entry.address = targetAddr;
                 entry.slot = *slotId;
                 if (stored) {
                     entry.after = *stored;
@@ -315,7 +409,7 @@ namespace dbms {
                 logBuffer_.append("insert into " + tableName);
             }
             if (walCtx.active && !suppressWal_ && stored) {
-                wal_.logInsert(walCtx.txnId, targetBlock->address, *slotId, *stored);
+                wal_.logInsert(walCtx.txnId, targetAddr, *slotId, *stored);
             }
             persistIndexesForTable(tableName);
             walSuccess = true;
@@ -329,7 +423,7 @@ namespace dbms {
         std::optional<Record> readRecord(const BlockAddress &addr,
                                          std::size_t slotIndex) {
             (void)getTable(addr.table);
-            auto fetchResult = buffer_.fetch(addr, false);
+            auto fetchResult = pages_.fetch(addr, false);
             fetchResult.block.ensureInitialized(blockSize_);
             const Record *recordPtr = fetchResult.block.getRecord(slotIndex);
             if (!recordPtr) {
@@ -359,15 +453,14 @@ namespace dbms {
                     << footprint << " bytes, block size " << blockSize_ << ")";
                 throw std::runtime_error(oss.str());
             }
-            auto fetchResult = buffer_.fetch(addr, true);
-            fetchResult.block.ensureInitialized(blockSize_);
-            const Record *beforePtr = fetchResult.block.getRecord(slotIndex);
+            auto page = writeTableBlock(addr);
+            const Record *beforePtr = page->getRecord(slotIndex);
             if (!beforePtr) {
                 success = false;
             } else {
                 Record before = *beforePtr;
                 Record newRecordCopy = record;
-                success = fetchResult.block.updateRecord(slotIndex, std::move(record));
+                success = page->updateRecord(slotIndex, std::move(record));
                 if (success) {
                     applyIndexUpdate(addr.table, before, newRecordCopy, addr, slotIndex);
                     if (transactionActive_ && !suppressUndo_) {
@@ -403,16 +496,15 @@ namespace dbms {
         bool success = false;
         try {
             auto &table = getTable(addr.table);
-            auto fetchResult = buffer_.fetch(addr, true);
-            fetchResult.block.ensureInitialized(blockSize_);
+            auto page = writeTableBlock(addr);
             std::optional<Record> before;
-            if (const Record *recordPtr = fetchResult.block.getRecord(slotIndex)) {
+            if (const Record *recordPtr = page->getRecord(slotIndex)) {
                 before = *recordPtr;
             }
-            success = fetchResult.block.eraseRecord(slotIndex);
+            success = page->eraseRecord(slotIndex);
             if (success) {
                 if (before.has_value()) {
-                    applyIndexDelete(addr.table, *before);
+                    applyIndexDelete(addr.table, *before, addr, slotIndex);
                     if (transactionActive_ && !suppressUndo_) {
                         UndoEntry entry;
                         entry.type = UndoType::Delete;
@@ -459,17 +551,15 @@ namespace dbms {
             report.tableName = tableName;
             auto &table = getTable(tableName);
             for (const auto &addr : table.blocks()) {
-                auto fetchResult = buffer_.fetch(addr, true);
-                fetchResult.block.ensureInitialized(blockSize_);
+                auto page = writeTableBlock(addr);
                 ++report.blocksVisited;
-                const bool hadGarbageOnly =
-                    (fetchResult.block.recordCount() == 0 && fetchResult.block.deletedCount() > 0);
-                const auto stats = fetchResult.block.vacuumDeletedSlots();
+                const bool hadGarbageOnly = (page->recordCount() == 0 && page->deletedCount() > 0);
+                const auto stats = page->vacuumDeletedSlots();
                 if (stats.clearedSlots > 0) {
                     ++report.blocksModified;
                     report.slotsCleared += stats.clearedSlots;
                     report.bytesReclaimed += stats.reclaimedBytes;
-                    if (hadGarbageOnly && fetchResult.block.recordCount() == 0) {
+                    if (hadGarbageOnly && page->recordCount() == 0) {
                         ++report.blocksNowEmpty;
                     }
                 }
@@ -498,14 +588,17 @@ namespace dbms {
                                             bool forWrite,
                                             const std::string &planText) {
             planCache_.recordPlan(planText);
-            auto result = buffer_.fetch(addr, forWrite);
+            if (forWrite) {
+                ++tableBlockWrites_;
+            }
+            auto result = pages_.fetch(addr, forWrite);
             logBuffer_.append("access block " + addr.table + "#" + std::to_string(addr.index));
             return result;
         }
 
 
         void flushAll() {
-            buffer_.flush();
+            checkpoint();
             logBuffer_.flushToDisk();
         }
 
@@ -517,6 +610,9 @@ namespace dbms {
             oss << "  - Data dictionary: " << dictionaryBytes_ << "\n";
             oss << "  - Data buffer: " << bufferBytes_ << " ("
                 << buffer_.capacity() << " frame(s))\n";
+            oss << "    read-ahead depth " << readAheadDepth_ << ": " << readAheadStats_.scans << " scan(s), "
+                << readAheadStats_.blocksRead << " block(s) read, " << readAheadStats_.blocksAhead << " ahead, "
+                << readAheadStats_.blocksLate << " late\n";
             oss << "  - Log buffer: " << logBufferBytes_ << "\n";
             oss << dictionary_.describe();
             oss << planCache_.describe();
@@ -545,68 +641,133 @@ namespace dbms {
             return rows;
         }
 
+    // Indexes that have not been opened yet are listed from the catalog
+    // alone; listing them does not open them.
     std::vector<std::string> indexSummaries() const {
         std::vector<std::string> rows;
         for (const auto &entry : indexes_) {
             const auto &def = entry.second.definition();
             std::ostringstream oss;
-            oss << def.name << " ON " << def.tableName << "("
-                << def.columnName << ") | entries/page="
-                << entry.second.entriesPerPage();
+            oss << def.name << " ON " << def.tableName << "(" << def.columnList() << ")";
+            if (def.covering()) {
+                oss << " INCLUDE (" << def.includeList() << ")";
+            }
+            if (!def.ordered()) {
+                oss << (def.hashed() ? " USING HASH" : " USING BITMAP");
+            }
+            if (closedIndexes_.find(entry.first) != closedIndexes_.end()) {
+                oss << " | not opened";
+            } else {
+                oss << " | entries/page=" << entry.second.entriesPerPage();
+            }
             rows.push_back(oss.str());
         }
         return rows;
     }
 
-        std::vector<std::string> describeIndexFile(const std::string &indexName) const {
-            auto it = indexes_.find(indexName);
-            if (it == indexes_.end()) {
-                throw std::out_of_range("unknown index: " + indexName);
-            }
-            return it->second.describePages();
+        std::vector<std::string> describeIndexFile(const std::string &indexName) {
+            return openedIndex(indexName).describePages();
         }
 
         std::vector<std::string> createIndex(const std::string &indexName,
                                              const std::string &tableName,
                                              const std::string &columnName) {
+            return createIndex(indexName, tableName, std::vector<std::string>{columnName});
+        }
+
+        // Indexes the concatenation of `columnNames`, in order; the index
+        // serves equality on all of them and ranges on a leading prefix.
+        // `includeColumns` are stored in the index alongside the key so that
+        // queries reading only key and included columns skip the table. Hash
+        // and bitmap indexes answer equality on a single column only.
+        std::vector<std::string> createIndex(const std::string &indexName,
+                                             const std::string &tableName,
+                                             const std::vector<std::string> &columnNames,
+                                             const std::vector<std::string> &includeColumns = {},
+                                             IndexMethod method = IndexMethod::BPlusTree) {
             if (indexes_.find(indexName) != indexes_.end()) {
                 throw std::runtime_error("index already exists: " + indexName);
             }
+            if (method != IndexMethod::BPlusTree && (columnNames.size() != 1 || !includeColumns.empty())) {
+                throw std::runtime_error(std::string(method == IndexMethod::Hash ? "hash" : "bitmap") +
+                                         " index " + indexName +
+                                         " must cover exactly one column without INCLUDE");
+            }
             auto tableIt = tables_.find(tableName);
             if (tableIt == tables_.end()) {
                 throw std::out_of_range("unknown table: " + tableName);
             }
+            if (columnNames.empty()) {
+                throw std::runtime_error("index " + indexName + " names no columns");
+            }
             const auto &schema = tableIt->second.schema();
             const auto &columns = schema.columns();
-            auto colIt = std::find_if(
-                columns.begin(), columns.end(),
-                [&](const ColumnDefinition &col) {
-                    return col.name == columnName;
-                });
-            if (colIt == columns.end()) {
-                throw std::runtime_error("unknown column '" + columnName +
-                                         "' on table " + tableName);
+            std::vector<IndexKeyColumn> keyColumns;
+            for (const auto &columnName : columnNames) {
+                auto colIt = std::find_if(
+                    columns.begin(), columns.end(),
+                    [&](const ColumnDefinition &col) {
+                        return col.name == columnName;
+                    });
+                if (colIt == columns.end()) {
+                    throw std::runtime_error("unknown column '" + columnName +
+                                             "' on table " + tableName);
+                }
+                for (const auto &existing : keyColumns) {
+                    if (existing.name == columnName) {
+                        throw std::runtime_error("column '" + columnName +
+                                                 "' appears twice in index " + indexName);
+                    }
+                }
+                keyColumns.push_back(IndexKeyColumn{
+                    columnName,
+                    static_cast<std::size_t>(std::distance(columns.begin(), colIt)),
+                    colIt->type,
+                    indexKeyLength(colIt->type, colIt->length)});
             }
-            const std::size_t columnIndex =
-                static_cast<std::size_t>(std::distance(columns.begin(), colIt));
             IndexDefinition definition;
             definition.name = indexName;
             definition.tableName = tableName;
-            definition.columnName = columnName;
-            definition.columnIndex = columnIndex;
-            definition.keyLength = colIt->length;
+            definition.columnName = keyColumns.front().name;
+            definition.columnIndex = keyColumns.front().index;
+            definition.columnType = keyColumns.front().type;
+            definition.method = method;
+            for (const auto &column : keyColumns) {
+                definition.keyLength += column.keyLength;
+            }
+            if (keyColumns.size() > 1) {
+                definition.compositeColumns = keyColumns;
+            }
+            if (!includeColumns.empty()) {
+                for (const auto &column : keyColumns) {
+                    definition.coveredColumns.push_back(IndexKeyColumn{
+                        column.name, column.index, column.type, columns[column.index].length});
+                }
+                for (const auto &columnName : includeColumns) {
+                    auto colIt = std::find_if(
+                        columns.begin(), columns.end(),
+                        [&](const ColumnDefinition &col) {
+                            return col.name == columnName;
+                        });
+                    if (colIt == columns.end()) {
+                        throw std::runtime_error("unknown column '" + columnName +
+                                                 "' on table " + tableName);
+                    }
+                    if (definition.covers(columnName)) {
+                        throw std::runtime_error("column '" + columnName +
+                                                 "' appears twice in index " + indexName);
+                    }
+                    definition.coveredColumns.push_back(IndexKeyColumn{
+                        columnName,
+                        static_cast<std::size_t>(std::distance(columns.begin(), colIt)),
+                        colIt->type,
+                        colIt->length});
+                }
+            }
             definition.unique = false;
             BPlusTreeIndex index(definition, blockSize_);
-            auto entries =
-                collectIndexEntries(tableName, columnIndex, definition.keyLength);
-            std::sort(entries.begin(), entries.end(),
-                      [](const auto &a, const auto &b) { return a.first < b.first; });
-            entries.erase(std::unique(entries.begin(), entries.end(),
-                                      [](const auto &a, const auto &b) {
-                                          return a.first == b.first;
-                                      }),
-                          entries.end());
-            index.rebuild(entries);
+            index.attachPageStore(makeIndexPageStore(indexName));
+            index.rebuild(collectIndexEntries(index));
             auto insertResult = indexes_.emplace(indexName, std::move(index));
             auto &perTable = indexesByTable_[tableName];
             if (std::find(perTable.begin(), perTable.end(), indexName) == perTable.end()) {
@@ -623,31 +784,125 @@ namespace dbms {
             return insertResult.first->second.describePages();
         }
 
+        // An ordered index keyed on `columnName` alone, or else a composite
+        // index that leads with it.
         std::optional<std::string> findIndexForColumn(const std::string &tableName,
                                                       const std::string &columnName) const {
-            auto binding = indexesByTable_.find(tableName);
-            if (binding == indexesByTable_.end()) {
-                return std::nullopt;
-            }
-            for (const auto &indexName : binding->second) {
-                auto defIt = indexDefinitions_.find(indexName);
-                if (defIt == indexDefinitions_.end()) {
+            std::optional<std::string> leading;
+            for (const auto &indexName : indexesOnTable(tableName)) {
+                const auto &definition = indexDefinitions_.at(indexName);
+                if (definition.columnName != columnName || !definition.ordered()) {
                     continue;
                 }
-                if (defIt->second.columnName == columnName) {
+                if (!definition.composite()) {
+                    return indexName;
+                }
+                if (!leading) {
+                    leading = indexName;
+                }
+            }
+            return leading;
+        }
+
+        // The index to probe for `columnName = value`: a hash index when one
+        // exists, since it reaches the bucket without descending a tree.
+        std::optional<std::string> findEqualityIndexForColumn(const std::string &tableName,
+                                                              const std::string &columnName) const {
+            for (const auto &indexName : indexesOnTable(tableName)) {
+                const auto &definition = indexDefinitions_.at(indexName);
+                if (definition.hashed() && definition.columnName == columnName) {
+                    return indexName;
+                }
+            }
+            return findIndexForColumn(tableName, columnName);
+        }
+
+        std::optional<std::string> findBitmapIndexForColumn(const std::string &tableName,
+                                                            const std::string &columnName) const {
+            for (const auto &indexName : indexesOnTable(tableName)) {
+                const auto &definition = indexDefinitions_.at(indexName);
+                if (definition.bitmapped() && definition.columnName == columnName) {
                     return indexName;
                 }
             }
             return std::nullopt;
         }
 
+        std::vector<std::string> indexesOnTable(const std::string &tableName) const {
+            std::vector<std::string> names;
+            auto binding = indexesByTable_.find(tableName);
+            if (binding == indexesByTable_.end()) {
+                return names;
+            }
+            for (const auto &indexName : binding->second) {
+                if (indexDefinitions_.find(indexName) != indexDefinitions_.end()) {
+                    names.push_back(indexName);
+                }
+            }
+            return names;
+        }
+
+        // Looks up the row whose indexed column equals `value`.
         std::optional<IndexPointer> searchIndex(const std::string &indexName,
-                                                const std::string &key) const {
-            auto it = indexes_.find(indexName);
-            if (it == indexes_.end()) {
+                                                const std::string &value) {
+            const auto &index = openedIndex(indexName);
+            return index.find(index.encodeKey(value));
+        }
+
+        // Rows a bitmap index stores under `value`, to be combined with the
+        // bitmaps of other predicates before any block is read.
+        RowBitmap searchIndexBitmap(const std::string &indexName,
+                                    const std::string &value) {
+            const auto &index = openedIndex(indexName);
+            return index.rowBitmap(index.encodeKey(value));
+        }
+
+        // Every row pointer stored under `value`; a non-unique index may
+        // hold many.
+        std::vector<IndexPointer> searchIndexAll(const std::string &indexName,
+                                                 const std::string &value) {
+            const auto &index = openedIndex(indexName);
+            return index.findAll(index.encodeKey(value));
+        }
+
+        // Encoded form of a column value, as passed to and returned by scanIndex.
+        std::string indexKeyFor(const std::string &indexName,
+                                const std::string &value) {
+            const auto &index = openedIndex(indexName);
+            return index.encodeKey(value);
+        }
+
+        // Key prefix shared by every row whose leading key columns equal
+        // `values`; the full key when a value is given for every column.
+        std::string indexKeyFor(const std::string &indexName,
+                                const std::vector<std::string> &values) {
+            const auto &index = openedIndex(indexName);
+            return index.encodeKey(values);
+        }
+
+        // Walks the index leaf chain in key order from `lower`; the visitor
+        // must not touch table blocks because index pages share the pool.
+        void scanIndex(const std::string &indexName,
+                       const std::optional<std::string> &lower,
+                       bool lowerInclusive,
+                       const std::function<bool(const std::string &, const IndexPointer &)> &visit) {
+            const auto &index = openedIndex(indexName);
+            index.scan(lower, lowerInclusive, visit);
+        }
+
+        // False for an index restored from the catalog that no lookup or
+        // change has touched yet, so its file has not been read.
+        bool indexOpen(const std::string &indexName) const {
+            return indexes_.find(indexName) != indexes_.end() &&
+                   closedIndexes_.find(indexName) == closedIndexes_.end();
+        }
+
+        const IndexDefinition &getIndexDefinition(const std::string &indexName) const {
+            auto it = indexDefinitions_.find(indexName);
+            if (it == indexDefinitions_.end()) {
                 throw std::out_of_range("unknown index: " + indexName);
             }
-            return it->second.find(key);
+            return it->second;
         }
 
         TableDumpResult dumpTable(const std::string &tableName,
@@ -660,8 +915,9 @@ namespace dbms {
             logBuffer_.append("scan " + tableName);
             std::size_t skipped = 0;
             std::size_t accessed = 0;
+            auto ring = startBulkRead(table.blocks().size());
             for (const auto &addr : table.blocks()) {
-                auto fetchResult = buffer_.fetch(addr, false);
+                auto fetchResult = fetchBulk(ring.get(), addr);
                 fetchResult.block.ensureInitialized(blockSize_);
                 ++accessed;
                 fetchResult.block.page.forEachRecord(
@@ -802,89 +1058,130 @@ namespace dbms {
             ScopedFlagGuard applyingGuard(applyingUndo_, true);
             ScopedFlagGuard walGuard(suppressWal_, true);
 
+            std::vector<WriteAheadLog::Entry> redo;
             for (const auto &entry : pendingWalEntries_) {
                 if (isWalDataEntry(entry) && committed[entry.txnId]) {
-                    applyWalRedo(entry);
+                    redo.push_back(entry);
                 }
             }
+            applyWalRedo(redo);
             for (auto it = pendingWalEntries_.rbegin(); it != pendingWalEntries_.rend(); ++it) {
                 if (isWalDataEntry(*it) && !committed[it->txnId]) {
                     applyWalUndo(*it);
                 }
             }
             buffer_.flush();
-            for (const auto &binding : indexesByTable_) {
-                for (const auto &indexName : binding.second) {
-                    persistIndex(indexName);
-                }
-            }
+            checkpointIndexes();
             wal_.clear();
             pendingWalEntries_.clear();
             walTables_.clear();
             recoveryPerformed_ = true;
         }
 
-        void applyWalRedo(const WriteAheadLog::Entry &entry) {
-            try {
-                switch (entry.type) {
-                case WriteAheadLog::EntryType::Insert: {
-                    if (!entry.after.has_value()) {
-                        return;
+        // Committed changes since the last checkpoint may or may not have
+        // reached the block files, and slot numbers in the log can be stale,
+        // so redo works on row images rather than replaying entries one by
+        // one. Entries are first linked into per-row chains. Each chain then
+        // claims one stored row holding one of its images, newest first, and
+        // that row is brought to the chain's last image. Applying the same
+        // log twice therefore changes nothing, and each table is scanned
+        // once instead of once per entry.
+        void applyWalRedo(const std::vector<WriteAheadLog::Entry> &entries) {
+            std::map<std::string, std::vector<WalRowChain>> chainsByTable;
+            std::map<std::string, std::map<std::vector<std::string>, std::vector<std::size_t>>> openByTable;
+            for (const auto &entry : entries) {
+                auto &chains = chainsByTable[entry.address.table];
+                auto &open = openByTable[entry.address.table];
+                auto continueChain = [&](const Record &image) -> WalRowChain * {
+                    auto it = open.find(image.values);
+                    if (it == open.end() || it->second.empty()) {
+                        return nullptr;
                     }
-                    BlockAddress addrFound;
-                    std::size_t slotFound{0};
-                    if (findRecord(entry.address.table, *entry.after, addrFound, slotFound)) {
-                        return;
+                    WalRowChain *chain = &chains[it->second.back()];
+                    it->second.pop_back();
+                    return chain;
+                };
+                switch (entry.type) {
+                case WriteAheadLog::EntryType::Insert:
+                    if (entry.after.has_value()) {
+                        open[entry.after->values].push_back(chains.size());
+                        chains.push_back(WalRowChain{{*entry.after}, true, false});
                     }
-                    insertRecord(entry.address.table, *entry.after);
                     break;
-                }
-                case WriteAheadLog::EntryType::Delete: {
-                    if (!entry.before.has_value()) {
-                        return;
+                case WriteAheadLog::EntryType::Update:
+                    if (entry.before.has_value() && entry.after.has_value()) {
+                        WalRowChain *chain = continueChain(*entry.before);
+                        if (chain) {
+                            chain->images.push_back(*entry.after);
+                            open[entry.after->values].push_back(static_cast<std::size_t>(chain - chains.data()));
+                        } else {
+                            open[entry.after->values].push_back(chains.size());
+                            chains.push_back(WalRowChain{{*entry.before, *entry.after}, false, false});
+                        }
                     }
-                    BlockAddress addrFound;
-                    std::size_t slotFound{0};
-                    if (findRecord(entry.address.table, *entry.before, addrFound, slotFound)) {
-                        deleteRecord(addrFound, slotFound);
+                    break;
+                case WriteAheadLog::EntryType::Delete:
+                    if (entry.before.has_value()) {
+                        if (WalRowChain *chain = continueChain(*entry.before)) {
+                            chain->deleted = true;
+                        } else {
+                            chains.push_back(WalRowChain{{*entry.before}, false, true});
+                        }
                     }
                     break;
+                default:
+                    break;
                 }
-                case WriteAheadLog::EntryType::Update: {
-                    if (!entry.after.has_value()) {
-                        return;
-                    }
-                    BlockAddress addrFound = entry.address;
-                    std::size_t slotFound = entry.slot;
-                    bool located = false;
-                    if (entry.before.has_value()) {
-                        located = findRecord(entry.address.table, *entry.before, addrFound, slotFound);
+            }
+            for (const auto &tableChains : chainsByTable) {
+                try {
+                    redoTableChains(tableChains.first, tableChains.second);
+                } catch (const std::exception &ex) {
+                    std::cerr << "WAL redo skipped table " << tableChains.first << ": " << ex.what() << "\n";
+                }
+            }
+        }
+
+        void redoTableChains(const std::string &tableName,
+                             const std::vector<WalRowChain> &chains) {
+            std::map<std::vector<std::string>, std::vector<std::pair<BlockAddress, std::size_t>>> stored;
+            for (const auto &addr : getTable(tableName).blocks()) {
+                auto fetchResult = pages_.fetch(addr, false);
+                fetchResult.block.ensureInitialized(blockSize_);
+                const auto slots = fetchResult.block.slotCount();
+                for (std::size_t i = 0; i < slots; ++i) {
+                    if (const Record *candidate = fetchResult.block.getRecord(i)) {
+                        stored[candidate->values].emplace_back(addr, i);
                     }
-                    if (!located) {
-                        if (disk_.contains(entry.address)) {
-                            auto fetch = buffer_.fetch(entry.address, false);
-                            fetch.block.ensureInitialized(blockSize_);
-                            if (fetch.block.getRecord(entry.slot)) {
-                                located = true;
-                                addrFound = entry.address;
-                                slotFound = entry.slot;
-                            }
+                }
+            }
+            for (const auto &chain : chains) {
+                try {
+                    std::optional<std::pair<BlockAddress, std::size_t>> location;
+                    std::size_t image = chain.images.size();
+                    while (!location && image > 0) {
+                        --image;
+                        auto it = stored.find(chain.images[image].values);
+                        if (it != stored.end() && !it->second.empty()) {
+                            location = it->second.back();
+                            it->second.pop_back();
                         }
                     }
-                    if (located) {
-                        if (!updateRecord(addrFound, slotFound, *entry.after)) {
-                            insertRecord(entry.address.table, *entry.after);
+                    const Record &last = chain.images.back();
+                    if (!location) {
+                        if (!chain.deleted) {
+                            insertRecord(tableName, last);
                         }
-                    } else {
-                        insertRecord(entry.address.table, *entry.after);
+                    } else if (chain.deleted) {
+                        deleteRecord(location->first, location->second);
+                    } else if (image + 1 != chain.images.size() &&
+                               !updateRecord(location->first, location->second, last)) {
+                        deleteRecord(location->first, location->second);
+                        insertRecord(tableName, last);
                     }
-                    break;
+                } catch (const std::exception &ex) {
+                    std::cerr << "WAL redo skipped entry: " << ex.what() << "\n";
                 }
-                default:
-                    break;
-                }
-            } catch (const std::exception &ex) {
-                std::cerr << "WAL redo skipped entry: " << ex.what() << "\n";
             }
         }
 
@@ -915,27 +1212,6 @@ namespace dbms {
             applyUndo(undo);
         }
 
-        bool findRecord(const std::string &tableName,
-                        const Record &record,
-                        BlockAddress &addrOut,
-                        std::size_t &slotOut) {
-            auto &table = getTable(tableName);
-            for (const auto &addr : table.blocks()) {
-                auto fetchResult = buffer_.fetch(addr, false);
-                fetchResult.block.ensureInitialized(blockSize_);
-                const auto slots = fetchResult.block.slotCount();
-                for (std::size_t i = 0; i < slots; ++i) {
-                    const Record *candidate = fetchResult.block.getRecord(i);
-                    if (candidate && candidate->values == record.values) {
-                        addrOut = addr;
-                        slotOut = i;
-                        return true;
-                    }
-                }
-            }
-            return false;
-        }
-
         void applyUndo(const UndoEntry &entry) {
             switch (entry.type) {
             case UndoType::Insert: {
@@ -966,9 +1242,7 @@ namespace dbms {
                                   std::size_t slotIndex,
                                   const Record &record) {
             auto &table = getTable(addr.table);
-            auto fetchResult = buffer_.fetch(addr, true);
-            fetchResult.block.ensureInitialized(blockSize_);
-            if (!fetchResult.block.restoreDeletedRecord(slotIndex)) {
+            if (!writeTableBlock(addr)->restoreDeletedRecord(slotIndex)) {
                 return false;
             }
             applyIndexInsert(addr.table, record, addr, slotIndex);
@@ -984,7 +1258,7 @@ namespace dbms {
                                   const Record &target) {
             auto &table = getTable(tableName);
             for (const auto &addr : table.blocks()) {
-                auto fetchResult = buffer_.fetch(addr, false);
+                auto fetchResult = pages_.fetch(addr, false);
                 fetchResult.block.ensureInitialized(blockSize_);
                 const auto slots = fetchResult.block.slotCount();
                 for (std::size_t i = 0; i < slots; ++i) {
@@ -998,26 +1272,129 @@ namespace dbms {
         }
 
 
-    std::vector<std::pair<std::string, IndexPointer>>
-    collectIndexEntries(const std::string &tableName,
-                        std::size_t columnIndex,
-                        std::size_t keyLength) {
-        std::vector<std::pair<std::string, IndexPointer>> entries;
-        const auto &table = getTable(tableName);
-        entries.reserve(table.totalRecords());
-        for (const auto &addr : table.blocks()) {
-            auto fetchResult = buffer_.fetch(addr, false);
+    using IndexEntries = std::vector<std::pair<std::string, IndexPointer>>;
+
+    // Fewest table blocks worth handing to another build worker.
+    static constexpr std::size_t kMinBlocksPerBuildWorker = 32;
+
+    static std::size_t defaultIndexBuildThreads() {
+        return std::max<std::size_t>(1, std::thread::hardware_concurrency());
+    }
+
+    // Every write to a table block goes through here, so that bulk reads
+    // can tell when their ring no longer matches the block files.
+    WritePageGuard writeTableBlock(const BlockAddress &addr) {
+        ++tableBlockWrites_;
+        return pages_.write(addr);
+    }
+
+    // Shortest table a scan starts a read-ahead thread for.
+    static constexpr std::size_t kMinReadAheadBlocks = 16;
+    static constexpr std::size_t kDefaultReadAheadDepth = 32;
+
+    // Entries of every row in the table. With more than one build worker the
+    // blocks are split into contiguous ranges that are read, keyed and
+    // sorted in parallel, then merged, so the result is sorted by key with
+    // equal keys in table order, as a stable sort of a serial scan would
+    // leave them.
+    IndexEntries collectIndexEntries(const BPlusTreeIndex &index) {
+        const auto &table = getTable(index.definition().tableName);
+        const auto &blocks = table.blocks();
+        const std::size_t workers =
+            std::min(indexBuildThreads_, blocks.size() / kMinBlocksPerBuildWorker);
+        if (workers <= 1) {
+            IndexEntries entries;
+            entries.reserve(table.totalRecords());
+            auto ring = startBulkRead(blocks.size());
+            collectBlockEntries(index, blocks.begin(), blocks.end(), entries,
+                                [&](const BlockAddress &addr) { return fetchBulk(ring.get(), addr); });
+            return entries;
+        }
+
+        // The shared buffer pool is not thread-safe, so each worker reads its
+        // range through a ring of its own. Flushing first puts every change
+        // in the files.
+        buffer_.flush();
+        std::vector<IndexEntries> runs(workers);
+        std::vector<std::exception_ptr> errors(workers);
+        std::vector<std::thread> threads;
+        threads.reserve(workers);
+        for (std::size_t w = 0; w < workers; ++w) {
+            threads.emplace_back([&, w] {
+                try {
+                    const auto first = blocks.begin() + static_cast<std::ptrdiff_t>(blocks.size() * w / workers);
+                    const auto last = blocks.begin() + static_cast<std::ptrdiff_t>(blocks.size() * (w + 1) / workers);
+                    ScanRing ring(disk_.totalBlocks(), storagePath_, blockSize_, tableBlockWrites_);
+                    collectBlockEntries(index, first, last, runs[w],
+                                        [&ring](const BlockAddress &addr) { return ring.pool().fetch(addr, false); });
+                    std::stable_sort(runs[w].begin(), runs[w].end(),
+                                     [](const auto &lhs, const auto &rhs) { return lhs.first < rhs.first; });
+                } catch (...) {
+                    errors[w] = std::current_exception();
+                }
+            });
+        }
+        for (auto &thread : threads) {
+            thread.join();
+        }
+        for (const auto &error : errors) {
+            if (error) {
+                std::rethrow_exception(error);
+            }
+        }
+        return mergeSortedRuns(std::move(runs));
+    }
+
+    // Appends the entries of the rows in blocks [first, last), each read
+    // with `fetch`.
+    template <typename Fetch>
+    void collectBlockEntries(const BPlusTreeIndex &index,
+                             std::vector<BlockAddress>::const_iterator first,
+                             std::vector<BlockAddress>::const_iterator last,
+                             IndexEntries &entries,
+                             Fetch fetch) const {
+        for (auto it = first; it != last; ++it) {
+            auto fetchResult = fetch(*it);
             fetchResult.block.ensureInitialized(blockSize_);
             fetchResult.block.page.forEachRecord(
                 [&](std::size_t slotIdx, const Record &record) {
-                    std::string key =
-                        sliceIndexKey(record, columnIndex, keyLength);
+                    std::string key = index.projectKey(record);
                     if (!key.empty()) {
-                        entries.emplace_back(key, IndexPointer{addr, slotIdx});
+                        entries.emplace_back(std::move(key), IndexPointer{*it, slotIdx});
                     }
                 });
         }
-        return entries;
+    }
+
+    // Merges adjacent sorted runs pairwise, each round in parallel; taking
+    // ties from the earlier run keeps equal keys in table order.
+    static IndexEntries mergeSortedRuns(std::vector<IndexEntries> runs) {
+        const auto byKey = [](const auto &lhs, const auto &rhs) { return lhs.first < rhs.first; };
+        while (runs.size() > 1) {
+            std::vector<IndexEntries> merged((runs.size() + 1) / 2);
+            std::vector<std::thread> threads;
+            for (std::size_t i = 0; i + 1 < runs.size(); i += 2) {
+                threads.emplace_back([&, i] {
+                    auto &out = merged[i / 2];
+                    out.reserve(runs[i].size() + runs[i + 1].size());
+                    std::merge(std::make_move_iterator(runs[i].begin()),
+                               std::make_move_iterator(runs[i].end()),
+                               std::make_move_iterator(runs[i + 1].begin()),
+                               std::make_move_iterator(runs[i + 1].end()),
+                               std::back_inserter(out), byKey);
+                    IndexEntries().swap(runs[i]);
+                    IndexEntries().swap(runs[i + 1]);
+                });
+            }
+            if (runs.size() % 2 == 1) {
+                merged.back() = std::move(runs.back());
+            }
+            for (auto &thread : threads) {
+                thread.join();
+            }
+            runs = std::move(merged);
+        }
+        return runs.empty() ? IndexEntries() : std::move(runs.front());
     }
 
     void applyIndexInsert(const std::string &tableName,
@@ -1029,11 +1406,10 @@ namespace dbms {
             return;
         }
         for (const auto &indexName : binding->second) {
-            auto it = indexes_.find(indexName);
-            if (it == indexes_.end()) {
+            if (indexes_.find(indexName) == indexes_.end()) {
                 continue;
             }
-            it->second.insertRecord(record, addr, slotIndex);
+            openedIndex(indexName).insertRecord(record, addr, slotIndex);
         }
     }
 
@@ -1047,51 +1423,51 @@ namespace dbms {
             return;
         }
         for (const auto &indexName : binding->second) {
-            auto it = indexes_.find(indexName);
-            if (it == indexes_.end()) {
+            if (indexes_.find(indexName) == indexes_.end()) {
                 continue;
             }
-            it->second.updateRecord(before, after, addr, slotIndex);
+            openedIndex(indexName).updateRecord(before, after, addr, slotIndex);
         }
     }
 
     void applyIndexDelete(const std::string &tableName,
-                          const Record &record) {
+                          const Record &record,
+                          const BlockAddress &addr,
+                          std::size_t slotIndex) {
         auto binding = indexesByTable_.find(tableName);
         if (binding == indexesByTable_.end()) {
             return;
         }
         for (const auto &indexName : binding->second) {
-            auto it = indexes_.find(indexName);
-            if (it == indexes_.end()) {
+            if (indexes_.find(indexName) == indexes_.end()) {
                 continue;
             }
-            it->second.deleteRecord(record);
+            openedIndex(indexName).deleteRecord(record, addr, slotIndex);
         }
     }
 
     void enforceUniqueKeys(const std::string &tableName,
                            const Record &record,
                            const BlockAddress *selfAddr,
-                           std::optional<std::size_t> slotIndex) const {
+                           std::optional<std::size_t> slotIndex) {
         auto binding = indexesByTable_.find(tableName);
         if (binding == indexesByTable_.end()) {
             return;
         }
         for (const auto &indexName : binding->second) {
-            auto it = indexes_.find(indexName);
-            if (it == indexes_.end()) {
+            if (indexes_.find(indexName) == indexes_.end()) {
                 continue;
             }
             auto defIt = indexDefinitions_.find(indexName);
             if (defIt != indexDefinitions_.end() && !defIt->second.unique) {
                 continue;
             }
-            const std::string key = it->second.projectKey(record);
+            const auto &index = openedIndex(indexName);
+            const std::string key = index.projectSearchKey(record);
             if (key.empty()) {
                 continue;
             }
-            auto existing = it->second.find(key);
+            auto existing = index.find(key);
             if (!existing.has_value()) {
                 continue;
             }
@@ -1106,7 +1482,7 @@ namespace dbms {
         }
     }
 
-    void persistIndexesForTable(const std::string &tableName) const {
+    void persistIndexesForTable(const std::string &tableName) {
         auto binding = indexesByTable_.find(tableName);
         if (binding == indexesByTable_.end()) {
             return;
@@ -1116,41 +1492,155 @@ namespace dbms {
         }
     }
 
-    void persistIndex(const std::string &indexName) const {
+    void persistIndex(const std::string &indexName) {
         auto it = indexes_.find(indexName);
-        if (it == indexes_.end()) {
+        if (it == indexes_.end() || closedIndexes_.count(indexName) != 0) {
             return;
         }
         const std::string path = indexDataFilePath(storagePath_, indexName);
-        it->second.saveToFile(path);
+        it->second.persistChanges(path);
+    }
+
+    // Writes every dirty page and index, then, outside a transaction, empties
+    // the WAL: nothing before this point needs redo any more, so the next
+    // recovery starts from the end of the log. Called on commit, rollback and
+    // flushAll, which keeps the log to the changes since the last of those
+    // instead of letting it grow for the life of the storage directory.
+    void checkpoint() {
+        buffer_.flush();
+        checkpointIndexes();
+        if (!transactionActive_ && recoveryPerformed_) {
+            wal_.clear();
+        }
+    }
+
+    void checkpointIndexes() {
+        for (auto &entry : indexes_) {
+            if (closedIndexes_.find(entry.first) != closedIndexes_.end()) {
+                continue;
+            }
+            entry.second.checkpoint(indexDataFilePath(storagePath_, entry.first));
+        }
     }
 
-    void loadIndexFromDisk(const IndexDefinition &definition) {
+    std::unique_ptr<IndexPageStore> makeIndexPageStore(const std::string &indexName) {
+        return std::make_unique<BufferPoolIndexPageStore>(
+            pages_, disk_, BufferPoolIndexPageStore::segmentFor(indexName), blockSize_);
+    }
+
+    // Registers an index restored from the catalog without reading its
+    // file: opening the database costs the same however many indexes it
+    // holds. openedIndex reads the file, or rebuilds the index, on first use.
+    void registerStoredIndex(IndexDefinition definition) {
+        // Catalogs written before keys were typed record no column type; an
+        // index whose key encoding no longer matches its columns is rebuilt.
+        bool keyFormatChanged = false;
+        auto tableIt = tables_.find(definition.tableName);
+        if (tableIt != tables_.end()) {
+            const auto &columns = tableIt->second.schema().columns();
+            auto keyColumns = definition.keyColumns();
+            std::size_t keyLength = 0;
+            bool resolved = true;
+            for (auto &keyColumn : keyColumns) {
+                if (keyColumn.index >= columns.size()) {
+                    resolved = false;
+                    break;
+                }
+                const auto &column = columns[keyColumn.index];
+                keyColumn.type = column.type;
+                keyColumn.keyLength = indexKeyLength(column.type, column.length);
+                keyLength += keyColumn.keyLength;
+            }
+            const bool changed = keyLength != definition.keyLength ||
+                                 keyColumns.front().type != definition.columnType ||
+                                 (definition.composite() &&
+                                  !std::equal(keyColumns.begin(), keyColumns.end(),
+                                              definition.compositeColumns.begin(),
+                                              [](const IndexKeyColumn &a, const IndexKeyColumn &b) {
+                                                  return a.type == b.type && a.keyLength == b.keyLength;
+                                              }));
+            // Covered values are stored verbatim up to the column length.
+            bool coveredChanged = false;
+            for (auto &covered : definition.coveredColumns) {
+                if (covered.index >= columns.size()) {
+                    resolved = false;
+                    break;
+                }
+                const auto &column = columns[covered.index];
+                if (covered.type != column.type || covered.keyLength != column.length) {
+                    covered.type = column.type;
+                    covered.keyLength = column.length;
+                    coveredChanged = true;
+                }
+            }
+            if (resolved && (changed || coveredChanged)) {
+                definition.columnType = keyColumns.front().type;
+                definition.keyLength = keyLength;
+                if (definition.composite()) {
+                    definition.compositeColumns = keyColumns;
+                }
+                indexDefinitions_[definition.name] = definition;
+                keyFormatChanged = true;
+            }
+        }
+        // The page store is attached on open too: attaching lists the pages
+        // of the index segment. The catalog now records the new key format,
+        // so an index whose format changed is rebuilt right away instead of
+        // leaving the old file for a later start.
         BPlusTreeIndex index(definition, blockSize_);
-        const std::string dataPath = indexDataFilePath(storagePath_, definition.name);
+        if (keyFormatChanged) {
+            index.attachPageStore(makeIndexPageStore(definition.name));
+            index.rebuild(collectIndexEntries(index));
+            persistIndexCatalog();
+        }
+        auto &perTable = indexesByTable_[definition.tableName];
+        if (std::find(perTable.begin(), perTable.end(), definition.name) == perTable.end()) {
+            perTable.push_back(definition.name);
+        }
+        auto emplaced = indexes_.emplace(definition.name, std::move(index));
+        if (!keyFormatChanged) {
+            closedIndexes_.insert(definition.name);
+        }
+        // Paged geometry is only known once the page store is attached; the
+        // dictionary records 0 until the index is opened.
+        dictionary_.registerIndex(definition,
+                                  keyFormatChanged ? emplaced.first->second.entriesPerPage() : 0);
+    }
+
+    // Loads a registered index from its file; an index whose file is
+    // missing or unreadable is rebuilt from the table instead.
+    void openStoredIndex(const std::string &indexName, BPlusTreeIndex &index) {
+        index.attachPageStore(makeIndexPageStore(indexName));
+        const std::string dataPath = indexDataFilePath(storagePath_, indexName);
         bool loadedFromDisk = false;
         if (pathutil::fileExists(dataPath)) {
             try {
                 index.loadFromFile(dataPath);
                 loadedFromDisk = true;
             } catch (const std::exception &ex) {
-                std::cerr << "Warning: unable to load index '" << definition.name
+                std::cerr << "Warning: unable to load index '" << indexName
                           << "' (" << ex.what() << "); rebuilding.\n";
             }
         }
         if (!loadedFromDisk) {
-            auto entries = collectIndexEntries(definition.tableName,
-                                               definition.columnIndex,
-                                               definition.keyLength);
-            index.rebuild(entries);
+            index.rebuild(collectIndexEntries(index));
         }
-        auto &perTable = indexesByTable_[definition.tableName];
-        if (std::find(perTable.begin(), perTable.end(), definition.name) == perTable.end()) {
-            perTable.push_back(definition.name);
+        dictionary_.registerIndex(index.definition(), index.entriesPerPage());
+    }
+
+    // Opening may read the index file or rebuild it from the table, so the
+    // lookups that go through here are not const.
+    BPlusTreeIndex &openedIndex(const std::string &indexName) {
+        auto it = indexes_.find(indexName);
+        if (it == indexes_.end()) {
+            throw std::out_of_range("unknown index: " + indexName);
         }
-        auto emplaced = indexes_.emplace(definition.name, std::move(index));
-        dictionary_.registerIndex(definition,
-                                  emplaced.first->second.entriesPerPage());
+        auto closed = closedIndexes_.find(indexName);
+        if (closed != closedIndexes_.end()) {
+            openStoredIndex(indexName, it->second);
+            closedIndexes_.erase(closed);
+        }
+        return it->second;
     }
 
     void restoreIndexesForTable(const std::string &tableName) {
@@ -1166,7 +1656,7 @@ namespace dbms {
             if (indexes_.find(indexName) != indexes_.end()) {
                 continue;
             }
-            loadIndexFromDisk(defIt->second);
+            registerStoredIndex(defIt->second);
         }
         pendingIndexLoadsByTable_.erase(pendingIt);
     }
@@ -1202,6 +1692,20 @@ namespace dbms {
             def.columnIndex = static_cast<std::size_t>(std::stoull(parts[3]));
             def.keyLength = static_cast<std::size_t>(std::stoull(parts[4]));
             def.unique = (parts[5] == "1");
+            if (parts.size() > 6) {
+                def.columnType = static_cast<ColumnType>(std::stoi(parts[6]));
+            }
+            if (parts.size() > 7) {
+                def.compositeColumns = parseIndexKeyColumns(parts[7]);
+            }
+            if (parts.size() > 8) {
+                def.coveredColumns = parseIndexKeyColumns(parts[8]);
+            }
+            if (parts.size() > 9 && parts[9] == "HASH") {
+                def.method = IndexMethod::Hash;
+            } else if (parts.size() > 9 && parts[9] == "BITMAP") {
+                def.method = IndexMethod::Bitmap;
+            }
             indexDefinitions_[def.name] = def;
             pendingIndexLoadsByTable_[def.tableName].push_back(def.name);
         }
@@ -1219,10 +1723,56 @@ namespace dbms {
             const auto &def = entry.second;
             out << def.name << "|" << def.tableName << "|" << def.columnName << "|"
                 << def.columnIndex << "|" << def.keyLength << "|"
-                << (def.unique ? 1 : 0) << "\n";
+                << (def.unique ? 1 : 0) << "|" << static_cast<int>(def.columnType);
+            if (def.composite() || def.covering() || !def.ordered()) {
+                out << "|" << (def.composite() ? formatIndexKeyColumns(def.compositeColumns) : "");
+            }
+            if (def.covering() || !def.ordered()) {
+                out << "|" << formatIndexKeyColumns(def.coveredColumns);
+            }
+            if (!def.ordered()) {
+                out << "|" << (def.hashed() ? "HASH" : "BITMAP");
+            }
+            out << "\n";
         }
     }
 
+    // Composite key columns are stored as "name:index:type:keyLength"
+    // entries separated by commas in an eighth catalog field, covered
+    // columns likewise in a ninth; a tenth reads HASH or BITMAP for those
+    // index methods.
+    static std::string formatIndexKeyColumns(const std::vector<IndexKeyColumn> &columns) {
+        std::ostringstream oss;
+        for (std::size_t i = 0; i < columns.size(); ++i) {
+            oss << (i == 0 ? "" : ",") << columns[i].name << ":" << columns[i].index << ":"
+                << static_cast<int>(columns[i].type) << ":" << columns[i].keyLength;
+        }
+        return oss.str();
+    }
+
+    static std::vector<IndexKeyColumn> parseIndexKeyColumns(const std::string &text) {
+        std::vector<IndexKeyColumn> columns;
+        std::stringstream entries(text);
+        std::string entry;
+        while (std::getline(entries, entry, ',')) {
+            std::vector<std::string> fields;
+            std::stringstream ss(entry);
+            std::string field;
+            while (std::getline(ss, field, ':')) {
+                fields.push_back(field);
+            }
+            if (fields.size() != 4) {
+                throw std::runtime_error("malformed index key column: " + entry);
+            }
+            columns.push_back(IndexKeyColumn{
+                fields[0],
+                static_cast<std::size_t>(std::stoull(fields[1])),
+                static_cast<ColumnType>(std::stoi(fields[2])),
+                static_cast<std::size_t>(std::stoull(fields[3]))});
+        }
+        return columns;
+    }
+
     void removePendingIndex(const std::string &tableName,
                             const std::string &indexName) {
         auto it = pendingIndexLoadsByTable_.find(tableName);
@@ -1328,6 +1878,7 @@ namespace dbms {
     std::string storagePath_;
     DiskStorage disk_;
     BufferPool buffer_;
+    PageGuards pages_;
     DataDictionary dictionary_;
     AccessPlanCache planCache_;
     LogBuffer logBuffer_;
@@ -1338,12 +1889,18 @@ namespace dbms {
     std::string indexCatalogFile_;
     std::unordered_map<std::string, IndexDefinition> indexDefinitions_;
     std::unordered_map<std::string, std::vector<std::string>> pendingIndexLoadsByTable_;
+    std::unordered_set<std::string> closedIndexes_;
     bool transactionActive_{false};
     bool suppressUndo_{false};
     bool applyingUndo_{false};
     bool suppressWal_{false};
     std::optional<std::size_t> currentTxnId_;
     std::size_t nextTxnId_{1};
+    std::size_t indexBuildThreads_{defaultIndexBuildThreads()};
+    std::size_t readAheadDepth_{defaultReadAheadDepth()};
+    ReadAheadStats readAheadStats_;
+    std::size_t tableBlockWrites_{0};
+    std::size_t bulkRingFetches_{0};
     std::vector<UndoEntry> undoLog_;
     std::vector<WriteAheadLog::Entry> pendingWalEntries_;
     std::unordered_set<std::string> walTables_;
@@ -0,0 +1,150 @@
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "common/types.h"
+#include "storage/disk_manager.h"
+
+namespace dbms {
+
+// Counters summed over every scan that started a reader.
+struct ReadAheadStats {
+    std::size_t scans{0};        // scans that ran a reader
+    std::size_t blocksRead{0};   // blocks the readers loaded
+    std::size_t blocksAhead{0};  // scan fetches a reader had already covered
+    std::size_t blocksLate{0};   // scan fetches that got there before the reader
+};
+
+// Reads the upcoming blocks of a sequential scan on a background thread so
+// that the scan's own BufferPool misses find the bytes in the OS page cache.
+// The shared pool is not thread-safe, so the reader goes through its own
+// DiskStorage over the same block files and throws away what it reads; the
+// scan still fetches every block from the pool, dirty ones included.
+//
+// The window starts at a few blocks. It doubles, up to the configured depth,
+// whenever the scan reaches a block the reader has not covered yet, and
+// halves on every pool hit, since resident blocks gain nothing from it.
+class BlockReadAhead {
+public:
+    BlockReadAhead(std::vector<BlockAddress> blocks,
+                   std::size_t totalBlocks,
+                   std::string basePath,
+                   std::size_t blockSize,
+                   std::size_t maxDepth,
+                   ReadAheadStats &stats)
+        : blocks_(std::move(blocks)),
+          totalBlocks_(totalBlocks),
+          basePath_(std::move(basePath)),
+          blockSize_(blockSize),
+          maxDepth_(std::max<std::size_t>(1, maxDepth)),
+          depth_(std::min(kInitialDepth, maxDepth_)),
+          stats_(stats) {
+        ++stats_.scans;
+        thread_ = std::thread([this]() { run(); });
+    }
+
+    ~BlockReadAhead() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        wake_.notify_all();
+        thread_.join();
+        stats_.blocksRead += blocksRead_;
+    }
+
+    BlockReadAhead(const BlockReadAhead &) = delete;
+    BlockReadAhead &operator=(const BlockReadAhead &) = delete;
+
+    // Called by the scan before it fetches blocks[position].
+    void reached(std::size_t position) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            position_ = position;
+            lastLate_ = position >= next_;
+            if (lastLate_) {
+                ++stats_.blocksLate;
+                next_ = position + 1;
+            } else {
+                ++stats_.blocksAhead;
+            }
+        }
+        wake_.notify_one();
+    }
+
+    // Called after that fetch with whether the pool already held the block.
+    void fetched(bool wasHit) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (wasHit) {
+                depth_ /= 2;
+            } else if (lastLate_) {
+                depth_ = std::min(maxDepth_, std::max<std::size_t>(1, depth_ * 2));
+            }
+        }
+        wake_.notify_one();
+    }
+
+    std::size_t depth() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return depth_;
+    }
+
+    std::size_t blocksRead() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return blocksRead_;
+    }
+
+private:
+    static constexpr std::size_t kInitialDepth = 4;
+
+    void run() {
+        DiskStorage disk(totalBlocks_, basePath_, blockSize_);
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (true) {
+            wake_.wait(lock, [this]() {
+                return stop_ || (next_ < blocks_.size() && next_ <= position_ + depth_);
+            });
+            if (stop_) {
+                return;
+            }
+            const BlockAddress address = blocks_[next_++];
+            lock.unlock();
+            try {
+                disk.readBlock(address);
+            } catch (const std::exception &) {
+                // Only a hint: the scan's own fetch reports real errors.
+            }
+            lock.lock();
+            ++blocksRead_;
+        }
+    }
+
+    const std::vector<BlockAddress> blocks_;
+    const std::size_t totalBlocks_;
+    const std::string basePath_;
+    const std::size_t blockSize_;
+    const std::size_t maxDepth_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable wake_;
+    std::size_t depth_;
+    std::size_t position_{0};
+    std::size_t next_{0};
+    std::size_t blocksRead_{0};
+    bool lastLate_{false};
+    bool stop_{false};
+
+    ReadAheadStats &stats_;
+    std::thread thread_;
+};
+
+} // namespace dbms
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+#include "storage/buffer_pool.h"
+#include "storage/disk_manager.h"
+
+namespace dbms {
+
+// A few private frames over the same block files as the shared pool. Bulk
+// reads go through one so that a scan of a large table recycles these
+// frames instead of evicting everything else from the shared pool, and so
+// that build workers can read without touching the shared pool at all.
+// Reading through a ring is only correct while the block files hold every
+// change: the owner flushes the shared pool first and stops using the ring
+// once a table block is written again (see writeEpoch()).
+class ScanRing {
+public:
+    static constexpr std::size_t kFrames = 4;
+
+    ScanRing(std::size_t totalBlocks, const std::string &basePath, std::size_t blockSize, std::size_t writeEpoch)
+        : disk_(totalBlocks, basePath, blockSize), pool_(kFrames, disk_), writeEpoch_(writeEpoch) {}
+
+    ScanRing(const ScanRing &) = delete;
+    ScanRing &operator=(const ScanRing &) = delete;
+
+    BufferPool &pool() {
+        return pool_;
+    }
+
+    // Count of table block writes when the ring was opened.
+    std::size_t writeEpoch() const {
+        return writeEpoch_;
+    }
+
+private:
+    DiskStorage disk_;
+    BufferPool pool_;
+    std::size_t writeEpoch_;
+};
+
+} // namespace dbms
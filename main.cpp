@@ -14,6 +14,7 @@
 using dbms::ColumnDefinition;
 using dbms::ColumnType;
 using dbms::DatabaseSystem;
+using dbms::IndexMethod;
 using dbms::Record;
 using dbms::TableSchema;
 
@@ -199,7 +200,9 @@ std::optional<TableSchema> parseCreateTableCommand(const std::string &line) {
 bool parseCreateIndexCommand(const std::string &line,
                              std::string &indexName,
                              std::string &tableName,
-                             std::string &columnName) {
+                             std::vector<std::string> &columnNames,
+                             std::vector<std::string> &includeColumns,
+                             IndexMethod &method) {
     const std::string keyword = "create index";
     if (!startsWithCaseInsensitive(trim(line), keyword)) {
         return false;
@@ -241,8 +244,69 @@ bool parseCreateIndexCommand(const std::string &line,
     if (open == std::string::npos || close == std::string::npos || close <= open + 1) {
         return false;
     }
-    columnName = trim(work.substr(open + 1, close - open - 1));
-    return !(indexName.empty() || tableName.empty() || columnName.empty());
+    // "USING HASH|BITMAP" may precede the column list or follow it.
+    method = IndexMethod::BPlusTree;
+    auto parseMethod = [&](const std::string &clause) {
+        const auto words = split(toLowerCopy(clause), ' ');
+        std::vector<std::string> tokens;
+        for (const auto &word : words) {
+            if (!trim(word).empty()) {
+                tokens.push_back(trim(word));
+            }
+        }
+        if (tokens.size() != 2 || tokens[0] != "using") {
+            return false;
+        }
+        if (tokens[1] == "hash") {
+            method = IndexMethod::Hash;
+        } else if (tokens[1] == "bitmap") {
+            method = IndexMethod::Bitmap;
+        } else if (tokens[1] != "btree") {
+            return false;
+        }
+        return true;
+    };
+    const std::string beforeColumns = trim(work.substr(onPos, open - onPos));
+    if (!beforeColumns.empty() && !parseMethod(beforeColumns)) {
+        return false;
+    }
+    columnNames.clear();
+    for (const auto &part : split(work.substr(open + 1, close - open - 1), ',')) {
+        const auto columnName = trim(part);
+        if (columnName.empty()) {
+            return false;
+        }
+        columnNames.push_back(columnName);
+    }
+    includeColumns.clear();
+    std::string rest = trim(work.substr(close + 1));
+    const auto usingPos = toLowerCopy(rest).rfind("using ");
+    if (beforeColumns.empty() && usingPos != std::string::npos &&
+        rest.find(')', usingPos) == std::string::npos) {
+        if (!parseMethod(rest.substr(usingPos))) {
+            return false;
+        }
+        rest = trim(rest.substr(0, usingPos));
+    }
+    if (!rest.empty()) {
+        if (!startsWithCaseInsensitive(rest, "include")) {
+            return false;
+        }
+        auto includeOpen = rest.find('(');
+        auto includeClose = rest.find(')', includeOpen);
+        if (includeOpen == std::string::npos || includeClose == std::string::npos ||
+            !trim(rest.substr(7, includeOpen - 7)).empty()) {
+            return false;
+        }
+        for (const auto &part : split(rest.substr(includeOpen + 1, includeClose - includeOpen - 1), ',')) {
+            const auto columnName = trim(part);
+            if (columnName.empty()) {
+                return false;
+            }
+            includeColumns.push_back(columnName);
+        }
+    }
+    return !(indexName.empty() || tableName.empty() || columnNames.empty());
 }
 
 bool parseInsertCommand(const std::string &line,
@@ -382,6 +446,8 @@ struct Config {
     std::size_t blockSizeBytes{4096};
     std::size_t memoryBytes{32 * 1024 * 1024}; // 32 MiB
     std::size_t diskBytes{256 * 1024 * 1024};  // 256 MiB
+    std::size_t indexBuildThreads{0};          // one per hardware thread
+    std::size_t readAheadDepth{DatabaseSystem::defaultReadAheadDepth()};  // blocks, 0 = off
 };
 
 std::size_t parseBytes(const std::string &text) {
@@ -422,6 +488,8 @@ Config parseArgs(int argc, char **argv) {
         takeValue("block-size", cfg.blockSizeBytes);
         takeValue("memory", cfg.memoryBytes);
         takeValue("disk", cfg.diskBytes);
+        takeValue("index-build-threads", cfg.indexBuildThreads);
+        takeValue("read-ahead", cfg.readAheadDepth);
     }
     return cfg;
 }
@@ -430,7 +498,10 @@ void printHelp() {
     std::cout << "Commands:\n";
     std::cout << "  CREATE TABLE name (col TYPE(len), ...)  - define table schema\n";
     std::cout << "    Shorthand: name col1:int:16,col2:string:64\n";
-    std::cout << "  CREATE INDEX idx ON table(column)       - build B+tree index\n";
+    std::cout << "  CREATE INDEX idx ON table(col[, ...])   - build B+tree index\n";
+    std::cout << "      [INCLUDE (col[, ...])]              - store extra columns in the index\n";
+    std::cout << "      [USING HASH]                        - hash index for equality lookups\n";
+    std::cout << "      [USING BITMAP]                      - bitmap index for low-cardinality columns\n";
     std::cout << "  INSERT INTO table VALUES (v1, v2, ...)  - append a record\n";
     std::cout << "  SELECT ...                              - run a query (supports joins, sort, agg)\n";
     std::cout << "  BEGIN / COMMIT / ROLLBACK               - transaction control\n";
@@ -525,6 +596,8 @@ int main(int argc, char **argv) {
 
     try {
         DatabaseSystem db(cfg.blockSizeBytes, cfg.memoryBytes, cfg.diskBytes);
+        db.setIndexBuildThreads(cfg.indexBuildThreads);
+        db.setReadAheadDepth(cfg.readAheadDepth);
         SchemaRegistry registry;
         auto schemas = registry.load();
 
@@ -691,10 +764,13 @@ int main(int argc, char **argv) {
                 continue;
             }
 
-            std::string idxName, tblName, colName;
-            if (parseCreateIndexCommand(line, idxName, tblName, colName)) {
+            std::string idxName, tblName;
+            std::vector<std::string> colNames;
+            std::vector<std::string> includeNames;
+            IndexMethod indexMethod = IndexMethod::BPlusTree;
+            if (parseCreateIndexCommand(line, idxName, tblName, colNames, includeNames, indexMethod)) {
                 try {
-                    auto pages = db.createIndex(idxName, tblName, colName);
+                    auto pages = db.createIndex(idxName, tblName, colNames, includeNames, indexMethod);
                     std::cout << "Index '" << idxName << "' created (" << pages.size()
                               << " page(s)).\n";
                 } catch (const std::exception &ex) {
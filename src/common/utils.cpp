@@ -12,6 +12,7 @@
 #else
 #include <sys/stat.h>
 #include <sys/types.h>
+#define mkdir(path) mkdir(path, 0755)
 #endif
 
 namespace dbms::pathutil {
@@ -0,0 +1,112 @@
+#include "executor/bitmap_scan.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace dbms {
+
+BitmapScanOperator::BitmapScanOperator(DatabaseSystem& db, std::string table, BitmapPredicate predicate)
+    : db_(db),
+      tableName_(std::move(table)),
+      predicate_(std::move(predicate)) {}
+
+void BitmapScanOperator::init() {
+    if (initialized_) {
+        return;
+    }
+    if (predicate_.empty()) {
+        throw std::logic_error("bitmap scan on " + tableName_ + " has no predicate");
+    }
+    schema_ = buildSchemaFromTable(db_.getTable(tableName_));
+    targets_.clear();
+    evaluate().forEachBlock([&](std::size_t block, const std::vector<std::uint16_t>& slots) {
+        targets_.emplace_back(block, slots);
+    });
+    nextTarget_ = 0;
+    currentRows_.clear();
+    currentRow_ = 0;
+    initialized_ = true;
+}
+
+// Conjuncts are intersected smallest first, so later bitmaps only have to
+// be matched against what is left.
+RowBitmap BitmapScanOperator::evaluate() const {
+    std::vector<RowBitmap> conjuncts;
+    conjuncts.reserve(predicate_.size());
+    for (const auto& terms : predicate_) {
+        RowBitmap any;
+        for (const auto& term : terms) {
+            any = RowBitmap::unite(any, db_.searchIndexBitmap(term.index, term.value));
+        }
+        conjuncts.push_back(std::move(any));
+    }
+    std::sort(conjuncts.begin(), conjuncts.end(), [](const RowBitmap& a, const RowBitmap& b) {
+        return a.cardinality() < b.cardinality();
+    });
+    RowBitmap result = std::move(conjuncts.front());
+    for (std::size_t i = 1; i < conjuncts.size() && !result.empty(); ++i) {
+        result = RowBitmap::intersect(result, conjuncts[i]);
+    }
+    return result;
+}
+
+std::optional<Tuple> BitmapScanOperator::next() {
+    if (!initialized_) {
+        throw std::logic_error("operator not initialized");
+    }
+    while (currentRow_ >= currentRows_.size()) {
+        if (nextTarget_ >= targets_.size()) {
+            return std::nullopt;
+        }
+        fetchNextBlock();
+    }
+    auto& row = currentRows_[currentRow_++];
+    position_ = IndexPointer{BlockAddress{tableName_, currentBlock_}, row.first};
+    Tuple tuple;
+    tuple.values = std::move(row.second.values);
+    tuple.schema = std::make_shared<Schema>(schema_);
+    return tuple;
+}
+
+void BitmapScanOperator::close() {
+    initialized_ = false;
+    targets_.clear();
+    currentRows_.clear();
+}
+
+void BitmapScanOperator::reset() {
+    initialized_ = false;
+    targets_.clear();
+    currentRows_.clear();
+}
+
+void BitmapScanOperator::fetchNextBlock() {
+    const auto& target = targets_[nextTarget_++];
+    currentBlock_ = target.first;
+    currentRows_.clear();
+    currentRow_ = 0;
+    auto fetchResult = db_.pages().fetch(BlockAddress{tableName_, target.first}, false);
+    fetchResult.block.ensureInitialized(db_.blockSize());
+    for (auto slot : target.second) {
+        if (const Record* record = fetchResult.block.getRecord(slot)) {
+            currentRows_.emplace_back(slot, *record);
+        }
+    }
+}
+
+Schema BitmapScanOperator::buildSchemaFromTable(const Table& table) {
+    Schema schema;
+    const auto& tableName = table.schema().name();
+    const auto& columns = table.schema().columns();
+    for (std::size_t i = 0; i < columns.size(); ++i) {
+        ColumnInfo col;
+        col.name = columns[i].name;
+        col.type = columns[i].type;
+        col.sourceIndex = i;
+        col.tableName = tableName;
+        schema.addColumn(col);
+    }
+    return schema;
+}
+
+} // namespace dbms
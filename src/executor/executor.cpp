@@ -1,6 +1,7 @@
 #include "executor/executor.h"
 
 #include "executor/aggregate.h"
+#include "executor/bitmap_scan.h"
 #include "executor/expression_parser.h"
 #include "executor/filter.h"
 #include "executor/index_scan.h"
@@ -232,6 +233,68 @@ ResultSet QueryExecutor::execute(std::shared_ptr<PhysicalPlanNode> plan) {
     return results;
 }
 
+std::vector<LocatedRow> QueryExecutor::locateRows(const std::string& table, const std::string& condition) {
+    std::unique_ptr<Expression> predicate;
+    std::shared_ptr<PhysicalPlanNode> indexScan;
+    if (!condition.empty()) {
+        predicate = parseExpression(condition);
+        auto scan = std::make_shared<RelAlgNode>(RelAlgOpType::kScan, "Scan table " + table);
+        scan->tableName = table;
+        auto select = std::make_shared<RelAlgNode>(RelAlgOpType::kSelect, "Apply filter: " + condition);
+        select->condition = condition;
+        select->addChild(scan);
+        PhysicalPlanGenerator planner(db_);
+        indexScan = planner.generatePhysicalPlan(select);
+        while (indexScan && indexScan->opType != PhysicalOpType::kIndexScan &&
+               indexScan->opType != PhysicalOpType::kBitmapScan) {
+            indexScan = indexScan->children.empty() ? nullptr : indexScan->children[0];
+        }
+    }
+
+    // The index only narrows the candidates; the whole condition decides.
+    std::vector<LocatedRow> rows;
+    auto drain = [&](auto& scan) {
+        scan.init();
+        while (auto tuple = scan.next()) {
+            if (predicate && !predicate->evaluate(*tuple).asBool()) {
+                continue;
+            }
+            rows.push_back(LocatedRow{scan.position(), Record(std::move(tuple->values))});
+        }
+        scan.close();
+    };
+    if (indexScan && indexScan->opType == PhysicalOpType::kBitmapScan) {
+        auto op = buildBitmapScan(indexScan);
+        drain(static_cast<BitmapScanOperator&>(*op));
+        return rows;
+    }
+    if (indexScan) {
+        auto op = buildIndexScan(indexScan);
+        drain(static_cast<IndexScanOperator&>(*op));
+        return rows;
+    }
+
+    const Table& source = db_.getTable(table);
+    auto schema = std::make_shared<Schema>();
+    const auto& columns = source.schema().columns();
+    for (std::size_t i = 0; i < columns.size(); ++i) {
+        schema->addColumn(ColumnInfo{columns[i].name, columns[i].type, i, table});
+    }
+    auto ring = db_.startBulkRead(source.blocks().size());
+    for (const auto& addr : source.blocks()) {
+        auto fetchResult = db_.fetchBulk(ring.get(), addr);
+        fetchResult.block.ensureInitialized(db_.blockSize());
+        fetchResult.block.page.forEachRecord(
+            [&](std::size_t slotIdx, const Record& record) {
+                if (predicate && !predicate->evaluate(Tuple{record.values, schema}).asBool()) {
+                    return;
+                }
+                rows.push_back(LocatedRow{IndexPointer{addr, slotIdx}, record});
+            });
+    }
+    return rows;
+}
+
 std::unique_ptr<Operator> QueryExecutor::buildOperatorTree(std::shared_ptr<PhysicalPlanNode> planNode) {
     if (!planNode) {
         throw std::runtime_error("null plan node");
@@ -244,6 +307,9 @@ std::unique_ptr<Operator> QueryExecutor::buildOperatorTree(std::shared_ptr<Physi
         case PhysicalOpType::kIndexScan:
             return buildIndexScan(planNode);
 
+        case PhysicalOpType::kBitmapScan:
+            return buildBitmapScan(planNode);
+
         case PhysicalOpType::kFilter:
             if (planNode->children.empty()) {
                 throw std::runtime_error("FILTER node has no child");
@@ -268,6 +334,9 @@ std::unique_ptr<Operator> QueryExecutor::buildOperatorTree(std::shared_ptr<Physi
         case PhysicalOpType::kHashJoin:
             return buildHashJoin(planNode);
 
+        case PhysicalOpType::kIndexNestedLoopJoin:
+            return buildIndexNestedLoopJoin(planNode);
+
         case PhysicalOpType::kSort:
             if (planNode->children.empty()) {
                 throw std::runtime_error("SORT node has no child");
@@ -311,14 +380,64 @@ std::unique_ptr<Operator> QueryExecutor::buildIndexScan(std::shared_ptr<Physical
     auto indexIt = planNode->parameters.find("index");
     auto keyIt = planNode->parameters.find("key");
     if (tableIt == planNode->parameters.end() ||
-        indexIt == planNode->parameters.end() ||
-        keyIt == planNode->parameters.end()) {
+        indexIt == planNode->parameters.end()) {
         throw std::runtime_error("INDEX_SCAN node missing required parameters");
     }
-    return std::make_unique<IndexScanOperator>(db_,
-                                               tableIt->second,
-                                               indexIt->second,
-                                               keyIt->second);
+    std::unique_ptr<IndexScanOperator> scan;
+    if (keyIt == planNode->parameters.end()) {
+        IndexScanRange range;
+        auto prefixIt = planNode->parameters.find("prefix_size");
+        if (prefixIt != planNode->parameters.end()) {
+            const auto count = static_cast<std::size_t>(std::stoull(prefixIt->second));
+            for (std::size_t i = 0; i < count; ++i) {
+                range.prefix.push_back(planNode->parameters["prefix_" + std::to_string(i)]);
+            }
+        }
+        auto lowerIt = planNode->parameters.find("lower");
+        if (lowerIt != planNode->parameters.end()) {
+            range.lower = lowerIt->second;
+            range.lowerInclusive = planNode->parameters["lower_inclusive"] != "false";
+        }
+        auto upperIt = planNode->parameters.find("upper");
+        if (upperIt != planNode->parameters.end()) {
+            range.upper = upperIt->second;
+            range.upperInclusive = planNode->parameters["upper_inclusive"] != "false";
+        }
+        scan = std::make_unique<IndexScanOperator>(db_,
+                                                   tableIt->second,
+                                                   indexIt->second,
+                                                   std::move(range));
+    } else {
+        scan = std::make_unique<IndexScanOperator>(db_,
+                                                   tableIt->second,
+                                                   indexIt->second,
+                                                   keyIt->second);
+    }
+    auto indexOnlyIt = planNode->parameters.find("index_only");
+    scan->setIndexOnly(indexOnlyIt != planNode->parameters.end() && indexOnlyIt->second == "true");
+    return scan;
+}
+
+std::unique_ptr<Operator> QueryExecutor::buildBitmapScan(std::shared_ptr<PhysicalPlanNode> planNode) {
+    auto tableIt = planNode->parameters.find("table");
+    auto conjunctsIt = planNode->parameters.find("conjuncts");
+    if (tableIt == planNode->parameters.end() ||
+        conjunctsIt == planNode->parameters.end()) {
+        throw std::runtime_error("BITMAP_SCAN node missing required parameters");
+    }
+    BitmapPredicate predicate;
+    const auto conjuncts = static_cast<std::size_t>(std::stoull(conjunctsIt->second));
+    for (std::size_t i = 0; i < conjuncts; ++i) {
+        const std::string prefix = "conjunct_" + std::to_string(i);
+        const auto terms = static_cast<std::size_t>(std::stoull(planNode->parameters[prefix + "_terms"]));
+        std::vector<BitmapTerm> disjunction;
+        for (std::size_t j = 0; j < terms; ++j) {
+            disjunction.push_back(BitmapTerm{planNode->parameters[prefix + "_index_" + std::to_string(j)],
+                                             planNode->parameters[prefix + "_value_" + std::to_string(j)]});
+        }
+        predicate.push_back(std::move(disjunction));
+    }
+    return std::make_unique<BitmapScanOperator>(db_, tableIt->second, std::move(predicate));
 }
 
 std::unique_ptr<Operator> QueryExecutor::buildFilter(
@@ -406,6 +525,53 @@ std::unique_ptr<Operator> QueryExecutor::buildHashJoin(std::shared_ptr<PhysicalP
                                               joinType);
 }
 
+// The second child is the inner index scan, optionally under an alias; it is
+// built here rather than by buildIndexScan because the join rebinds its key.
+std::unique_ptr<Operator> QueryExecutor::buildIndexNestedLoopJoin(std::shared_ptr<PhysicalPlanNode> planNode) {
+    if (planNode->children.size() < 2) {
+        throw std::runtime_error("INDEX_NESTED_LOOP_JOIN requires two children");
+    }
+    auto innerPlan = planNode->children[1];
+    auto probePlan = innerPlan;
+    if (probePlan->opType == PhysicalOpType::kAlias && !probePlan->children.empty()) {
+        probePlan = probePlan->children[0];
+    }
+    auto tableIt = probePlan->parameters.find("table");
+    auto indexIt = probePlan->parameters.find("index");
+    auto outerKeyIt = planNode->parameters.find("outer_key");
+    if (probePlan->opType != PhysicalOpType::kIndexScan ||
+        tableIt == probePlan->parameters.end() ||
+        indexIt == probePlan->parameters.end() ||
+        outerKeyIt == planNode->parameters.end()) {
+        throw std::runtime_error("INDEX_NESTED_LOOP_JOIN missing inner index probe");
+    }
+
+    auto outer = buildOperatorTree(planNode->children[0]);
+    auto scan = std::make_unique<IndexScanOperator>(db_, tableIt->second, indexIt->second, std::string());
+    IndexScanOperator& probe = *scan;
+    std::unique_ptr<Operator> inner = std::move(scan);
+    if (innerPlan != probePlan) {
+        inner = buildAlias(innerPlan, std::move(inner));
+    }
+
+    std::string condition;
+    auto condIt = planNode->parameters.find("condition");
+    if (condIt != planNode->parameters.end()) {
+        condition = condIt->second;
+    }
+    auto jtIt = planNode->parameters.find("join_type");
+    JoinType joinType = planNode->joinType;
+    if (jtIt != planNode->parameters.end()) {
+        joinType = parseJoinType(jtIt->second);
+    }
+    return std::make_unique<IndexNestedLoopJoinOperator>(std::move(outer),
+                                                         std::move(inner),
+                                                         probe,
+                                                         condition,
+                                                         outerKeyIt->second,
+                                                         joinType);
+}
+
 std::unique_ptr<Operator> QueryExecutor::buildSort(
     std::shared_ptr<PhysicalPlanNode> planNode,
     std::unique_ptr<Operator> child) {
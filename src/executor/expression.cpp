@@ -176,6 +176,49 @@ ExprValue LogicalExpr::evaluate(const Tuple& tuple) const {
     return ExprValue(ExprValue::Type::BOOLEAN, result ? "true" : "false");
 }
 
+// ============== LikeExpr Implementation ==============
+
+ExprValue LikeExpr::evaluate(const Tuple& tuple) const {
+    ExprValue val = value_->evaluate(tuple);
+    ExprValue pat = pattern_->evaluate(tuple);
+    if (val.isNull() || pat.isNull()) {
+        return ExprValue(ExprValue::Type::BOOLEAN, "false");
+    }
+    bool result = matches(val.asString(), pat.asString());
+    return ExprValue(ExprValue::Type::BOOLEAN, result ? "true" : "false");
+}
+
+bool LikeExpr::matches(const std::string& text, const std::string& pattern) {
+    // Greedy matcher that backtracks to the most recent '%'.
+    std::size_t t = 0;
+    std::size_t p = 0;
+    std::size_t starP = std::string::npos;
+    std::size_t starT = 0;
+    while (t < text.size()) {
+        if (p < pattern.size() && pattern[p] == '%') {
+            starP = p++;
+            starT = t;
+        } else if (p < pattern.size() && (pattern[p] == '_' || pattern[p] == text[t])) {
+            ++t;
+            ++p;
+        } else if (starP != std::string::npos) {
+            p = starP + 1;
+            t = ++starT;
+        } else {
+            return false;
+        }
+    }
+    while (p < pattern.size() && pattern[p] == '%') {
+        ++p;
+    }
+    return p == pattern.size();
+}
+
+std::string LikeExpr::literalPrefix(const std::string& pattern) {
+    std::size_t end = pattern.find_first_of("%_");
+    return pattern.substr(0, end);
+}
+
 // ============== BinaryOpExpr Implementation ==============
 
 ExprValue BinaryOpExpr::evaluate(const Tuple& tuple) const {
@@ -74,6 +74,8 @@ std::vector<ExprToken> ExpressionParser::tokenize(const std::string& input) {
                 tokens.emplace_back(ExprToken::Type::KEYWORD, "OR");
             } else if (value == "NOT" || value == "not") {
                 tokens.emplace_back(ExprToken::Type::KEYWORD, "NOT");
+            } else if (value == "LIKE" || value == "like") {
+                tokens.emplace_back(ExprToken::Type::KEYWORD, "LIKE");
             } else {
                 tokens.emplace_back(ExprToken::Type::IDENTIFIER, value);
             }
@@ -204,6 +206,12 @@ std::unique_ptr<Expression> ExpressionParser::parseAndExpression() {
 std::unique_ptr<Expression> ExpressionParser::parseComparisonExpression() {
     auto left = parseAdditiveExpression();
 
+    if (check(ExprToken::Type::KEYWORD) && checkValue("LIKE")) {
+        advance();
+        auto pattern = parseAdditiveExpression();
+        return std::make_unique<LikeExpr>(std::move(left), std::move(pattern));
+    }
+
     if (check(ExprToken::Type::OPERATOR)) {
         std::string op = current().value;
         ComparisonExpr::Op compOp;
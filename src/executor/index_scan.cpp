@@ -11,18 +11,125 @@ IndexScanOperator::IndexScanOperator(DatabaseSystem& db,
     : db_(db),
       tableName_(std::move(table)),
       indexName_(std::move(index)),
-      searchKey_(std::move(key)) {}
+      range_(IndexScanRange{{}, key, true, key, true}) {}
+
+IndexScanOperator::IndexScanOperator(DatabaseSystem& db,
+                                     std::string table,
+                                     std::string index,
+                                     IndexScanRange range)
+    : db_(db),
+      tableName_(std::move(table)),
+      indexName_(std::move(index)),
+      range_(std::move(range)) {}
 
 void IndexScanOperator::init() {
     if (initialized_) {
         return;
     }
-    const auto& table = db_.getTable(tableName_);
-    schema_ = buildSchemaFromTable(table);
+    if (indexOnly_) {
+        const auto& definition = db_.getIndexDefinition(indexName_);
+        if (!definition.covering()) {
+            throw std::logic_error("index " + indexName_ + " stores no column values");
+        }
+        schema_ = buildSchemaFromIndex(definition);
+    } else {
+        schema_ = buildSchemaFromTable(db_.getTable(tableName_));
+    }
     done_ = false;
+    pending_.clear();
+    pendingKeys_.clear();
+    resumeKey_.reset();
+    nullProbed_ = false;
+    if (!boundsEncoded_) {
+        encodeBounds();
+        boundsEncoded_ = true;
+    }
+    exhausted_ = emptyRange_;
     initialized_ = true;
 }
 
+// Bounds arrive as column values and are compared as stored keys. A string
+// key holds at most keyLength bytes, so a bound cut to that length has to
+// become inclusive. On a composite index the bounds apply to the column after
+// the equality prefix; unless that column is the last one, its part is padded
+// and followed by the remaining columns, so an inclusive upper bound and an
+// exclusive lower bound step past every key that starts with the bound. A
+// covering index pads the whole key the same way, since the stored values
+// follow it. Hash and bitmap indexes keep no order, so they only take a
+// single value.
+void IndexScanOperator::encodeBounds() {
+    const auto& definition = db_.getIndexDefinition(indexName_);
+    const auto columns = definition.keyColumns();
+    const auto& prefix = range_.prefix;
+    if (!definition.ordered()) {
+        if (prefix.size() == 1 && !range_.lower && !range_.upper) {
+            probeValue_ = prefix.front();
+        } else if (prefix.empty() && range_.lower && range_.upper && *range_.lower == *range_.upper &&
+                   range_.lowerInclusive && range_.upperInclusive) {
+            probeValue_ = *range_.lower;
+        } else {
+            throw std::logic_error("index " + indexName_ + " only answers equality lookups");
+        }
+        return;
+    }
+    const std::string prefixKey = db_.indexKeyFor(indexName_, prefix);
+    if (prefix.size() >= columns.size()) {
+        range_.lower = prefixKey;
+        range_.lowerInclusive = true;
+        if (definition.covering()) {
+            range_.upper = indexKeySuccessor(prefixKey);
+            range_.upperInclusive = false;
+        } else {
+            range_.upper = prefixKey;
+            range_.upperInclusive = true;
+        }
+        return;
+    }
+    const auto& column = columns[prefix.size()];
+    const bool padded = prefix.size() + 1 < columns.size() || definition.covering();
+    auto keyFor = [&](const std::string& value) {
+        if (!definition.composite()) {
+            return db_.indexKeyFor(indexName_, value);
+        }
+        auto values = prefix;
+        values.push_back(value);
+        return db_.indexKeyFor(indexName_, values);
+    };
+    auto truncated = [&](const std::string& value) {
+        return column.type == ColumnType::String && value.size() > column.keyLength;
+    };
+
+    if (range_.lower) {
+        const bool inclusive = range_.lowerInclusive || truncated(*range_.lower);
+        range_.lower = keyFor(*range_.lower);
+        range_.lowerInclusive = true;
+        if (!inclusive) {
+            if (padded) {
+                range_.lower = indexKeySuccessor(*range_.lower);
+                emptyRange_ = !range_.lower;
+            } else {
+                range_.lowerInclusive = false;
+            }
+        }
+    } else if (!prefix.empty()) {
+        range_.lower = prefixKey;
+        range_.lowerInclusive = true;
+    }
+
+    if (range_.upper) {
+        const bool inclusive = range_.upperInclusive || truncated(*range_.upper);
+        range_.upper = keyFor(*range_.upper);
+        range_.upperInclusive = inclusive;
+        if (inclusive && padded) {
+            range_.upper = indexKeySuccessor(*range_.upper);
+            range_.upperInclusive = false;
+        }
+    } else if (!prefix.empty()) {
+        range_.upper = indexKeySuccessor(prefixKey);
+        range_.upperInclusive = false;
+    }
+}
+
 std::optional<Tuple> IndexScanOperator::next() {
     if (!initialized_) {
         throw std::logic_error("operator not initialized");
@@ -31,30 +138,136 @@ std::optional<Tuple> IndexScanOperator::next() {
         return std::nullopt;
     }
 
-    auto ptr = db_.searchIndex(indexName_, searchKey_);
-    done_ = true;
-    if (!ptr.has_value()) {
-        return std::nullopt;
+    while (true) {
+        if (pending_.empty()) {
+            if (exhausted_) {
+                done_ = true;
+                return std::nullopt;
+            }
+            fillBatch();
+            continue;
+        }
+        IndexPointer ptr = pending_.front();
+        pending_.pop_front();
+        if (indexOnly_) {
+            const std::string key = std::move(pendingKeys_.front());
+            pendingKeys_.pop_front();
+            position_ = ptr;
+            Tuple tuple;
+            tuple.values = decodeCoveredIndexValues(key, db_.getIndexDefinition(indexName_));
+            tuple.schema = std::make_shared<Schema>(schema_);
+            return tuple;
+        }
+        auto record = db_.readRecord(ptr.address, ptr.slot);
+        if (!record.has_value()) {
+            continue;
+        }
+        position_ = ptr;
+        Tuple tuple;
+        tuple.values = std::move(record->values);
+        tuple.schema = std::make_shared<Schema>(schema_);
+        return tuple;
     }
-    auto record = db_.readRecord(ptr->address, ptr->slot);
-    if (!record.has_value()) {
-        return std::nullopt;
-    }
-
-    Tuple tuple;
-    tuple.values = std::move(record->values);
-    tuple.schema = std::make_shared<Schema>(schema_);
-    return tuple;
 }
 
 void IndexScanOperator::close() {
     initialized_ = false;
     done_ = true;
+    pending_.clear();
+    pendingKeys_.clear();
 }
 
 void IndexScanOperator::reset() {
     done_ = false;
     initialized_ = false;
+    pending_.clear();
+    pendingKeys_.clear();
+}
+
+void IndexScanOperator::rebind(const std::string& key) {
+    if (!initialized_) {
+        throw std::logic_error("operator not initialized");
+    }
+    range_ = IndexScanRange{{}, key, true, key, true};
+    emptyRange_ = false;
+    encodeBounds();
+    boundsEncoded_ = true;
+    pending_.clear();
+    pendingKeys_.clear();
+    resumeKey_.reset();
+    nullProbed_ = false;
+    exhausted_ = emptyRange_;
+    done_ = false;
+}
+
+void IndexScanOperator::fillBatch() {
+    if (probeValue_) {
+        for (const auto& ptr : db_.searchIndexAll(indexName_, *probeValue_)) {
+            pending_.push_back(ptr);
+        }
+        exhausted_ = true;
+        return;
+    }
+
+    // NULL sorts below every value in predicates. Numeric keys store it
+    // first, but string keys hold the text "NULL", so an open lower bound
+    // probes it separately when it falls outside the range.
+    if (!range_.lower && !nullProbed_) {
+        nullProbed_ = true;
+        const std::string nullKey = db_.indexKeyFor(indexName_, "NULL");
+        const bool inRange = !range_.upper || nullKey < *range_.upper ||
+                             (range_.upperInclusive && nullKey == *range_.upper);
+        const auto& definition = db_.getIndexDefinition(indexName_);
+        if (!inRange && (definition.composite() || definition.covering())) {
+            db_.scanIndex(indexName_, nullKey, true,
+                          [&](const std::string& key, const IndexPointer& ptr) {
+                              if (key.compare(0, nullKey.size(), nullKey) != 0) {
+                                  return false;
+                              }
+                              enqueue(key, ptr);
+                              return true;
+                          });
+        } else if (!inRange) {
+            for (const auto& ptr : db_.searchIndexAll(indexName_, "NULL")) {
+                pending_.push_back(ptr);
+            }
+        }
+    }
+
+    // The scan resumes after resumeKey_, so a batch only ends between keys:
+    // every pointer of the last key is taken even past kBatchSize.
+    const bool resuming = resumeKey_.has_value();
+    const auto& start = resuming ? resumeKey_ : range_.lower;
+    const bool startInclusive = resuming ? false : range_.lowerInclusive;
+    std::size_t collected = 0;
+    bool full = false;
+    db_.scanIndex(indexName_, start, startInclusive,
+                  [&](const std::string& key, const IndexPointer& ptr) {
+                      if (range_.upper) {
+                          const int cmp = key.compare(*range_.upper);
+                          if (cmp > 0 || (cmp == 0 && !range_.upperInclusive)) {
+                              return false;
+                          }
+                      }
+                      if (collected >= kBatchSize && key != *resumeKey_) {
+                          full = true;
+                          return false;
+                      }
+                      enqueue(key, ptr);
+                      resumeKey_ = key;
+                      ++collected;
+                      return true;
+                  });
+    if (!full) {
+        exhausted_ = true;
+    }
+}
+
+void IndexScanOperator::enqueue(const std::string& key, const IndexPointer& ptr) {
+    pending_.push_back(ptr);
+    if (indexOnly_) {
+        pendingKeys_.push_back(key);
+    }
 }
 
 Schema IndexScanOperator::buildSchemaFromTable(const Table& table) {
@@ -72,4 +285,17 @@ Schema IndexScanOperator::buildSchemaFromTable(const Table& table) {
     return schema;
 }
 
+Schema IndexScanOperator::buildSchemaFromIndex(const IndexDefinition& definition) {
+    Schema schema;
+    for (const auto& covered : definition.coveredColumns) {
+        ColumnInfo col;
+        col.name = covered.name;
+        col.type = covered.type;
+        col.sourceIndex = covered.index;
+        col.tableName = definition.tableName;
+        schema.addColumn(col);
+    }
+    return schema;
+}
+
 } // namespace dbms
@@ -280,4 +280,131 @@ Tuple HashJoinOperator::combineTuples(const Tuple& left, const Tuple& right) con
     return combined;
 }
 
+IndexNestedLoopJoinOperator::IndexNestedLoopJoinOperator(std::unique_ptr<Operator> outer,
+                                                         std::unique_ptr<Operator> inner,
+                                                         IndexScanOperator& probe,
+                                                         std::string condition,
+                                                         std::string outerKey,
+                                                         JoinType joinType)
+    : outer_(std::move(outer)),
+      inner_(std::move(inner)),
+      probe_(probe),
+      condition_(std::move(condition)),
+      outerKey_(std::move(outerKey)),
+      joinType_(joinType) {}
+
+void IndexNestedLoopJoinOperator::init() {
+    if (initialized_) {
+        return;
+    }
+
+    if (joinType_ == JoinType::kRight) {
+        throw std::runtime_error("Index nested loop join supports only inner and left joins");
+    }
+
+    outer_->init();
+    inner_->init();
+
+    outputSchema_ = std::make_shared<Schema>();
+    for (const auto& col : outer_->getSchema().columns()) {
+        outputSchema_->addColumn(col);
+    }
+    for (const auto& col : inner_->getSchema().columns()) {
+        outputSchema_->addColumn(col);
+    }
+
+    if (!condition_.empty()) {
+        ExpressionParser parser;
+        predicate_ = parser.parse(condition_);
+    }
+    currentOuter_.reset();
+    probing_ = false;
+    currentMatched_ = false;
+    initialized_ = true;
+}
+
+std::optional<Tuple> IndexNestedLoopJoinOperator::next() {
+    if (!initialized_) {
+        throw std::logic_error("operator not initialized");
+    }
+
+    while (true) {
+        if (!currentOuter_) {
+            currentOuter_ = outer_->next();
+            currentMatched_ = false;
+            if (!currentOuter_) {
+                return std::nullopt;
+            }
+            // NULL equals nothing, so such a row has no matches to probe for.
+            const std::string& key = currentOuter_->getValue(outerKey_);
+            probing_ = key != "NULL";
+            if (probing_) {
+                probe_.rebind(key);
+            }
+        }
+
+        // The index narrows the inner rows to the key; the full condition
+        // still decides, as string keys may be cut to the key length.
+        while (probing_) {
+            auto innerTuple = inner_->next();
+            if (!innerTuple) {
+                probing_ = false;
+                break;
+            }
+            Tuple combined = combineTuples(*currentOuter_, *innerTuple);
+            if (predicate_) {
+                ExprValue res = predicate_->evaluate(combined);
+                if (!res.asBool()) {
+                    continue;
+                }
+            }
+            currentMatched_ = true;
+            return combined;
+        }
+
+        if (!currentMatched_ && joinType_ == JoinType::kLeft) {
+            Tuple combined = padWithNulls(*currentOuter_);
+            currentOuter_.reset();
+            return combined;
+        }
+
+        currentOuter_.reset();
+    }
+}
+
+void IndexNestedLoopJoinOperator::close() {
+    outer_->close();
+    inner_->close();
+    initialized_ = false;
+    currentOuter_.reset();
+    probing_ = false;
+    currentMatched_ = false;
+}
+
+void IndexNestedLoopJoinOperator::reset() {
+    outer_->reset();
+    inner_->reset();
+    initialized_ = false;
+    currentOuter_.reset();
+    probing_ = false;
+    currentMatched_ = false;
+}
+
+Tuple IndexNestedLoopJoinOperator::combineTuples(const Tuple& outer, const Tuple& inner) const {
+    Tuple combined;
+    combined.values.reserve(outer.values.size() + inner.values.size());
+    combined.values.insert(combined.values.end(), outer.values.begin(), outer.values.end());
+    combined.values.insert(combined.values.end(), inner.values.begin(), inner.values.end());
+    combined.schema = outputSchema_;
+    return combined;
+}
+
+Tuple IndexNestedLoopJoinOperator::padWithNulls(const Tuple& outer) const {
+    Tuple combined;
+    combined.values = outer.values;
+    combined.values.insert(combined.values.end(), inner_->getSchema().columnCount(), "NULL");
+    combined.schema = outputSchema_;
+    return combined;
+}
+
 } // namespace dbms
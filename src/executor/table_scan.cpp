@@ -25,6 +25,8 @@ void TableScanOperator::init() {
     currentSlotCount_ = 0;
     exhausted_ = false;
     currentBlockRecords_.clear();
+    ring_ = db_.startBulkRead(blocks_.size());
+    readAhead_ = db_.startReadAhead(blocks_);
 
     initialized_ = true;
 }
@@ -42,6 +44,8 @@ std::optional<Tuple> TableScanOperator::next() {
     while (currentSlotIdx_ >= currentSlotCount_) {
         if (currentBlockIdx_ >= blocks_.size()) {
             exhausted_ = true;
+            readAhead_.reset();
+            ring_.reset();
             return std::nullopt;
         }
         fetchNextBlock();
@@ -64,7 +68,9 @@ std::optional<Tuple> TableScanOperator::next() {
 }
 
 void TableScanOperator::close() {
-    // Nothing to clean up (buffer pool manages blocks)
+    // Stop the reader and drop the ring; the buffer pool manages the blocks
+    readAhead_.reset();
+    ring_.reset();
     initialized_ = false;
 }
 
@@ -74,6 +80,8 @@ void TableScanOperator::reset() {
     currentSlotCount_ = 0;
     exhausted_ = false;
     currentBlockRecords_.clear();
+    readAhead_.reset();
+    ring_.reset();
     initialized_ = false;
 }
 
@@ -85,7 +93,13 @@ void TableScanOperator::fetchNextBlock() {
     }
 
     const BlockAddress& addr = blocks_[currentBlockIdx_];
-    auto fetchResult = db_.buffer().fetch(addr, false);  // Read-only
+    if (readAhead_) {
+        readAhead_->reached(currentBlockIdx_);
+    }
+    auto fetchResult = db_.fetchBulk(ring_.get(), addr);  // Read-only
+    if (readAhead_) {
+        readAhead_->fetched(fetchResult.wasHit);
+    }
     fetchResult.block.ensureInitialized(db_.blockSize());
 
     // Extract all records from the block
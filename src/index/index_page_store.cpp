@@ -0,0 +1,3 @@
+#include "index/index_page_store.h"
+
+// Implementation is header-only for simplicity.
@@ -3,6 +3,7 @@
 #include "executor/expression_parser.h"
 #include "executor/expression.h"
 #include <cctype>
+#include <cmath>
 #include <sstream>
 #include <iostream>
 #include <algorithm>
@@ -287,11 +288,13 @@ std::string PhysicalPlanNode::toString(int indent) const {
     switch (opType) {
         case PhysicalOpType::kTableScan: oss << "TABLE_SCAN"; break;
         case PhysicalOpType::kIndexScan: oss << "INDEX_SCAN"; break;
+        case PhysicalOpType::kBitmapScan: oss << "BITMAP_SCAN"; break;
         case PhysicalOpType::kFilter: oss << "FILTER"; break;
         case PhysicalOpType::kProjection: oss << "PROJECTION"; break;
         case PhysicalOpType::kDistinct: oss << "DISTINCT"; break;
         case PhysicalOpType::kNestedLoopJoin: oss << "NESTED_LOOP_JOIN"; break;
         case PhysicalOpType::kHashJoin: oss << "HASH_JOIN"; break;
+        case PhysicalOpType::kIndexNestedLoopJoin: oss << "INDEX_NESTED_LOOP_JOIN"; break;
         case PhysicalOpType::kMergeJoin: oss << "MERGE_JOIN"; break;
         case PhysicalOpType::kSort: oss << "SORT"; break;
         case PhysicalOpType::kAggregate: oss << "AGGREGATE"; break;
@@ -375,7 +378,8 @@ TokenType Lexer::getKeywordType(const std::string& word) const {
         {"LIMIT", TokenType::LIMIT}, {"OFFSET", TokenType::OFFSET},
         {"INSERT", TokenType::INSERT}, {"INTO", TokenType::INTO},
         {"VALUES", TokenType::VALUES}, {"UPDATE", TokenType::UPDATE},
-        {"SET", TokenType::SET}, {"DELETE", TokenType::DELETE}
+        {"SET", TokenType::SET}, {"DELETE", TokenType::DELETE},
+        {"BETWEEN", TokenType::BETWEEN}, {"LIKE", TokenType::LIKE}
     };
 
     std::string upper = word;
@@ -977,6 +981,30 @@ std::shared_ptr<ASTNode> Parser::parseComparisonExpression() {
         return cmp;
     }
 
+    if (match(TokenType::LIKE)) {
+        auto like = std::make_shared<ASTNode>(ASTNodeType::COMPARISON, "LIKE");
+        like->addChild(left);
+        like->addChild(parseAdditiveExpression());
+        return like;
+    }
+
+    // a BETWEEN x AND y is rewritten as (a >= x AND a <= y).
+    if (match(TokenType::BETWEEN)) {
+        auto low = parseAdditiveExpression();
+        consume(TokenType::AND, "Expected AND in BETWEEN");
+        auto high = parseAdditiveExpression();
+        auto lower = std::make_shared<ASTNode>(ASTNodeType::COMPARISON, ">=");
+        lower->addChild(left);
+        lower->addChild(low);
+        auto upper = std::make_shared<ASTNode>(ASTNodeType::COMPARISON, "<=");
+        upper->addChild(left);
+        upper->addChild(high);
+        auto andNode = std::make_shared<ASTNode>(ASTNodeType::AND_EXPR, "AND");
+        andNode->addChild(lower);
+        andNode->addChild(upper);
+        return andNode;
+    }
+
     return left;
 }
 
@@ -1448,6 +1476,118 @@ std::string LogicalPlanGenerator::extractCondition(std::shared_ptr<ASTNode> node
     return astToExpressionString(node);
 }
 
+namespace {
+
+// Alias or table name the columns of a base table source are qualified with.
+std::optional<std::string> sourceQualifier(const std::shared_ptr<RelAlgNode>& node) {
+    if (node->opType == RelAlgOpType::kScan) {
+        return node->tableName;
+    }
+    if (node->opType == RelAlgOpType::kRename && node->children.size() == 1 &&
+        node->children[0]->opType == RelAlgOpType::kScan) {
+        return node->alias;
+    }
+    return std::nullopt;
+}
+
+// Position of the parenthesis closing the one at `open`, skipping quoted text.
+std::size_t closingParen(const std::string& text, std::size_t open) {
+    int depth = 0;
+    bool quoted = false;
+    for (std::size_t i = open; i < text.size(); ++i) {
+        if (text[i] == '\'') {
+            quoted = !quoted;
+        } else if (!quoted && text[i] == '(') {
+            ++depth;
+        } else if (!quoted && text[i] == ')' && --depth == 0) {
+            return i;
+        }
+    }
+    return std::string::npos;
+}
+
+// Splits a condition string into its top-level AND operands.
+std::vector<std::string> splitConjunctTexts(std::string text) {
+    while (text.size() >= 2 && text.front() == '(' && closingParen(text, 0) == text.size() - 1) {
+        text = text.substr(1, text.size() - 2);
+    }
+    int depth = 0;
+    bool quoted = false;
+    for (std::size_t i = 0; i < text.size(); ++i) {
+        const char c = text[i];
+        if (c == '\'') {
+            quoted = !quoted;
+        } else if (!quoted && c == '(') {
+            ++depth;
+        } else if (!quoted && c == ')') {
+            --depth;
+        } else if (!quoted && depth == 0 && text.compare(i, 5, " AND ") == 0) {
+            auto conjuncts = splitConjunctTexts(text.substr(0, i));
+            auto rest = splitConjunctTexts(text.substr(i + 5));
+            conjuncts.insert(conjuncts.end(), rest.begin(), rest.end());
+            return conjuncts;
+        }
+    }
+    return {text};
+}
+
+std::string joinConjunctTexts(const std::vector<std::string>& conjuncts) {
+    if (conjuncts.size() == 1) {
+        return conjuncts.front();
+    }
+    std::string joined;
+    for (const auto& conjunct : conjuncts) {
+        joined += (joined.empty() ? "(" : " AND (") + conjunct + ")";
+    }
+    return joined;
+}
+
+bool collectColumnRefs(const Expression* expr, std::vector<std::string>& out) {
+    if (!expr) {
+        return true;
+    }
+    if (auto col = dynamic_cast<const ColumnRefExpr*>(expr)) {
+        out.push_back(col->columnName());
+        return true;
+    }
+    if (dynamic_cast<const LiteralExpr*>(expr)) {
+        return true;
+    }
+    if (auto cmp = dynamic_cast<const ComparisonExpr*>(expr)) {
+        return collectColumnRefs(cmp->left(), out) && collectColumnRefs(cmp->right(), out);
+    }
+    if (auto like = dynamic_cast<const LikeExpr*>(expr)) {
+        return collectColumnRefs(like->value(), out) && collectColumnRefs(like->pattern(), out);
+    }
+    if (auto logical = dynamic_cast<const LogicalExpr*>(expr)) {
+        return collectColumnRefs(logical->left(), out) && collectColumnRefs(logical->right(), out);
+    }
+    if (auto binary = dynamic_cast<const BinaryOpExpr*>(expr)) {
+        return collectColumnRefs(binary->left(), out) && collectColumnRefs(binary->right(), out);
+    }
+    return false;
+}
+
+// True when every column `condition` reads is qualified with `qualifier`.
+bool readsOnlySource(const std::string& condition, const std::string& qualifier) {
+    try {
+        ExpressionParser parser;
+        auto expr = parser.parse(condition);
+        std::vector<std::string> columns;
+        if (!collectColumnRefs(expr.get(), columns) || columns.empty()) {
+            return false;
+        }
+        const std::string prefix = qualifier + ".";
+        return std::all_of(columns.begin(), columns.end(), [&](const std::string& column) {
+            return column.compare(0, prefix.size(), prefix) == 0;
+        });
+    } catch (...) {
+        return false;
+    }
+}
+
+} // namespace
+
 // ============== LogicalOptimizer 实现 ==============
 std::shared_ptr<RelAlgNode> LogicalOptimizer::optimize(std::shared_ptr<RelAlgNode> plan) {
     if (!plan) return plan;
@@ -1493,6 +1633,42 @@ std::shared_ptr<RelAlgNode> LogicalOptimizer::pushDownSelection(
         return join;
     }
 
+    // Conjuncts that only read the left input of an inner or left join are
+    // applied below it, where an index on the filtered column can narrow
+    // the outer side before any row is joined.
+    if (node->opType == RelAlgOpType::kSelect &&
+        node->children.size() == 1 &&
+        node->children[0]->opType == RelAlgOpType::kJoin &&
+        node->children[0]->joinType != JoinType::kRight &&
+        node->children[0]->children.size() == 2) {
+
+        auto join = std::make_shared<RelAlgNode>(*node->children[0]);
+        auto qualifier = sourceQualifier(join->children[0]);
+        std::vector<std::string> pushed;
+        std::vector<std::string> kept;
+        if (qualifier) {
+            for (const auto& conjunct : splitConjunctTexts(node->condition)) {
+                (readsOnlySource(conjunct, *qualifier) ? pushed : kept).push_back(conjunct);
+            }
+        }
+        if (!pushed.empty()) {
+            auto filter = std::make_shared<RelAlgNode>(RelAlgOpType::kSelect,
+                "Apply filter: " + joinConjunctTexts(pushed));
+            filter->condition = joinConjunctTexts(pushed);
+            filter->addChild(join->children[0]);
+            join->children[0] = filter;
+            if (kept.empty()) {
+                node = join;
+            } else {
+                auto select = std::make_shared<RelAlgNode>(*node);
+                select->condition = joinConjunctTexts(kept);
+                select->operationDesc = "Apply filter: " + select->condition;
+                select->children[0] = join;
+                node = select;
+            }
+        }
+    }
+
     // Recursively optimize children
     for (auto& child : node->children) {
         child = pushDownSelection(child);
@@ -1565,24 +1741,164 @@ std::shared_ptr<PhysicalPlanNode> PhysicalPlanGenerator::convertNode(
 
         case RelAlgOpType::kSelect:
             // Attempt to turn simple equality predicate on a single table into an index scan
-            if (!node->children.empty() && node->children[0]->opType == RelAlgOpType::kScan) {
+            if (!node->children.empty() && sourceQualifier(node->children[0])) {
+                // An aliased table keeps its index paths; the alias sits
+                // between the index scan and any residual filter.
+                auto source = node->children[0];
+                std::string alias;
+                if (source->opType == RelAlgOpType::kRename) {
+                    alias = source->alias;
+                    source = source->children[0];
+                }
+                auto withAlias = [&](std::shared_ptr<PhysicalPlanNode> scan) {
+                    if (alias.empty()) {
+                        return scan;
+                    }
+                    auto renamed = std::make_shared<PhysicalPlanNode>(PhysicalOpType::kAlias,
+                        "Apply alias");
+                    renamed->parameters["alias"] = alias;
+                    renamed->planFlow = "pipeline";
+                    renamed->addChild(scan);
+                    renamed->estimatedCost = estimateCost(renamed);
+                    return renamed;
+                };
                 auto equality = extractColumnLiteralEquality(node->condition);
                 if (equality) {
-                    const std::string table = node->children[0]->tableName;
+                    const std::string table = source->tableName;
                     const std::string column = stripTablePrefix(equality->first);
-                    auto indexName = db_.findIndexForColumn(table, column);
+                    auto indexName = db_.findEqualityIndexForColumn(table, column);
                     if (indexName) {
                         physNode = std::make_shared<PhysicalPlanNode>(PhysicalOpType::kIndexScan,
                             "Index scan on " + table + " using " + *indexName);
-                        physNode->algorithm = "B+ tree equality lookup";
+                        physNode->algorithm = db_.getIndexDefinition(*indexName).hashed()
+                                                  ? "Hash index equality lookup"
+                                                  : "B+ tree equality lookup";
                         physNode->parameters["table"] = table;
                         physNode->parameters["index"] = *indexName;
                         physNode->parameters["key"] = equality->second;
                         physNode->planFlow = "pipeline";
                         physNode->estimatedCost = estimateCost(physNode);
+                        physNode = withAlias(physNode);
+                        // A string literal longer than the key is cut to the
+                        // key length, so the scan can match other values
+                        // sharing that prefix; recheck the condition then.
+                        const auto leading = db_.getIndexDefinition(*indexName).keyColumns().front();
+                        if (leading.type == ColumnType::String &&
+                            equality->second.size() > leading.keyLength) {
+                            auto scan = physNode;
+                            physNode = std::make_shared<PhysicalPlanNode>(PhysicalOpType::kFilter,
+                                "Filter: " + node->condition);
+                            physNode->algorithm = "Predicate evaluation";
+                            physNode->parameters["condition"] = node->condition;
+                            physNode->planFlow = "pipeline";
+                            physNode->addChild(scan);
+                            physNode->estimatedCost = estimateCost(physNode);
+                        }
                         return physNode;
                     }
                 }
+
+                // Range and prefix predicates walk the index leaf chain; the
+                // full condition stays on top as a residual filter.
+                const std::string table = source->tableName;
+                // Bitmap scans fetch only the blocks holding matching rows.
+                // When every conjunct is answered by bitmaps they beat the
+                // range paths; otherwise they come after them. The filter
+                // stays on top since string keys may be cut to their length.
+                auto bitmap = extractBitmapCondition(table, node->condition);
+                auto bitmapPlan = [&]() {
+                    auto scan = std::make_shared<PhysicalPlanNode>(PhysicalOpType::kBitmapScan,
+                        "Bitmap scan on " + table);
+                    scan->algorithm = "Bitmap AND/OR, block-skipping fetch";
+                    scan->parameters["table"] = table;
+                    scan->parameters["conjuncts"] = std::to_string(bitmap->conjuncts.size());
+                    for (std::size_t i = 0; i < bitmap->conjuncts.size(); ++i) {
+                        const auto& terms = bitmap->conjuncts[i];
+                        const std::string prefix = "conjunct_" + std::to_string(i);
+                        scan->parameters[prefix + "_terms"] = std::to_string(terms.size());
+                        for (std::size_t j = 0; j < terms.size(); ++j) {
+                            scan->parameters[prefix + "_index_" + std::to_string(j)] = terms[j].first;
+                            scan->parameters[prefix + "_value_" + std::to_string(j)] = terms[j].second;
+                        }
+                    }
+                    scan->planFlow = "pipeline";
+                    scan->estimatedCost = estimateCost(scan);
+
+                    auto filter = std::make_shared<PhysicalPlanNode>(PhysicalOpType::kFilter,
+                        "Filter: " + node->condition);
+                    filter->algorithm = "Predicate evaluation";
+                    filter->parameters["condition"] = node->condition;
+                    filter->planFlow = "pipeline";
+                    filter->addChild(withAlias(scan));
+                    filter->estimatedCost = estimateCost(filter);
+                    return filter;
+                };
+                if (bitmap && bitmap->complete) {
+                    return bitmapPlan();
+                }
+                auto composite = extractCompositeRange(table, node->condition);
+                if (composite) {
+                    const auto& bounds = composite->next;
+                    auto scan = std::make_shared<PhysicalPlanNode>(PhysicalOpType::kIndexScan,
+                        "Index range scan on " + table + " using " + composite->index);
+                    scan->algorithm = "B+ tree composite key prefix scan";
+                    scan->parameters["table"] = table;
+                    scan->parameters["index"] = composite->index;
+                    scan->parameters["prefix_size"] = std::to_string(composite->prefix.size());
+                    for (std::size_t i = 0; i < composite->prefix.size(); ++i) {
+                        scan->parameters["prefix_" + std::to_string(i)] = composite->prefix[i];
+                    }
+                    if (bounds.lower) {
+                        scan->parameters["lower"] = *bounds.lower;
+                        scan->parameters["lower_inclusive"] = bounds.lowerInclusive ? "true" : "false";
+                    }
+                    if (bounds.upper) {
+                        scan->parameters["upper"] = *bounds.upper;
+                        scan->parameters["upper_inclusive"] = bounds.upperInclusive ? "true" : "false";
+                    }
+                    scan->planFlow = "pipeline";
+                    scan->estimatedCost = estimateCost(scan);
+
+                    physNode = std::make_shared<PhysicalPlanNode>(PhysicalOpType::kFilter,
+                        "Filter: " + node->condition);
+                    physNode->algorithm = "Predicate evaluation";
+                    physNode->parameters["condition"] = node->condition;
+                    physNode->planFlow = "pipeline";
+                    physNode->addChild(withAlias(scan));
+                    physNode->estimatedCost = estimateCost(physNode);
+                    return physNode;
+                }
+                auto range = extractIndexedRange(table, node->condition);
+                if (range) {
+                    const auto& bounds = range->first;
+                    auto scan = std::make_shared<PhysicalPlanNode>(PhysicalOpType::kIndexScan,
+                        "Index range scan on " + table + " using " + range->second);
+                    scan->algorithm = "B+ tree leaf chain scan";
+                    scan->parameters["table"] = table;
+                    scan->parameters["index"] = range->second;
+                    if (bounds.lower) {
+                        scan->parameters["lower"] = *bounds.lower;
+                        scan->parameters["lower_inclusive"] = bounds.lowerInclusive ? "true" : "false";
+                    }
+                    if (bounds.upper) {
+                        scan->parameters["upper"] = *bounds.upper;
+                        scan->parameters["upper_inclusive"] = bounds.upperInclusive ? "true" : "false";
+                    }
+                    scan->planFlow = "pipeline";
+                    scan->estimatedCost = estimateCost(scan);
+
+                    physNode = std::make_shared<PhysicalPlanNode>(PhysicalOpType::kFilter,
+                        "Filter: " + node->condition);
+                    physNode->algorithm = "Predicate evaluation";
+                    physNode->parameters["condition"] = node->condition;
+                    physNode->planFlow = "pipeline";
+                    physNode->addChild(withAlias(scan));
+                    physNode->estimatedCost = estimateCost(physNode);
+                    return physNode;
+                }
+                if (bitmap) {
+                    return bitmapPlan();
+                }
             }
 
             physNode = std::make_shared<PhysicalPlanNode>(PhysicalOpType::kFilter,
@@ -1609,6 +1925,13 @@ std::shared_ptr<PhysicalPlanNode> PhysicalPlanGenerator::convertNode(
 
         case RelAlgOpType::kJoin:
             physNode = chooseJoinMethod(node);
+            if (physNode->opType == PhysicalOpType::kIndexNestedLoopJoin) {
+                // The inner side is probed through its index, which
+                // chooseIndexJoin already planned as the second child.
+                physNode->children.insert(physNode->children.begin(), convertNode(node->children[0]));
+                physNode->estimatedCost = estimateCost(physNode);
+                return physNode;
+            }
             break;
 
         case RelAlgOpType::kCrossProduct:
@@ -1685,12 +2008,58 @@ std::shared_ptr<PhysicalPlanNode> PhysicalPlanGenerator::convertNode(
         }
     }
 
+    if (physNode->opType == PhysicalOpType::kProjection) {
+        chooseIndexOnlyScan(physNode);
+    }
+
     // Estimate cost
     physNode->estimatedCost = estimateCost(physNode);
 
     return physNode;
 }
 
+// A projection over an index scan, possibly through its residual filter,
+// that reads only columns a covering index stores is answered from the index
+// leaves without fetching any table block.
+void PhysicalPlanGenerator::chooseIndexOnlyScan(std::shared_ptr<PhysicalPlanNode> projection) {
+    if (projection->children.size() != 1) {
+        return;
+    }
+    auto scan = projection->children[0];
+    std::vector<std::string> columns = projection->outputColumns;
+    if (scan->opType == PhysicalOpType::kFilter && scan->children.size() == 1) {
+        try {
+            ExpressionParser parser;
+            auto condition = parser.parse(scan->parameters["condition"]);
+            if (!collectColumnRefs(condition.get(), columns)) {
+                return;
+            }
+        } catch (...) {
+            return;
+        }
+        scan = scan->children[0];
+    }
+    if (scan->opType != PhysicalOpType::kIndexScan) {
+        return;
+    }
+    const std::string& table = scan->parameters["table"];
+    const auto& definition = db_.getIndexDefinition(scan->parameters["index"]);
+    if (!definition.covering()) {
+        return;
+    }
+    const bool covered = std::all_of(columns.begin(), columns.end(), [&](const std::string& column) {
+        const auto dot = column.find('.');
+        if (dot != std::string::npos && column.substr(0, dot) != table) {
+            return false;
+        }
+        return definition.covers(stripTablePrefix(column));
+    });
+    if (covered) {
+        scan->parameters["index_only"] = "true";
+        scan->algorithm += " (index only)";
+    }
+}
+
 std::shared_ptr<PhysicalPlanNode> PhysicalPlanGenerator::chooseScanMethod(
     std::shared_ptr<RelAlgNode> node) {
 
@@ -1727,6 +2096,10 @@ std::shared_ptr<PhysicalPlanNode> PhysicalPlanGenerator::chooseJoinMethod(
         joinTypeStr = "RIGHT";
     }
 
+    if (auto indexJoin = chooseIndexJoin(node)) {
+        return indexJoin;
+    }
+
     if (node->joinType != JoinType::kInner) {
         auto physNode = std::make_shared<PhysicalPlanNode>(PhysicalOpType::kNestedLoopJoin,
             joinTypeStr + " join: " + node->condition);
@@ -1763,6 +2136,139 @@ std::shared_ptr<PhysicalPlanNode> PhysicalPlanGenerator::chooseJoinMethod(
     return physNode;
 }
 
+// An index nested loop join probes the index on the inner join column once
+// per outer row. Each probe reads about one leaf and the blocks of its
+// matches, while a hash join reads every inner block, so the index join is
+// chosen when the outer side is expected to yield fewer rows than the inner
+// table has blocks. The result holds only the inner probe as its child.
+std::shared_ptr<PhysicalPlanNode> PhysicalPlanGenerator::chooseIndexJoin(
+    std::shared_ptr<RelAlgNode> node) {
+
+    if (node->joinType == JoinType::kRight || node->children.size() != 2) {
+        return nullptr;
+    }
+    auto inner = node->children[1];
+    auto qualifier = sourceQualifier(inner);
+    auto eqCols = extractJoinColumns(node->condition);
+    if (!qualifier || !eqCols) {
+        return nullptr;
+    }
+    const std::string prefix = *qualifier + ".";
+    auto onInner = [&](const std::string& column) {
+        return column.compare(0, prefix.size(), prefix) == 0;
+    };
+    std::string outerKey = eqCols->first;
+    std::string innerKey = eqCols->second;
+    if (onInner(outerKey)) {
+        std::swap(outerKey, innerKey);
+    }
+    if (!onInner(innerKey) || onInner(outerKey) || outerKey.find('.') == std::string::npos) {
+        return nullptr;
+    }
+
+    const std::string innerTable =
+        inner->opType == RelAlgOpType::kRename ? inner->children[0]->tableName : inner->tableName;
+    auto indexName = db_.findEqualityIndexForColumn(innerTable, stripTablePrefix(innerKey));
+    if (!indexName) {
+        return nullptr;
+    }
+    auto outerRows = estimateRows(node->children[0]);
+    std::size_t innerBlocks = 0;
+    try {
+        innerBlocks = db_.getTable(innerTable).blockCount();
+    } catch (...) {
+        return nullptr;
+    }
+    if (!outerRows || *outerRows >= innerBlocks) {
+        return nullptr;
+    }
+
+    const std::string joinTypeStr = node->joinType == JoinType::kLeft ? "LEFT" : "INNER";
+    auto physNode = std::make_shared<PhysicalPlanNode>(PhysicalOpType::kIndexNestedLoopJoin,
+        "Index nested loop join: " + node->condition);
+    physNode->algorithm = "Index nested loop join";
+    physNode->parameters["condition"] = node->condition;
+    physNode->parameters["outer_key"] = outerKey;
+    physNode->parameters["join_type"] = joinTypeStr;
+    physNode->joinType = node->joinType;
+    physNode->planFlow = "pipeline";
+
+    auto probe = std::make_shared<PhysicalPlanNode>(PhysicalOpType::kIndexScan,
+        "Index probe on " + innerTable + " using " + *indexName);
+    probe->algorithm = db_.getIndexDefinition(*indexName).hashed()
+                           ? "Hash index equality lookup per outer row"
+                           : "B+ tree equality lookup per outer row";
+    probe->parameters["table"] = innerTable;
+    probe->parameters["index"] = *indexName;
+    probe->parameters["probe_key"] = outerKey;
+    probe->planFlow = "pipeline";
+    probe->estimatedCost = estimateCost(probe);
+    if (inner->opType == RelAlgOpType::kRename) {
+        auto renamed = std::make_shared<PhysicalPlanNode>(PhysicalOpType::kAlias, "Apply alias");
+        renamed->parameters["alias"] = inner->alias;
+        renamed->planFlow = "pipeline";
+        renamed->addChild(probe);
+        renamed->estimatedCost = estimateCost(renamed);
+        probe = renamed;
+    }
+    physNode->addChild(probe);
+    return physNode;
+}
+
+// Rough row count of a join input: a table's record count, one row for an
+// equality on a unique single-column index and a tenth of the input for any
+// other filter. Other inputs are not estimated.
+std::optional<std::size_t> PhysicalPlanGenerator::estimateRows(std::shared_ptr<RelAlgNode> node) {
+    switch (node->opType) {
+        case RelAlgOpType::kScan:
+            try {
+                return db_.getTable(node->tableName).totalRecords();
+            } catch (...) {
+                return std::nullopt;
+            }
+        case RelAlgOpType::kRename:
+            if (node->children.size() != 1) {
+                return std::nullopt;
+            }
+            return estimateRows(node->children[0]);
+        case RelAlgOpType::kSelect: {
+            if (node->children.size() != 1) {
+                return std::nullopt;
+            }
+            auto input = estimateRows(node->children[0]);
+            if (!input) {
+                return std::nullopt;
+            }
+            auto source = node->children[0];
+            if (sourceQualifier(source)) {
+                const std::string table = source->opType == RelAlgOpType::kRename
+                                              ? source->children[0]->tableName
+                                              : source->tableName;
+                try {
+                    for (const auto& range : collectColumnRanges(table, node->condition)) {
+                        const bool equality = range.lower && range.upper && range.lowerInclusive &&
+                                              range.upperInclusive && *range.lower == *range.upper;
+                        auto indexName = equality ? db_.findIndexForColumn(table, range.column)
+                                                  : std::nullopt;
+                        if (!indexName) {
+                            continue;
+                        }
+                        const auto& definition = db_.getIndexDefinition(*indexName);
+                        if (definition.unique && !definition.composite()) {
+                            return 1;
+                        }
+                    }
+                } catch (...) {
+                    // Unparseable conditions get the default estimate
+                }
+            }
+            return std::max<std::size_t>(1, *input / 10);
+        }
+        default:
+            return std::nullopt;
+    }
+}
+
 int PhysicalPlanGenerator::estimateCost(std::shared_ptr<PhysicalPlanNode> node) {
     if (!node) return 0;
 
@@ -1779,6 +2285,7 @@ int PhysicalPlanGenerator::estimateCost(std::shared_ptr<PhysicalPlanNode> node)
             break;
 
         case PhysicalOpType::kIndexScan:
+        case PhysicalOpType::kBitmapScan:
             cost = 10; // Index scans are cheaper
             break;
 
@@ -1797,6 +2304,9 @@ int PhysicalPlanGenerator::estimateCost(std::shared_ptr<PhysicalPlanNode> node)
         case PhysicalOpType::kHashJoin:
             cost = 200; // Hash joins are cheaper than nested loops
             break;
+        case PhysicalOpType::kIndexNestedLoopJoin:
+            cost = 100; // Only picked for a small outer side
+            break;
         case PhysicalOpType::kSort:
             cost = 150;
             break;
@@ -1852,6 +2362,362 @@ PhysicalPlanGenerator::extractColumnLiteralEquality(const std::string& condition
     return std::nullopt;
 }
 
+namespace {
+
+void collectConjuncts(const Expression* expr, std::vector<const Expression*>& out) {
+    auto logical = dynamic_cast<const LogicalExpr*>(expr);
+    if (logical && logical->op() == LogicalExpr::Op::AND) {
+        collectConjuncts(logical->left(), out);
+        collectConjuncts(logical->right(), out);
+        return;
+    }
+    out.push_back(expr);
+}
+
+// Bounds are kept as column values but ordered by their encoded index keys,
+// which is numeric order for INT/DOUBLE columns.
+using KeyEncoder = std::function<std::string(const std::string&)>;
+
+void tightenLower(ColumnKeyRange& range, const std::string& value, bool inclusive,
+                  const KeyEncoder& encode) {
+    if (range.lower) {
+        const auto current = encode(*range.lower);
+        const auto candidate = encode(value);
+        if (candidate < current) {
+            return;
+        }
+        if (candidate == current) {
+            range.lowerInclusive = range.lowerInclusive && inclusive;
+            return;
+        }
+    }
+    range.lower = value;
+    range.lowerInclusive = inclusive;
+}
+
+void tightenUpper(ColumnKeyRange& range, const std::string& value, bool inclusive,
+                  const KeyEncoder& encode) {
+    if (range.upper) {
+        const auto current = encode(*range.upper);
+        const auto candidate = encode(value);
+        if (candidate > current) {
+            return;
+        }
+        if (candidate == current) {
+            range.upperInclusive = range.upperInclusive && inclusive;
+            return;
+        }
+    }
+    range.upper = value;
+    range.upperInclusive = inclusive;
+}
+
+ComparisonExpr::Op mirrorComparison(ComparisonExpr::Op op) {
+    switch (op) {
+        case ComparisonExpr::Op::LT: return ComparisonExpr::Op::GT;
+        case ComparisonExpr::Op::LE: return ComparisonExpr::Op::GE;
+        case ComparisonExpr::Op::GT: return ComparisonExpr::Op::LT;
+        case ComparisonExpr::Op::GE: return ComparisonExpr::Op::LE;
+        default: return op;
+    }
+}
+
+} // namespace
+
+// Key interval of every column the conjuncts of `condition` bound, in the
+// order the columns first appear.
+std::vector<ColumnKeyRange>
+PhysicalPlanGenerator::collectColumnRanges(const std::string& table, const std::string& condition) {
+    ExpressionParser parser;
+    auto expr = parser.parse(condition);
+    std::vector<const Expression*> conjuncts;
+    collectConjuncts(expr.get(), conjuncts);
+
+    const auto& columns = db_.getTable(table).schema().columns();
+    auto columnType = [&](const std::string& name) -> std::optional<ColumnType> {
+        for (const auto& column : columns) {
+            if (column.name == name) {
+                return column.type;
+            }
+        }
+        return std::nullopt;
+    };
+
+    struct KeyedRange {
+        ColumnKeyRange range;
+        KeyEncoder encode;
+    };
+    std::vector<KeyedRange> ranges;
+    auto rangeFor = [&](const std::string& column) -> KeyedRange* {
+        for (auto& entry : ranges) {
+            if (entry.range.column == column) {
+                return &entry;
+            }
+        }
+        auto definition = std::find_if(columns.begin(), columns.end(),
+                                       [&](const ColumnDefinition& candidate) {
+                                           return candidate.name == column;
+                                       });
+        if (definition == columns.end()) {
+            return nullptr;
+        }
+        KeyedRange entry;
+        entry.range.column = column;
+        entry.encode = [type = definition->type,
+                        length = indexKeyLength(definition->type, definition->length)](const std::string& value) {
+            return encodeIndexKey(value, type, length);
+        };
+        ranges.push_back(std::move(entry));
+        return &ranges.back();
+    };
+
+    for (const auto* conjunct : conjuncts) {
+        if (auto like = dynamic_cast<const LikeExpr*>(conjunct)) {
+            auto col = dynamic_cast<const ColumnRefExpr*>(like->value());
+            auto lit = dynamic_cast<const LiteralExpr*>(like->pattern());
+            if (!col || !lit) {
+                continue;
+            }
+            // Only string keys keep the text order a prefix relies on.
+            const std::string column = stripTablePrefix(col->columnName());
+            if (columnType(column) != ColumnType::String) {
+                continue;
+            }
+            const auto prefix = LikeExpr::literalPrefix(lit->value().asString());
+            auto* entry = prefix.empty() ? nullptr : rangeFor(column);
+            if (!entry) {
+                continue;
+            }
+            tightenLower(entry->range, prefix, true, entry->encode);
+            if (auto successor = indexKeySuccessor(prefix)) {
+                tightenUpper(entry->range, *successor, false, entry->encode);
+            }
+            continue;
+        }
+
+        auto cmp = dynamic_cast<const ComparisonExpr*>(conjunct);
+        if (!cmp || cmp->op() == ComparisonExpr::Op::NE) {
+            continue;
+        }
+        auto op = cmp->op();
+        auto col = dynamic_cast<const ColumnRefExpr*>(cmp->left());
+        auto lit = dynamic_cast<const LiteralExpr*>(cmp->right());
+        if (!col || !lit) {
+            col = dynamic_cast<const ColumnRefExpr*>(cmp->right());
+            lit = dynamic_cast<const LiteralExpr*>(cmp->left());
+            op = mirrorComparison(op);
+        }
+        if (!col || !lit || lit->value().isNull()) {
+            continue;
+        }
+        // Predicates compare numerically only when both sides are
+        // numbers, which is exactly when the numeric key order applies.
+        const std::string column = stripTablePrefix(col->columnName());
+        const auto type = columnType(column);
+        const auto literalType = lit->value().type;
+        const bool numericLiteral = literalType == ExprValue::Type::INTEGER ||
+                                    literalType == ExprValue::Type::DOUBLE;
+        if (!type || (*type != ColumnType::String && !numericLiteral)) {
+            continue;
+        }
+        auto* entry = rangeFor(column);
+        if (!entry) {
+            continue;
+        }
+        std::string value = lit->value().asString();
+        std::optional<std::string> lowerValue;
+        std::optional<std::string> upperValue;
+        if (*type == ColumnType::Integer && literalType == ExprValue::Type::DOUBLE) {
+            // Integer keys cannot hold a fraction; round each bound
+            // inward to the nearest integer it still admits.
+            const double number = lit->value().asDouble();
+            lowerValue = std::to_string(static_cast<long long>(std::ceil(number)));
+            upperValue = std::to_string(static_cast<long long>(std::floor(number)));
+            if (std::floor(number) != number) {
+                if (op == ComparisonExpr::Op::EQ) {
+                    continue;
+                }
+                op = (op == ComparisonExpr::Op::GT || op == ComparisonExpr::Op::GE)
+                         ? ComparisonExpr::Op::GE
+                         : ComparisonExpr::Op::LE;
+            }
+        }
+        const std::string lowerKey = lowerValue.value_or(value);
+        const std::string upperKey = upperValue.value_or(value);
+        switch (op) {
+            case ComparisonExpr::Op::EQ:
+                tightenLower(entry->range, lowerKey, true, entry->encode);
+                tightenUpper(entry->range, upperKey, true, entry->encode);
+                break;
+            case ComparisonExpr::Op::LT:
+                tightenUpper(entry->range, upperKey, false, entry->encode);
+                break;
+            case ComparisonExpr::Op::LE:
+                tightenUpper(entry->range, upperKey, true, entry->encode);
+                break;
+            case ComparisonExpr::Op::GT:
+                tightenLower(entry->range, lowerKey, false, entry->encode);
+                break;
+            case ComparisonExpr::Op::GE:
+                tightenLower(entry->range, lowerKey, true, entry->encode);
+                break;
+            default:
+                break;
+        }
+    }
+
+    std::vector<ColumnKeyRange> result;
+    for (auto& entry : ranges) {
+        result.push_back(std::move(entry.range));
+    }
+    return result;
+}
+
+std::optional<std::pair<ColumnKeyRange, std::string>>
+PhysicalPlanGenerator::extractIndexedRange(const std::string& table, const std::string& condition) {
+    if (condition.empty()) {
+        return std::nullopt;
+    }
+    try {
+        for (const auto& range : collectColumnRanges(table, condition)) {
+            if (!range.lower && !range.upper) {
+                continue;
+            }
+            if (auto indexName = db_.findIndexForColumn(table, range.column)) {
+                return std::make_pair(range, *indexName);
+            }
+        }
+    } catch (...) {
+        // Unparseable conditions fall back to a filtered table scan
+    }
+    return std::nullopt;
+}
+
+// Picks the composite index that matches the most leading columns: equality
+// conjuncts on a run of leading key columns form the prefix, and the bounds
+// on the column after it narrow the scan further. An index only wins when it
+// uses more than its leading column alone, which the single-column paths
+// already cover.
+std::optional<CompositeKeyRange>
+PhysicalPlanGenerator::extractCompositeRange(const std::string& table, const std::string& condition) {
+    if (condition.empty()) {
+        return std::nullopt;
+    }
+    try {
+        const auto indexNames = db_.indexesOnTable(table);
+        if (std::none_of(indexNames.begin(), indexNames.end(), [&](const std::string& name) {
+                return db_.getIndexDefinition(name).composite();
+            })) {
+            return std::nullopt;
+        }
+        const auto ranges = collectColumnRanges(table, condition);
+        std::optional<CompositeKeyRange> best;
+        std::size_t bestScore = 2;
+        for (const auto& indexName : indexNames) {
+            const auto& definition = db_.getIndexDefinition(indexName);
+            if (!definition.composite()) {
+                continue;
+            }
+            CompositeKeyRange candidate;
+            candidate.index = indexName;
+            for (const auto& column : definition.compositeColumns) {
+                auto range = std::find_if(ranges.begin(), ranges.end(),
+                                          [&](const ColumnKeyRange& entry) {
+                                              return entry.column == column.name;
+                                          });
+                if (range == ranges.end()) {
+                    break;
+                }
+                const bool equality = range->lower && range->upper &&
+                                      range->lowerInclusive && range->upperInclusive &&
+                                      encodeIndexKey(*range->lower, column.type, column.keyLength) ==
+                                          encodeIndexKey(*range->upper, column.type, column.keyLength);
+                if (!equality) {
+                    candidate.next = *range;
+                    break;
+                }
+                candidate.prefix.push_back(*range->lower);
+            }
+            const bool bounded = candidate.next.lower || candidate.next.upper;
+            const std::size_t score = 2 * candidate.prefix.size() + (bounded ? 1 : 0);
+            if (score > bestScore) {
+                bestScore = score;
+                best = std::move(candidate);
+            }
+        }
+        return best;
+    } catch (...) {
+        // Unparseable conditions fall back to a filtered table scan
+    }
+    return std::nullopt;
+}
+
+// Splits the selection into conjuncts and keeps those that are an OR of
+// `column = literal` terms on bitmap-indexed columns. Other conjuncts are
+// left to the residual filter.
+std::optional<BitmapCondition>
+PhysicalPlanGenerator::extractBitmapCondition(const std::string& table, const std::string& condition) {
+    if (condition.empty()) {
+        return std::nullopt;
+    }
+    try {
+        const auto indexNames = db_.indexesOnTable(table);
+        if (std::none_of(indexNames.begin(), indexNames.end(), [&](const std::string& name) {
+                return db_.getIndexDefinition(name).bitmapped();
+            })) {
+            return std::nullopt;
+        }
+        ExpressionParser parser;
+        auto expr = parser.parse(condition);
+        std::vector<const Expression*> conjuncts;
+        collectConjuncts(expr.get(), conjuncts);
+
+        std::function<bool(const Expression*, std::vector<std::pair<std::string, std::string>>&)> collectTerms =
+            [&](const Expression* node, std::vector<std::pair<std::string, std::string>>& terms) {
+                if (auto logical = dynamic_cast<const LogicalExpr*>(node)) {
+                    return logical->op() == LogicalExpr::Op::OR &&
+                           collectTerms(logical->left(), terms) &&
+                           collectTerms(logical->right(), terms);
+                }
+                auto cmp = dynamic_cast<const ComparisonExpr*>(node);
+                if (!cmp || cmp->op() != ComparisonExpr::Op::EQ) {
+                    return false;
+                }
+                auto col = dynamic_cast<const ColumnRefExpr*>(cmp->left());
+                auto lit = dynamic_cast<const LiteralExpr*>(cmp->right());
+                if (!col || !lit) {
+                    col = dynamic_cast<const ColumnRefExpr*>(cmp->right());
+                    lit = dynamic_cast<const LiteralExpr*>(cmp->left());
+                }
+                if (!col || !lit || lit->value().isNull()) {
+                    return false;
+                }
+                auto indexName = db_.findBitmapIndexForColumn(table, stripTablePrefix(col->columnName()));
+                if (!indexName) {
+                    return false;
+                }
+                terms.emplace_back(*indexName, lit->value().asString());
+                return true;
+            };
+
+        BitmapCondition result;
+        for (const auto* conjunct : conjuncts) {
+            std::vector<std::pair<std::string, std::string>> terms;
+            if (collectTerms(conjunct, terms)) {
+                result.conjuncts.push_back(std::move(terms));
+            }
+        }
+        if (result.conjuncts.empty()) {
+            return std::nullopt;
+        }
+        result.complete = result.conjuncts.size() == conjuncts.size();
+        return result;
+    } catch (...) {
+        // Unparseable conditions fall back to a filtered table scan
+    }
+    return std::nullopt;
+}
+
 std::optional<std::pair<std::string, std::string>>
 PhysicalPlanGenerator::extractJoinColumns(const std::string& condition) {
     if (condition.empty()) {
@@ -1914,16 +2780,10 @@ std::size_t executeUpdateStatement(DatabaseSystem& db, std::shared_ptr<ASTNode>
     const Table& table = db.getTable(tableName);
     auto schema = buildSchemaFromTable(table);
 
-    // Build predicate from WHERE (optional)
-    std::unique_ptr<Expression> predicateExpr;
+    std::string condition;
     if (whereClause && !whereClause->children.empty()) {
-        std::string condition = astToExpressionString(whereClause->children[0]);
-        if (!condition.empty()) {
-            ExpressionParser parser;
-            predicateExpr = parser.parse(condition);
-        }
+        condition = astToExpressionString(whereClause->children[0]);
     }
-    Expression* predicate = predicateExpr.get();
 
     // Prepare assignments
     struct AssignmentSpec {
@@ -1951,28 +2811,10 @@ std::size_t executeUpdateStatement(DatabaseSystem& db, std::shared_ptr<ASTNode>
         throw std::runtime_error("UPDATE has no assignments to apply");
     }
 
-    struct MatchedRow {
-        BlockAddress addr;
-        std::size_t slot{0};
-        Record record;
-    };
-    std::vector<MatchedRow> matches;
-
-    for (const auto& addr : table.blocks()) {
-        auto fetchResult = db.buffer().fetch(addr, false);
-        fetchResult.block.ensureInitialized(db.blockSize());
-        fetchResult.block.page.forEachRecord(
-            [&](std::size_t slotIdx, const Record& record) {
-                Tuple tuple{record.values, schema};
-                bool isMatch = true;
-                if (predicate) {
-                    isMatch = predicate->evaluate(tuple).asBool();
-                }
-                if (isMatch) {
-                    matches.push_back(MatchedRow{addr, slotIdx, record});
-                }
-            });
-    }
+    // Every target is found before the first write, so a row whose key moves
+    // within the scanned range is not updated twice.
+    QueryExecutor executor(db);
+    const auto matches = executor.locateRows(tableName, condition);
 
     std::size_t affected = 0;
     for (const auto& row : matches) {
@@ -1985,7 +2827,7 @@ std::size_t executeUpdateStatement(DatabaseSystem& db, std::shared_ptr<ASTNode>
             }
             updated.values[assignment.columnIndex] = value.asString();
         }
-        if (db.updateRecord(row.addr, row.slot, std::move(updated))) {
+        if (db.updateRecord(row.location.address, row.location.slot, std::move(updated))) {
             ++affected;
         }
     }
@@ -2012,44 +2854,17 @@ std::size_t executeDeleteStatement(DatabaseSystem& db, std::shared_ptr<ASTNode>
         throw std::runtime_error("DELETE missing target table");
     }
 
-    const Table& table = db.getTable(tableName);
-    auto schema = buildSchemaFromTable(table);
-
-    std::unique_ptr<Expression> predicateExpr;
+    std::string condition;
     if (whereClause && !whereClause->children.empty()) {
-        std::string condition = astToExpressionString(whereClause->children[0]);
-        if (!condition.empty()) {
-            ExpressionParser parser;
-            predicateExpr = parser.parse(condition);
-        }
+        condition = astToExpressionString(whereClause->children[0]);
     }
-    Expression* predicate = predicateExpr.get();
 
-    struct TargetRow {
-        BlockAddress addr;
-        std::size_t slot{0};
-    };
-    std::vector<TargetRow> targets;
-
-    for (const auto& addr : table.blocks()) {
-        auto fetchResult = db.buffer().fetch(addr, false);
-        fetchResult.block.ensureInitialized(db.blockSize());
-        fetchResult.block.page.forEachRecord(
-            [&](std::size_t slotIdx, const Record& record) {
-                Tuple tuple{record.values, schema};
-                bool isMatch = true;
-                if (predicate) {
-                    isMatch = predicate->evaluate(tuple).asBool();
-                }
-                if (isMatch) {
-                    targets.push_back(TargetRow{addr, slotIdx});
-                }
-            });
-    }
+    QueryExecutor executor(db);
+    const auto targets = executor.locateRows(tableName, condition);
 
     std::size_t affected = 0;
     for (const auto& target : targets) {
-        if (db.deleteRecord(target.addr, target.slot)) {
+        if (db.deleteRecord(target.location.address, target.location.slot)) {
             ++affected;
         }
     }
@@ -1,20 +1,32 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <cmath>
 #include <cstdint>
+#include <cstdio>
 #include <filesystem>
 #include <fstream>
 #include <functional>
 #include <iostream>
+#include <iterator>
 #include <optional>
+#include <sstream>
 #include <stdexcept>
 #include <string>
+#include <thread>
+#include <tuple>
 #include <unordered_set>
 #include <vector>
 
+#include "executor/bitmap_scan.h"
 #include "executor/executor.h"
 #include "executor/result_set.h"
+#include "executor/table_scan.h"
 #include "index/index_manager.h"
 #include "storage/buffer_pool.h"
 #include "storage/page.h"
+#include "storage/page_guard.h"
+#include "storage/write_ahead_log.h"
 #include "system/database.h"
 
 using namespace dbms;
@@ -131,6 +143,44 @@ void testBufferPoolLRU() {
     removeIfExists(path);
 }
 
+void testPageGuardsRefetchEvictedBlocks() {
+    const fs::path path = fs::current_path() / "tmp_dbms_tests" / "page_guards";
+    removeIfExists(path);
+
+    DiskStorage disk(4, path.string(), 256);
+    BufferPool pool(1, disk);
+    PageGuards guards(pool, 256);
+    const auto a1 = disk.allocateBlock("t");
+    const auto a2 = disk.allocateBlock("t");
+
+    {
+        auto first = guards.write(a1);
+        const auto slot = first->insertRecord(Record{"before eviction"});
+        require(slot.has_value(), "the write guard should accept a record");
+
+        // One frame: reading a2 evicts a1 while `first` still holds it.
+        auto second = guards.read(a2);
+        require(second->recordCount() == 0, "the second block should be empty");
+        require(guards.guardedBlocks() == 2, "both blocks should be guarded");
+
+        const Record *kept = first->getRecord(*slot);
+        require(kept && kept->values[0] == "before eviction",
+                "a guard should fetch its evicted block again, with its earlier changes");
+        require(guards.refetches() == 1, "the evicted block should be fetched once more");
+        first->insertRecord(Record{"after eviction"});
+
+        WritePageGuard moved = std::move(first);
+        require(!first && moved && moved.address() == a1, "moving a guard should move its pin");
+        require(guards.guardedBlocks() == 2, "a move should not release the pin");
+    }
+    require(guards.guardedBlocks() == 0, "destroyed guards should release their blocks");
+
+    auto check = guards.read(a2);
+    require(guards.read(a1)->recordCount() == 2, "changes made after a re-fetch should be kept");
+    require(check->recordCount() == 0, "an evicted read guard should see its block again");
+    removeIfExists(path);
+}
+
 void testBPlusTreeIndexOps() {
     IndexDefinition def{"idx_test", "t", "k", 0, 8, false};
     BPlusTreeIndex index(def, 256);
@@ -148,10 +198,391 @@ void testBPlusTreeIndexOps() {
     auto foundNew = index.find("k2");
     require(foundNew.has_value(), "new key should exist after update");
 
-    index.deleteRecord(r1Updated);
+    index.deleteRecord(r1Updated, addr, 0);
     require(!index.find("k2").has_value(), "key should be removed after delete");
 }
 
+void testIndexDeltaLogPersistence() {
+    const fs::path tempRoot = fs::current_path() / "tmp_dbms_tests" / "index_delta_log";
+    removeIfExists(tempRoot);
+    fs::create_directories(tempRoot);
+    const std::string treePath = (tempRoot / "idx_delta.tree").string();
+    const std::string logPath = BPlusTree::deltaLogPath(treePath);
+
+    IndexDefinition def{"idx_delta", "t", "k", 0, 8, false};
+    BPlusTreeIndex index(def, 256);
+    const BlockAddress addr{"t", 0};
+    for (std::size_t i = 0; i < 200; ++i) {
+        index.insertRecord(Record{"k" + std::to_string(1000 + i)}, addr, i);
+    }
+    index.persistChanges(treePath);
+    require(fs::exists(treePath), "first persist should write a full snapshot");
+    require(!fs::exists(logPath), "snapshot should not leave a delta log behind");
+
+    auto readAll = [](const std::string &path) {
+        std::ifstream in(path, std::ios::binary);
+        return std::string((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    };
+    const std::string snapshot = readAll(treePath);
+
+    index.insertRecord(Record{"k9999"}, addr, 999);
+    index.persistChanges(treePath);
+    index.deleteRecord(Record{"k1000"}, addr, 0);
+    index.persistChanges(treePath);
+    require(readAll(treePath) == snapshot, "small changes must not rewrite the snapshot");
+    require(fs::exists(logPath) && fs::file_size(logPath) < snapshot.size(),
+            "small changes should be appended to the delta log");
+
+    {
+        std::ofstream torn(logPath, std::ios::binary | std::ios::app);
+        torn << "BATCH ROOT 1 NEXT 2 NODES 1 FREED 0\nNODE 1 1 0 -1\n";
+    }
+
+    BPlusTreeIndex reloaded(def, 256);
+    reloaded.loadFromFile(treePath);
+    require(!reloaded.find("k1000").has_value(), "deleted key should stay deleted after replay");
+    auto added = reloaded.find("k9999");
+    require(added.has_value() && added->slot == 999, "logged insert should survive reload");
+    for (std::size_t i = 1; i < 200; ++i) {
+        auto ptr = reloaded.find("k" + std::to_string(1000 + i));
+        require(ptr.has_value() && ptr->slot == i, "snapshot keys should survive reload");
+    }
+
+    reloaded.insertRecord(Record{"k0001"}, addr, 1);
+    reloaded.persistChanges(treePath);
+    require(!fs::exists(logPath), "a torn log tail should be folded into a new snapshot");
+
+    removeIfExists(tempRoot);
+}
+
+void testIndexPagesThroughBufferPool() {
+    const fs::path tempRoot = fs::current_path() / "tmp_dbms_tests" / "paged_index";
+    removeIfExists(tempRoot);
+
+    TableSchema items(
+        "items",
+        {
+            {"id", ColumnType::Integer, 8},
+            {"label", ColumnType::String, 16},
+        });
+
+    const std::size_t blockSizeBytes = 256;
+    const std::size_t mainMemoryBytes = 8 * 1024; // only a handful of frames
+    const std::size_t diskBytes = 4 * 1024 * 1024;
+    const std::size_t rowCount = 400;
+    auto keyFor = [](std::size_t i) {
+        std::string key = std::to_string(i);
+        return std::string(5 - key.size(), '0') + key;
+    };
+
+    {
+        WorkingDirGuard guard(tempRoot);
+        removeIfExists("storage");
+        DatabaseSystem db(blockSizeBytes, mainMemoryBytes, diskBytes);
+        db.registerTable(items);
+        db.createIndex("idx_items_id", "items", "id");
+        for (std::size_t i = 0; i < rowCount; ++i) {
+            db.insertRecord("items", Record{keyFor(i), "item" + std::to_string(i)});
+        }
+        require(db.buffer().capacity() < 32, "test needs a buffer smaller than the index");
+
+        for (std::size_t i = 0; i < rowCount; i += 37) {
+            auto ptr = db.searchIndex("idx_items_id", keyFor(i));
+            require(ptr.has_value(), "paged index should find every inserted key");
+            auto rec = db.readRecord(ptr->address, ptr->slot);
+            require(rec.has_value() && rec->values[0] == keyFor(i),
+                    "paged index should point at the matching record");
+        }
+        db.flushAll();
+    }
+
+    const fs::path segment = tempRoot / "storage" / "idx.idx_items_id";
+    std::size_t pageFiles = 0;
+    for (const auto &entry : fs::directory_iterator(segment)) {
+        (void)entry;
+        ++pageFiles;
+    }
+    require(pageFiles >= 32, "index pages should be stored as blocks of their own segment");
+    const fs::path metaFile = tempRoot / "storage" / "indexes" / "idx_items_id.tree";
+    require(fs::file_size(metaFile) < blockSizeBytes,
+            "index file should only hold the tree metadata");
+
+    {
+        WorkingDirGuard guard(tempRoot);
+        DatabaseSystem db(blockSizeBytes, mainMemoryBytes, diskBytes);
+        db.registerTable(items);
+        auto victim = db.searchIndex("idx_items_id", keyFor(7));
+        require(victim.has_value(), "checkpointed index should load without a rebuild");
+        db.deleteRecord(victim->address, victim->slot);
+        require(!db.searchIndex("idx_items_id", keyFor(7)).has_value(),
+                "deleted key should disappear from the paged index");
+        for (std::size_t i = 0; i < rowCount; i += 41) {
+            if (i == 7) {
+                continue;
+            }
+            auto ptr = db.searchIndex("idx_items_id", keyFor(i));
+            require(ptr.has_value(), "paged index should be usable after restart");
+        }
+    }
+
+    removeIfExists(tempRoot);
+}
+
+void testNodeKeysSearch() {
+    // Keys of mixed lengths, including embedded and trailing zero bytes and
+    // one longer than the initial slot width.
+    std::vector<std::string> keys = {"", "a", std::string("a\0", 2), "ab", std::string("ab\0\0", 4),
+                                     "abc", "b", std::string("\0", 1), "\xff\xfe", "zzzzzzzzzzzz",
+                                     encodeIndexKey("-5", ColumnType::Integer, kNumericIndexKeyBytes),
+                                     encodeIndexKey("7", ColumnType::Integer, kNumericIndexKeyBytes)};
+    for (int i = 0; i < 60; ++i) {
+        keys.push_back("k" + std::to_string(i * 37 % 61));
+    }
+    std::sort(keys.begin(), keys.end());
+    keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+
+    NodeKeys slots(4);
+    std::vector<std::string> expected;
+    for (std::size_t i = 0; i < keys.size(); ++i) {
+        // Inserted out of order to exercise shifting and slot widening.
+        const auto &key = keys[(i * 7) % keys.size()];
+        const std::size_t at = slots.lowerBound(key);
+        slots.insert(at, key);
+        expected.insert(std::lower_bound(expected.begin(), expected.end(), key), key);
+    }
+    require(slots.size() == expected.size(), "every key should be stored once");
+    for (std::size_t i = 0; i < expected.size(); ++i) {
+        require(slots[i] == expected[i], "slots should keep keys in byte order");
+    }
+    std::vector<std::string> probes = keys;
+    probes.push_back("aa");
+    probes.push_back(std::string("ab\0", 3));
+    probes.push_back("zzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzz");
+    probes.push_back("k");
+    for (const auto &probe : probes) {
+        const auto lower = static_cast<std::size_t>(
+            std::lower_bound(expected.begin(), expected.end(), probe) - expected.begin());
+        const auto upper = static_cast<std::size_t>(
+            std::upper_bound(expected.begin(), expected.end(), probe) - expected.begin());
+        require(slots.lowerBound(probe) == lower && slots.upperBound(probe) == upper,
+                "slot search should agree with string order");
+        require(slots.matches(lower, probe) == (lower < expected.size() && expected[lower] == probe),
+                "exact match should only accept equal keys");
+    }
+
+    NodeKeys right(4);
+    right.append(slots, slots.size() / 2, slots.size());
+    slots.truncate(slots.size() / 2);
+    slots.erase(0);
+    slots.set(0, expected[1]);
+    slots.append(right, 0, right.size());
+    expected.erase(expected.begin());
+    require(slots.size() == expected.size() && slots.front() == expected.front() &&
+                slots.back() == expected.back() && slots.lowerBound("k3") == static_cast<std::size_t>(
+                    std::lower_bound(expected.begin(), expected.end(), "k3") - expected.begin()),
+            "split and merge should keep slots searchable");
+
+    NodeKeys shared(12);
+    for (const char *key : {"order/0007", "order/0042", "order/0100"}) {
+        shared.push_back(key);
+    }
+    shared.compact();
+    require(shared.prefix() == "order/0" && shared.suffix(1) == "042" && shared[2] == "order/0100",
+            "compact should keep the shared prefix once");
+    require(shared.lowerBound("order/0042") == 1 && shared.upperBound("order/") == 0 &&
+                shared.lowerBound("p") == shared.size(),
+            "keys inside and outside the prefix should search like strings");
+    shared.insert(0, "item/9");
+    require(shared.prefix().empty() && shared[0] == "item/9" && shared[1] == "order/0007",
+            "a key outside the prefix should shorten it");
+}
+
+void testBPlusTreeBulkLoad() {
+    const BlockAddress addr{"t", 0};
+    std::vector<std::pair<std::string, IndexPointer>> entries;
+    for (std::size_t i = 0; i < 2000; ++i) {
+        std::string key = std::to_string(i);
+        entries.emplace_back(std::string(6 - key.size(), '0') + key, IndexPointer{addr, i});
+    }
+    std::vector<std::pair<std::string, IndexPointer>> shuffled(entries.rbegin(), entries.rend());
+    shuffled.emplace_back(entries[10].first, IndexPointer{addr, 99999});
+
+    BPlusTree packed(256, 8);
+    packed.bulkInsert(shuffled);
+    BPlusTree loose(256, 8);
+    loose.setBulkLoadFillFactor(0.5);
+    loose.bulkInsert(entries);
+    const std::size_t leaves = (entries.size() + packed.entriesPerPage() - 1) / packed.entriesPerPage();
+    require(packed.pageCount() < leaves + leaves / 2,
+            "bulk load at fill factor 1.0 should pack leaves full");
+    require(loose.pageCount() > packed.pageCount(),
+            "a lower fill factor should leave headroom in more pages");
+
+    auto dup = packed.find(entries[10].first);
+    require(dup.has_value() && dup->slot == 99999, "last duplicate should win in bulk load");
+    for (std::size_t i = 0; i < entries.size(); i += 2) {
+        require(loose.erase(entries[i].first), "bulk-loaded key should be erasable");
+    }
+    for (std::size_t i = 0; i < entries.size(); ++i) {
+        const bool present = loose.find(entries[i].first).has_value();
+        require(present == (i % 2 == 1), "erase after bulk load should keep the tree consistent");
+    }
+    loose.insertUnique("zzzzzz", IndexPointer{addr, 1});
+    require(loose.find("zzzzzz").has_value(), "insert after bulk load should succeed");
+}
+
+// Keeps index pages in memory so tree tests can check the page format
+// without a buffer pool.
+class MemoryIndexPageStore : public IndexPageStore {
+public:
+    explicit MemoryIndexPageStore(std::size_t capacity)
+        : capacity_(capacity) {}
+
+    std::size_t pageCapacity() const override {
+        return capacity_;
+    }
+
+    std::vector<std::size_t> pageIds() const override {
+        std::vector<std::size_t> ids(pages_.size());
+        for (std::size_t i = 0; i < ids.size(); ++i) {
+            ids[i] = i;
+        }
+        return ids;
+    }
+
+    std::size_t allocatePage() override {
+        pages_.emplace_back();
+        return pages_.size() - 1;
+    }
+
+    std::string readPage(std::size_t pageId) override {
+        return pages_.at(pageId);
+    }
+
+    void writePage(std::size_t pageId, const std::string &payload) override {
+        if (payload.size() > capacity_) {
+            throw std::runtime_error("index page overflows its capacity");
+        }
+        pages_.at(pageId) = payload;
+    }
+
+private:
+    std::size_t capacity_;
+    std::vector<std::string> pages_;
+};
+
+void testBPlusTreePrefixCompression() {
+    const fs::path tempRoot = fs::current_path() / "tmp_dbms_tests" / "prefix_compression";
+    removeIfExists(tempRoot);
+    fs::create_directories(tempRoot);
+    const BlockAddress addr{"t", 0};
+    const auto orderKey = [](const std::string &tenant, std::size_t id) {
+        const std::string digits = std::to_string(id);
+        return "tenant-" + tenant + "/orders/" + std::string(8 - digits.size(), '0') + digits;
+    };
+    std::vector<std::pair<std::string, IndexPointer>> entries;
+    for (std::size_t i = 0; i < 3000; ++i) {
+        entries.emplace_back(orderKey("000123", i), IndexPointer{addr, i});
+    }
+
+    MemoryIndexPageStore store(480);
+    BPlusTree tree(512, 40);
+    tree.attachPageStore(&store, "t");
+    tree.bulkInsert(entries);
+    const std::size_t plainLeaves = (entries.size() + tree.entriesPerPage() - 1) / tree.entriesPerPage();
+    require(tree.pageCount() * 2 < plainLeaves, "a shared key prefix should be stored once per page");
+
+    for (std::size_t i = 0; i < entries.size(); i += 3) {
+        require(tree.erase(entries[i].first), "compressed keys should be erasable");
+    }
+    for (std::size_t i = 0; i < 500; ++i) {
+        // Keys of another tenant break the prefix of the pages they land in.
+        tree.insertUnique(orderKey(i % 2 == 0 ? "000124" : "000123", 5000 + i), IndexPointer{addr, 5000 + i});
+    }
+    const std::string treePath = (tempRoot / "orders.tree").string();
+    tree.checkpoint(treePath);
+
+    BPlusTree reloaded(512, 40);
+    reloaded.attachPageStore(&store, "t");
+    reloaded.loadFromFile(treePath, 512, 40);
+    for (std::size_t i = 0; i < entries.size(); ++i) {
+        require(reloaded.find(entries[i].first).has_value() == (i % 3 != 0),
+                "prefix-compressed pages should reload every key");
+    }
+    std::size_t scanned = 0;
+    std::string previous;
+    reloaded.scan(std::nullopt, true, [&](const std::string &key, const IndexPointer &) {
+        require(key > previous, "scan should return keys in order");
+        previous = key;
+        ++scanned;
+        return true;
+    });
+    require(scanned == entries.size() - 1000 + 500, "scan should visit every key once");
+}
+
+void testConcurrentBPlusTree() {
+    const BlockAddress addr{"t", 0};
+    const auto key = [](std::size_t id) {
+        const std::string digits = std::to_string(id);
+        return std::string(6 - digits.size(), '0') + digits;
+    };
+    constexpr std::size_t kKeys = 4000;
+    std::vector<std::pair<std::string, IndexPointer>> entries;
+    for (std::size_t i = 0; i < kKeys; ++i) {
+        entries.emplace_back(key(2 * i), IndexPointer{addr, 2 * i});
+    }
+    BPlusTree tree(256, 8);
+    tree.bulkInsert(entries);
+    tree.setConcurrentAccess(true);
+
+    // Writers insert the odd keys of their share and erase half of its even
+    // keys; readers only look for even keys that are never erased.
+    std::atomic<bool> missing{false};
+    std::atomic<bool> unordered{false};
+    std::vector<std::thread> threads;
+    for (std::size_t writer = 0; writer < 4; ++writer) {
+        threads.emplace_back([&, writer] {
+            for (std::size_t i = writer; i < kKeys; i += 4) {
+                tree.insertUnique(key(2 * i + 1), IndexPointer{addr, 2 * i + 1});
+                if (i % 2 == 0) {
+                    tree.erase(key(2 * i));
+                }
+            }
+        });
+    }
+    for (std::size_t reader = 0; reader < 4; ++reader) {
+        threads.emplace_back([&, reader] {
+            for (std::size_t round = 0; round < 4000; ++round) {
+                const std::size_t i = ((round * 7 + reader) % kKeys) | 1;
+                const auto found = tree.find(key(2 * i));
+                if (!found || found->slot != 2 * i) {
+                    missing = true;
+                }
+                if (round % 100 == 0) {
+                    std::string previous;
+                    std::size_t visited = 0;
+                    tree.scan(key(2 * i), true, [&](const std::string &current, const IndexPointer &) {
+                        if (current <= previous) {
+                            unordered = true;
+                        }
+                        previous = current;
+                        return ++visited < 200;
+                    });
+                }
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    require(!missing, "lookups should never miss keys that other threads leave alone");
+    require(!unordered, "scans should see keys in order while leaves change");
+    for (std::size_t i = 0; i < kKeys; ++i) {
+        require(tree.find(key(2 * i + 1)).has_value(), "every concurrent insert should land");
+        require(tree.find(key(2 * i)).has_value() == (i % 2 == 1), "every concurrent erase should land");
+    }
+}
+
 DatabaseSystem buildSampleDatabase() {
     const std::size_t blockSizeBytes = 512;
     const std::size_t mainMemoryBytes = 2 * 1024 * 1024; // 2 MiB
@@ -196,7 +627,7 @@ std::optional<std::pair<BlockAddress, std::size_t>> findRecordById(DatabaseSyste
                                                                    const std::string& id) {
     const Table& t = db.getTable(table);
     for (const auto& addr : t.blocks()) {
-        auto fetch = db.buffer().fetch(addr, false);
+        auto fetch = db.pages().fetch(addr, false);
         fetch.block.ensureInitialized(db.blockSize());
         const auto slots = fetch.block.slotCount();
         for (std::size_t i = 0; i < slots; ++i) {
@@ -559,6 +990,67 @@ void testTransactionCommit() {
     require(nameFor3 == "Carolyn", "committed update should persist after commit");
 }
 
+void testCheckpointTruncatesWalAndRedoIsIdempotent() {
+    const fs::path tempRoot = fs::current_path() / "tmp_dbms_tests" / "wal_checkpoint";
+    removeIfExists(tempRoot);
+    WorkingDirGuard guard(tempRoot);
+    removeIfExists("storage");
+
+    const std::size_t blockSizeBytes = 512;
+    const std::size_t mainMemoryBytes = 64 * 1024;
+    const std::size_t diskBytes = 1024 * 1024;
+    TableSchema notes("notes", {{"id", ColumnType::String, 8}, {"body", ColumnType::String, 16}});
+    const fs::path walPath = fs::path("storage") / "logs" / "wal.log";
+    {
+        DatabaseSystem db(blockSizeBytes, mainMemoryBytes, diskBytes);
+        db.registerTable(notes);
+        db.insertRecord("notes", Record{"1", "a"});
+        require(!WriteAheadLog(walPath.string()).load().empty(),
+                "statements outside a transaction should stay in the WAL until a checkpoint");
+        db.beginTransaction();
+        db.insertRecord("notes", Record{"2", "b"});
+        auto dump = db.dumpTable("notes");
+        for (const auto &row : dump.rows) {
+            if (row.values[0] == "2") {
+                db.updateRecord(BlockAddress{"notes", row.blockIndex}, row.slotIndex, Record{"2", "bb"});
+            }
+        }
+        db.commitTransaction();
+        require(WriteAheadLog(walPath.string()).load().empty(),
+                "commit checkpoints every page and empties the WAL");
+    }
+
+    // A crash between writing the pages and emptying the log leaves
+    // committed entries whose changes are already in the block files; one
+    // more committed insert never reached them.
+    {
+        WriteAheadLog wal(walPath.string());
+        const BlockAddress first{"notes", 0};
+        wal.logBegin(7);
+        wal.logInsert(7, first, 1, Record{"2", "b"});
+        wal.logUpdate(7, first, 1, Record{"2", "b"}, Record{"2", "bb"});
+        wal.logInsert(7, first, 2, Record{"3", "c"});
+        wal.logCommit(7);
+        wal.logBegin(8);
+        wal.logDelete(8, first, 0, Record{"1", "a"});
+        wal.logCommit(8);
+    }
+
+    for (int restart = 0; restart < 2; ++restart) {
+        DatabaseSystem db(blockSizeBytes, mainMemoryBytes, diskBytes);
+        db.registerTable(notes);
+        auto dump = db.dumpTable("notes");
+        std::vector<std::string> rows;
+        for (const auto &row : dump.rows) {
+            rows.push_back(row.values[0] + "=" + row.values[1]);
+        }
+        std::sort(rows.begin(), rows.end());
+        require(rows == std::vector<std::string>({"2=bb", "3=c"}),
+                "redo must apply each committed change exactly once");
+        require(WriteAheadLog(walPath.string()).load().empty(), "recovery should empty the WAL");
+    }
+}
+
 void testBufferEvictionFlushesDirtyPage() {
     const fs::path tempRoot = fs::current_path() / "tmp_dbms_tests" / "buffer_pressure";
     removeIfExists(tempRoot);
@@ -735,6 +1227,271 @@ ResultSet runSql(DatabaseSystem &db, const std::string &sql) {
     return executor.execute(physicalPlan);
 }
 
+std::shared_ptr<PhysicalPlanNode> planSql(DatabaseSystem &db, const std::string &sql) {
+    Lexer lexer(sql);
+    Parser parser(lexer.tokenize());
+    auto ast = parser.parse();
+    SemanticAnalyzer analyzer(db);
+    analyzer.analyze(ast);
+    LogicalPlanGenerator logicalGen;
+    LogicalOptimizer optimizer;
+    PhysicalPlanGenerator physGen(db);
+    return physGen.generatePhysicalPlan(optimizer.optimize(logicalGen.generateLogicalPlan(ast)));
+}
+
+bool planUses(const std::shared_ptr<PhysicalPlanNode> &node, PhysicalOpType type) {
+    if (!node) {
+        return false;
+    }
+    if (node->opType == type) {
+        return true;
+    }
+    for (const auto &child : node->children) {
+        if (planUses(child, type)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// First node of `type` in the plan, depth first.
+std::shared_ptr<PhysicalPlanNode> findPlanNode(const std::shared_ptr<PhysicalPlanNode> &node,
+                                               PhysicalOpType type) {
+    if (!node || node->opType == type) {
+        return node;
+    }
+    for (const auto &child : node->children) {
+        if (auto found = findPlanNode(child, type)) {
+            return found;
+        }
+    }
+    return nullptr;
+}
+
+void testLazyIndexOpen() {
+    const fs::path tempRoot = fs::current_path() / "tmp_dbms_tests" / "lazy_index_open";
+    removeIfExists(tempRoot);
+
+    TableSchema users("users",
+                      {{"id", ColumnType::Integer, 8},
+                       {"name", ColumnType::String, 16},
+                       {"city", ColumnType::String, 8}});
+    const std::size_t blockSizeBytes = 512;
+    const std::size_t mainMemoryBytes = 2 * 1024 * 1024;
+    const std::size_t diskBytes = 8 * 1024 * 1024;
+    const std::vector<std::string> names{"idx_users_id", "idx_users_name", "idx_users_city"};
+
+    auto readFile = [](const fs::path &path) {
+        std::ifstream in(path, std::ios::binary);
+        return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    };
+
+    {
+        WorkingDirGuard guard(tempRoot);
+        removeIfExists("storage");
+        DatabaseSystem db(blockSizeBytes, mainMemoryBytes, diskBytes);
+        db.registerTable(users);
+        for (int i = 0; i < 300; ++i) {
+            db.insertRecord("users", Record{std::to_string(i), "user" + std::to_string(i), "c" + std::to_string(i % 5)});
+        }
+        db.createIndex("idx_users_id", "users", "id");
+        db.createIndex("idx_users_name", "users", std::vector<std::string>{"name"}, {}, IndexMethod::Hash);
+        db.createIndex("idx_users_city", "users", std::vector<std::string>{"city"}, {}, IndexMethod::Bitmap);
+        require(db.indexOpen("idx_users_id"), "a newly created index should be open");
+        db.flushAll();
+    }
+
+    {
+        WorkingDirGuard guard(tempRoot);
+        DatabaseSystem db(blockSizeBytes, mainMemoryBytes, diskBytes);
+        db.registerTable(users);
+        for (const auto &name : names) {
+            require(!db.indexOpen(name), "registering a table should not read " + name);
+        }
+
+        const fs::path cityFile = tempRoot / "storage" / "indexes" / "idx_users_city.tree";
+        const std::string before = readFile(cityFile);
+        auto ptr = db.searchIndex("idx_users_id", "42");
+        require(ptr.has_value() && db.readRecord(ptr->address, ptr->slot)->values[1] == "user42",
+                "the first lookup should open the index from its file");
+        require(db.indexOpen("idx_users_id") && !db.indexOpen("idx_users_name") &&
+                    !db.indexOpen("idx_users_city"),
+                "a lookup should open only the index it probes");
+        require(runSql(db, "SELECT id FROM users WHERE name = 'user7'").size() == 1,
+                "queries should open the index they plan on");
+        require(db.indexOpen("idx_users_name") && !db.indexOpen("idx_users_city"),
+                "the planner should not open indexes it does not use");
+        db.flushAll();
+        require(readFile(cityFile) == before, "flushing should leave a closed index file alone");
+
+        db.insertRecord("users", Record{"300", "user300", "c1"});
+        for (const auto &name : names) {
+            require(db.indexOpen(name), "changing the table should open " + name);
+        }
+        db.flushAll();
+    }
+
+    {
+        WorkingDirGuard guard(tempRoot);
+        DatabaseSystem db(blockSizeBytes, mainMemoryBytes, diskBytes);
+        db.registerTable(users);
+        require(db.indexSummaries().size() == names.size(), "every stored index should be listed");
+        for (const auto &name : names) {
+            require(!db.indexOpen(name), "listing indexes should not open " + name);
+        }
+        require(db.searchIndexBitmap("idx_users_city", "c1").cardinality() == 61,
+                "an index opened late should keep rows added in the previous session");
+        require(db.searchIndex("idx_users_name", "user300").has_value(),
+                "the hash index should find the row added before the restart");
+    }
+
+    removeIfExists(tempRoot);
+}
+
+void testTinyBufferPoolWorkload() {
+    const fs::path tempRoot = fs::current_path() / "tmp_dbms_tests" / "tiny_buffer_pool";
+    removeIfExists(tempRoot);
+    WorkingDirGuard guard(tempRoot);
+    removeIfExists("storage");
+
+    // Two frames shared by table blocks and index pages: every statement
+    // below fetches more blocks than fit, so none may keep using a block
+    // reference after a later fetch.
+    const std::size_t blockSizeBytes = 512;
+    const std::size_t mainMemoryBytes = 2048;
+    const std::size_t diskBytes = 8 * 1024 * 1024;
+    DatabaseSystem db(blockSizeBytes, mainMemoryBytes, diskBytes);
+    require(db.buffer().capacity() == 2, "test expects a two-frame pool");
+
+    TableSchema accounts("accounts",
+                         {{"id", ColumnType::Integer, 8},
+                          {"owner", ColumnType::String, 16},
+                          {"tier", ColumnType::String, 8}});
+    db.registerTable(accounts);
+    db.createIndex("idx_accounts_id", "accounts", "id");
+    db.createIndex("idx_accounts_owner", "accounts", std::vector<std::string>{"owner"}, {}, IndexMethod::Hash);
+    for (int i = 0; i < 400; ++i) {
+        db.insertRecord("accounts", Record{std::to_string(i), "own" + std::to_string(1000 + i), i % 2 ? "gold" : "base"});
+    }
+
+    runSql(db, "UPDATE accounts SET tier = 'plat' WHERE id < 50");
+    runSql(db, "DELETE FROM accounts WHERE id >= 350");
+    db.beginTransaction();
+    runSql(db, "DELETE FROM accounts WHERE tier = 'base'");
+    db.rollbackTransaction();
+
+    require(runSql(db, "SELECT id FROM accounts").size() == 350, "deletes should leave 350 rows");
+    require(runSql(db, "SELECT id FROM accounts WHERE tier = 'plat'").size() == 50,
+            "updates should reach every targeted row");
+    require(runSql(db, "SELECT id FROM accounts WHERE id >= 100 AND id < 200").size() == 100,
+            "index range scans should see every row");
+    auto rows = runSql(db, "SELECT id FROM accounts WHERE owner = 'own1234'");
+    require(rows.size() == 1 && rows.getTuple(0).getValue("id") == "234",
+            "hash lookups should find the row");
+    require(runSql(db, "SELECT a.id FROM accounts a JOIN accounts b ON a.id = b.id WHERE a.tier = 'gold'").size() == 150,
+            "a self join should pair every row");
+}
+
+void testTableScanReadAhead() {
+    const fs::path tempRoot = fs::current_path() / "tmp_dbms_tests" / "table_scan_read_ahead";
+    removeIfExists(tempRoot);
+    WorkingDirGuard guard(tempRoot);
+    removeIfExists("storage");
+
+    const std::size_t blockSizeBytes = 512;
+    const std::size_t mainMemoryBytes = 4096;
+    const std::size_t diskBytes = 8 * 1024 * 1024;
+    DatabaseSystem db(blockSizeBytes, mainMemoryBytes, diskBytes);
+    TableSchema events("events", {{"id", ColumnType::Integer, 8}, {"kind", ColumnType::String, 16}});
+    db.registerTable(events);
+    for (int i = 0; i < 600; ++i) {
+        db.insertRecord("events", Record{std::to_string(i), i % 3 ? "view" : "click"});
+    }
+    db.flushAll();
+    const std::size_t blocks = db.getTable("events").blocks().size();
+    require(blocks >= 32, "test expects a table larger than the read-ahead threshold");
+
+    db.setReadAheadDepth(0);
+    require(runSql(db, "SELECT id FROM events WHERE kind = 'click'").size() == 200,
+            "a scan without read-ahead should see every row");
+    require(db.readAheadStats().scans == 0, "a depth of 0 should not start a reader");
+
+    db.setReadAheadDepth(8);
+    db.insertRecord("events", Record{"600", "click"});
+    require(runSql(db, "SELECT id FROM events WHERE kind = 'click'").size() == 201,
+            "a scan with read-ahead should still see rows that are only in the pool");
+    const auto &stats = db.readAheadStats();
+    require(stats.scans == 1, "one scan should have started one reader");
+    require(stats.blocksAhead + stats.blocksLate == db.getTable("events").blocks().size(),
+            "every block the scan fetched should be counted once");
+    require(stats.blocksRead <= db.getTable("events").blocks().size(),
+            "the reader should load each block at most once");
+
+    // Whether the reader gets ahead of a scan depends on scheduling; before
+    // the scan reaches its first block it has time to fill the window.
+    ReadAheadStats standalone;
+    {
+        BlockReadAhead reader(db.getTable("events").blocks(), db.diskBlocks(), "storage", blockSizeBytes, 8,
+                              standalone);
+        for (int i = 0; i < 500 && reader.blocksRead() < 5; ++i) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        require(reader.blocksRead() == 5 && reader.depth() == 4,
+                "an idle reader should read the first block and an initial window of four");
+    }
+    require(standalone.scans == 1 && standalone.blocksRead == 5, "the reader should report its reads when it stops");
+}
+
+void testBulkScanRing() {
+    const fs::path tempRoot = fs::current_path() / "tmp_dbms_tests" / "bulk_scan_ring";
+    removeIfExists(tempRoot);
+    WorkingDirGuard guard(tempRoot);
+    removeIfExists("storage");
+
+    const std::size_t blockSizeBytes = 512;
+    const std::size_t mainMemoryBytes = 16 * 1024;
+    const std::size_t diskBytes = 8 * 1024 * 1024;
+    DatabaseSystem db(blockSizeBytes, mainMemoryBytes, diskBytes);
+    db.setReadAheadDepth(0);
+    TableSchema hot("hot", {{"id", ColumnType::Integer, 8}, {"name", ColumnType::String, 16}});
+    TableSchema events("events", {{"id", ColumnType::Integer, 8}, {"kind", ColumnType::String, 16}});
+    db.registerTable(hot);
+    db.registerTable(events);
+    for (int i = 0; i < 10; ++i) {
+        db.insertRecord("hot", Record{std::to_string(i), "hot" + std::to_string(i)});
+    }
+    for (int i = 0; i < 1200; ++i) {
+        db.insertRecord("events", Record{std::to_string(i), i % 3 ? "view" : "click"});
+    }
+    db.flushAll();
+    const auto &eventBlocks = db.getTable("events").blocks();
+    require(eventBlocks.size() > 2 * db.buffer().capacity(), "test expects a table larger than the pool");
+
+    require(runSql(db, "SELECT id FROM hot").size() == 10, "the small table should be read through the pool");
+    const std::size_t missesBefore = db.buffer().misses();
+    require(runSql(db, "SELECT id FROM events WHERE kind = 'click'").size() == 400,
+            "a scan through the ring should see every row");
+    require(db.bulkRingFetches() >= eventBlocks.size(), "a large scan should read through the ring");
+    require(runSql(db, "SELECT id FROM hot").size() == 10 && db.buffer().misses() == missesBefore,
+            "a large scan should leave the small table resident");
+
+    // A write during the scan moves the rest of it to the shared pool, so
+    // the scan sees a row changed in a block it has not reached yet.
+    const BlockAddress last = eventBlocks.back();
+    TableScanOperator scan(db, "events");
+    scan.init();
+    require(scan.next().has_value(), "the scan should return a first row");
+    const auto before = db.readRecord(last, 0);
+    require(before.has_value(), "the last block should hold a row");
+    require(db.updateRecord(last, 0, Record{before->values[0], "late"}), "the update should apply");
+    std::size_t late = 0;
+    while (auto tuple = scan.next()) {
+        late += tuple->values[1] == "late" ? 1 : 0;
+    }
+    scan.close();
+    require(late == 1, "a scan should see a row written after it started");
+}
+
 void testSqlDistinctAndOrderBy() {
     const fs::path tempRoot = fs::current_path() / "tmp_dbms_tests" / "sql_distinct_order";
     removeIfExists(tempRoot);
@@ -792,6 +1549,723 @@ void testSqlLimitOffset() {
             "limit+offset should skip first row and take next two");
 }
 
+void testSqlIndexRangeScan() {
+    const fs::path tempRoot = fs::current_path() / "tmp_dbms_tests" / "sql_index_range";
+    removeIfExists(tempRoot);
+    WorkingDirGuard guard(tempRoot);
+    removeIfExists("storage");
+
+    const std::size_t blockSizeBytes = 512;
+    const std::size_t mainMemoryBytes = 2 * 1024 * 1024;
+    const std::size_t diskBytes = 8 * 1024 * 1024;
+    DatabaseSystem db(blockSizeBytes, mainMemoryBytes, diskBytes);
+
+    TableSchema items("items", {{"code", ColumnType::String, 8}, {"qty", ColumnType::Integer, 8}});
+    db.registerTable(items);
+    // Inserted out of order and spanning several scan batches.
+    for (int i = 0; i < 600; ++i) {
+        const int n = (i * 7) % 600;
+        char code[8];
+        std::snprintf(code, sizeof(code), "c%04d", n);
+        db.insertRecord("items", Record{code, std::to_string(n % 10)});
+    }
+    db.createIndex("idx_items_code", "items", "code");
+
+    auto codesOf = [](const ResultSet &rows) {
+        std::vector<std::string> codes;
+        for (const auto &row : rows) {
+            codes.push_back(row.getValue("code"));
+        }
+        return codes;
+    };
+
+    const std::string between = "SELECT code FROM items WHERE code BETWEEN 'c0100' AND 'c0399'";
+    require(planUses(planSql(db, between), PhysicalOpType::kIndexScan),
+            "BETWEEN on an indexed column should plan an index scan");
+    auto codes = codesOf(runSql(db, between));
+    require(codes.size() == 300, "BETWEEN should return both endpoints and everything in between");
+    require(std::is_sorted(codes.begin(), codes.end()), "range scan should return rows in key order");
+    require(codes.front() == "c0100" && codes.back() == "c0399", "BETWEEN endpoints are inclusive");
+
+    require(codesOf(runSql(db, "SELECT code FROM items WHERE code > 'c0590'")).size() == 9,
+            "open upper bound should run to the last leaf");
+    require(codesOf(runSql(db, "SELECT code FROM items WHERE 'c0010' > code")).size() == 10,
+            "literal on the left should mirror the comparison");
+    require(codesOf(runSql(db, "SELECT code FROM items WHERE code >= 'c0200' AND code < 'c0200'")).empty(),
+            "empty interval should return no rows");
+
+    const std::string prefix = "SELECT code FROM items WHERE code LIKE 'c01%' AND qty = 3";
+    require(planUses(planSql(db, prefix), PhysicalOpType::kIndexScan),
+            "prefix LIKE on an indexed column should plan an index scan");
+    codes = codesOf(runSql(db, prefix));
+    require(codes.size() == 10, "residual predicates should still filter range scan output");
+    for (const auto &code : codes) {
+        require(code.rfind("c01", 0) == 0 && code.back() == '3', "prefix scan returned a non-matching row");
+    }
+
+    require(!planUses(planSql(db, "SELECT code FROM items WHERE qty > 5"), PhysicalOpType::kIndexScan),
+            "predicates on unindexed columns should keep the table scan");
+    require(runSql(db, "SELECT code FROM items WHERE code LIKE '%9_'").size() == 60,
+            "non-prefix LIKE should be evaluated by the filter");
+}
+
+void testNumericIndexKeyOrder() {
+    const std::vector<std::string> ints = {"NULL", "-9000000000", "-10", "-9", "-1", "0", "2", "9", "10", "100"};
+    for (std::size_t i = 1; i < ints.size(); ++i) {
+        require(encodeIndexKey(ints[i - 1], ColumnType::Integer, kNumericIndexKeyBytes) <
+                    encodeIndexKey(ints[i], ColumnType::Integer, kNumericIndexKeyBytes),
+                "integer keys should sort numerically: " + ints[i - 1] + " < " + ints[i]);
+    }
+    const std::vector<std::string> doubles = {"-1e300", "-2.5", "-0.001", "0", "0.001", "3.14", "10", "1e300"};
+    for (std::size_t i = 1; i < doubles.size(); ++i) {
+        require(encodeIndexKey(doubles[i - 1], ColumnType::Double, kNumericIndexKeyBytes) <
+                    encodeIndexKey(doubles[i], ColumnType::Double, kNumericIndexKeyBytes),
+                "double keys should sort numerically: " + doubles[i - 1] + " < " + doubles[i]);
+    }
+    require(encodeIndexKey("-0.0", ColumnType::Double, kNumericIndexKeyBytes) ==
+                encodeIndexKey("0", ColumnType::Double, kNumericIndexKeyBytes),
+            "negative zero should share the key of zero");
+    require(encodeIndexKey("7.0", ColumnType::Integer, kNumericIndexKeyBytes) ==
+                encodeIndexKey("7", ColumnType::Integer, kNumericIndexKeyBytes),
+            "integral doubles should probe integer keys");
+    require(encodeIndexKey("42", ColumnType::Integer, kNumericIndexKeyBytes).size() == kNumericIndexKeyBytes,
+            "numeric keys should be fixed width");
+
+    const fs::path tempRoot = fs::current_path() / "tmp_dbms_tests" / "numeric_index_keys";
+    removeIfExists(tempRoot);
+    WorkingDirGuard guard(tempRoot);
+    removeIfExists("storage");
+
+    DatabaseSystem db(512, 2 * 1024 * 1024, 8 * 1024 * 1024);
+    TableSchema readings("readings", {{"n", ColumnType::Integer, 8}, {"v", ColumnType::Double, 8}});
+    db.registerTable(readings);
+    for (int i = 0; i < 200; ++i) {
+        const int n = (i * 37) % 200;
+        std::ostringstream v;
+        v << (n * 0.5 - 20);
+        db.insertRecord("readings", Record{std::to_string(n), v.str()});
+    }
+    db.createIndex("idx_readings_n", "readings", "n");
+    db.createIndex("idx_readings_v", "readings", "v");
+
+    auto column = [](const ResultSet &rows, const std::string &name) {
+        std::vector<double> values;
+        for (const auto &row : rows) {
+            values.push_back(std::stod(row.getValue(name)));
+        }
+        return values;
+    };
+
+    const std::string intRange = "SELECT n FROM readings WHERE n >= 9 AND n < 11";
+    require(planUses(planSql(db, intRange), PhysicalOpType::kIndexScan),
+            "integer range should plan an index scan");
+    require((column(runSql(db, intRange), "n") == std::vector<double>{9, 10}),
+            "integer range should follow numeric order");
+    auto tail = column(runSql(db, "SELECT n FROM readings WHERE n > 189.5"), "n");
+    require(tail.size() == 10 && tail.front() == 190, "fractional bound should round into the integer range");
+    require(runSql(db, "SELECT n FROM readings WHERE n = 2.5").size() == 0,
+            "fractional equality on an integer column matches nothing");
+
+    auto positives = column(runSql(db, "SELECT v FROM readings WHERE v > 0 AND v <= 2.5"), "v");
+    require(positives.size() == 5 && std::is_sorted(positives.begin(), positives.end()),
+            "double range should return (0, 2.5] in numeric order");
+    auto negatives = column(runSql(db, "SELECT v FROM readings WHERE v < 0"), "v");
+    require(negatives.size() == 40 && negatives.front() == -20,
+            "negative doubles should sort before positives");
+    require(db.searchIndex("idx_readings_n", "10").has_value(), "equality probe should encode the value");
+}
+
+void testNonUniqueIndexPostings() {
+    const fs::path tempRoot = fs::current_path() / "tmp_dbms_tests" / "non_unique_index";
+    removeIfExists(tempRoot);
+    fs::create_directories(tempRoot);
+
+    const BlockAddress addr{"t", 0};
+    std::vector<std::pair<std::string, IndexPointer>> entries;
+    for (std::size_t i = 0; i < 400; ++i) {
+        entries.emplace_back(i % 4 == 0 ? "heavy" : "k" + std::to_string(i), IndexPointer{addr, i});
+    }
+    BPlusTree tree(256, 8);
+    tree.setAllowDuplicates(true);
+    for (const auto &entry : entries) {
+        tree.insert(entry.first, entry.second);
+    }
+    require(tree.findAll("heavy").size() == 100, "a heavy key should keep every pointer");
+    std::size_t visited = 0;
+    tree.scan(std::string("heavy"), true, [&](const std::string &key, const IndexPointer &) {
+        if (key != "heavy") {
+            return false;
+        }
+        ++visited;
+        return true;
+    });
+    require(visited == 100, "scan should visit every pointer of a key");
+    const std::size_t pagesWithHeavy = tree.pageCount();
+    require(tree.erase("heavy", IndexPointer{addr, 40}), "a single pointer should be erasable");
+    require(!tree.erase("heavy", IndexPointer{addr, 41}), "erasing an absent pointer should fail");
+    const auto rest = tree.findAll("heavy");
+    require(rest.size() == 99 &&
+                std::none_of(rest.begin(), rest.end(), [](const IndexPointer &ptr) { return ptr.slot == 40; }),
+            "erasing a pointer should leave the rest of the posting list");
+    for (std::size_t i = 0; i < 400; i += 4) {
+        tree.erase("heavy", IndexPointer{addr, i});
+    }
+    require(!tree.find("heavy").has_value() && tree.find("k1").has_value(),
+            "the key should go away with its last pointer");
+    require(tree.pageCount() < pagesWithHeavy, "overflow pages should be freed with the posting list");
+
+    BPlusTree bulk(256, 8);
+    bulk.setAllowDuplicates(true);
+    bulk.bulkInsert(std::vector<std::pair<std::string, IndexPointer>>(entries.rbegin(), entries.rend()));
+    require(bulk.findAll("heavy").size() == 100, "bulk load should keep duplicate keys");
+    const std::string treePath = (tempRoot / "postings.tree").string();
+    bulk.saveToFile(treePath);
+    BPlusTree reloaded(256, 8);
+    reloaded.setAllowDuplicates(true);
+    reloaded.loadFromFile(treePath, 256, 8);
+    require(reloaded.findAll("heavy").size() == 100 && reloaded.find("k399").has_value(),
+            "posting lists should survive a snapshot round trip");
+    BPlusTree single(256, 8);
+    bool rejected = false;
+    try {
+        single.loadFromFile(treePath, 256, 8);
+    } catch (const std::exception &) {
+        rejected = true;
+    }
+    require(rejected, "a tree without duplicates should refuse a posting-list file");
+
+    const std::size_t blockSizeBytes = 512;
+    const std::size_t mainMemoryBytes = 2 * 1024 * 1024;
+    const std::size_t diskBytes = 8 * 1024 * 1024;
+    TableSchema orders("orders", {{"id", ColumnType::Integer, 8}, {"status", ColumnType::String, 8}});
+    const std::vector<std::string> statuses = {"new", "paid", "shipped"};
+    const std::string paid = "SELECT id FROM orders WHERE status = 'paid'";
+    {
+        WorkingDirGuard guard(tempRoot);
+        removeIfExists("storage");
+        DatabaseSystem db(blockSizeBytes, mainMemoryBytes, diskBytes);
+        db.registerTable(orders);
+        for (int i = 0; i < 900; ++i) {
+            db.insertRecord("orders", Record{std::to_string(i), statuses[i % 3]});
+        }
+        db.createIndex("idx_orders_status", "orders", "status");
+        require(planUses(planSql(db, paid), PhysicalOpType::kIndexScan),
+                "equality on a non-unique index should plan an index scan");
+        require(runSql(db, paid).size() == 300, "equality should return every row under the key");
+        require(runSql(db, "SELECT id FROM orders WHERE status >= 'paid'").size() == 600,
+                "range scans should return every row of each key");
+        db.flushAll();
+    }
+    {
+        WorkingDirGuard guard(tempRoot);
+        DatabaseSystem db(blockSizeBytes, mainMemoryBytes, diskBytes);
+        db.registerTable(orders);
+        require(db.searchIndexAll("idx_orders_status", "shipped").size() == 300,
+                "posting lists should load from index pages after restart");
+        require(runSql(db, paid).size() == 300, "equality scans should work after restart");
+
+        runSql(db, "DELETE FROM orders WHERE id = 1");
+        runSql(db, "UPDATE orders SET status = 'paid' WHERE id = 0");
+        require(runSql(db, paid).size() == 300, "delete and update should move single pointers");
+        require(runSql(db, "SELECT id FROM orders WHERE status = 'new'").size() == 299,
+                "the updated row should leave its old key");
+    }
+
+    removeIfExists(tempRoot);
+}
+
+void testParallelIndexBuild() {
+    const fs::path tempRoot = fs::current_path() / "tmp_dbms_tests" / "parallel_index_build";
+    removeIfExists(tempRoot);
+    WorkingDirGuard guard(tempRoot);
+    removeIfExists("storage");
+
+    const std::size_t blockSizeBytes = 512;
+    const std::size_t mainMemoryBytes = 2 * 1024 * 1024;
+    const std::size_t diskBytes = 8 * 1024 * 1024;
+    DatabaseSystem db(blockSizeBytes, mainMemoryBytes, diskBytes);
+
+    TableSchema events("events", {{"id", ColumnType::Integer, 8}, {"tag", ColumnType::String, 8}});
+    db.registerTable(events);
+    for (int i = 0; i < 4000; ++i) {
+        char tag[8];
+        std::snprintf(tag, sizeof(tag), "t%02d", (i * 13) % 37);
+        db.insertRecord("events", Record{std::to_string(i), tag});
+    }
+    require(db.getTable("events").blockCount() >= 4 * 32, "test needs enough blocks for four workers");
+
+    auto entriesOf = [&](const std::string &indexName) {
+        std::vector<std::tuple<std::string, std::size_t, std::size_t>> entries;
+        db.scanIndex(indexName, std::nullopt, true, [&](const std::string &key, const IndexPointer &ptr) {
+            entries.emplace_back(key, ptr.address.index, ptr.slot);
+            return true;
+        });
+        return entries;
+    };
+
+    db.setIndexBuildThreads(1);
+    db.createIndex("idx_events_tag_serial", "events", "tag");
+    db.setIndexBuildThreads(4);
+    require(db.indexBuildThreads() == 4, "build thread count should be configurable");
+    db.createIndex("idx_events_tag", "events", "tag");
+    db.createIndex("idx_events_id", "events", "id");
+
+    const auto serial = entriesOf("idx_events_tag_serial");
+    require(serial.size() == 4000, "serial build should index every row");
+    require(entriesOf("idx_events_tag") == serial,
+            "parallel build should match the serial build, duplicates in table order");
+    const auto ids = entriesOf("idx_events_id");
+    require(ids.size() == 4000 && std::is_sorted(ids.begin(), ids.end()),
+            "parallel build should merge worker runs into key order");
+    require(runSql(db, "SELECT id FROM events WHERE tag = 't05'").size() == 108,
+            "queries should use the parallel-built index");
+}
+
+void testCompositeIndex() {
+    const std::vector<IndexKeyColumn> pair = {{"a", 0, ColumnType::String, 4}, {"b", 1, ColumnType::Integer, kNumericIndexKeyBytes}};
+    require(encodeCompositeIndexKey({"ab", "9"}, pair) < encodeCompositeIndexKey({"ab", "10"}, pair) &&
+                encodeCompositeIndexKey({"ab", "99"}, pair) < encodeCompositeIndexKey({"abc", "-5"}, pair),
+            "composite keys should compare column by column");
+    require(encodeCompositeIndexKey({"ab", "9"}, pair).rfind(encodeCompositeIndexKey({"ab"}, pair), 0) == 0,
+            "a leading value should encode to a prefix of the full key");
+
+    const fs::path tempRoot = fs::current_path() / "tmp_dbms_tests" / "composite_index";
+    removeIfExists(tempRoot);
+    fs::create_directories(tempRoot);
+
+    struct Event {
+        int tenant;
+        int created;
+        std::string note;
+    };
+    std::vector<Event> events;
+    for (int i = 0; i < 1000; ++i) {
+        events.push_back({i % 10, (i * 7) % 1000, "n" + std::to_string(i % 7)});
+    }
+    auto expected = [&](const std::function<bool(const Event &)> &match) {
+        return static_cast<std::size_t>(std::count_if(events.begin(), events.end(), match));
+    };
+    auto indexScanOf = [](const std::shared_ptr<PhysicalPlanNode> &plan) {
+        std::function<std::shared_ptr<PhysicalPlanNode>(const std::shared_ptr<PhysicalPlanNode> &)> find =
+            [&](const std::shared_ptr<PhysicalPlanNode> &node) -> std::shared_ptr<PhysicalPlanNode> {
+            if (!node || node->opType == PhysicalOpType::kIndexScan) {
+                return node;
+            }
+            for (const auto &child : node->children) {
+                if (auto scan = find(child)) {
+                    return scan;
+                }
+            }
+            return nullptr;
+        };
+        return find(plan);
+    };
+
+    const std::size_t blockSizeBytes = 512;
+    const std::size_t mainMemoryBytes = 2 * 1024 * 1024;
+    const std::size_t diskBytes = 8 * 1024 * 1024;
+    TableSchema schema("events",
+                       {{"tenant", ColumnType::Integer, 8},
+                        {"created", ColumnType::Integer, 8},
+                        {"note", ColumnType::String, 8}});
+    const std::string window =
+        "SELECT created FROM events WHERE tenant = 3 AND created BETWEEN 100 AND 299";
+    auto checkQueries = [&](DatabaseSystem &db) {
+        auto scan = indexScanOf(planSql(db, window));
+        require(scan && scan->parameters["index"] == "idx_events_tenant_created" &&
+                    scan->parameters["prefix_size"] == "1",
+                "equality plus range on leading columns should scan the composite index");
+        auto rows = runSql(db, window);
+        std::vector<int> created;
+        for (const auto &row : rows) {
+            created.push_back(std::stoi(row.getValue("created")));
+        }
+        require(created.size() == expected([](const Event &e) {
+                    return e.tenant == 3 && e.created >= 100 && e.created <= 299;
+                }),
+                "prefix range scan should return every row in the window");
+        require(std::is_sorted(created.begin(), created.end()), "prefix range scan should follow key order");
+
+        require(runSql(db, "SELECT note FROM events WHERE created = 21 AND tenant = 3").size() ==
+                    expected([](const Event &e) { return e.tenant == 3 && e.created == 21; }),
+                "full-key equality should find the row");
+        require(runSql(db, "SELECT note FROM events WHERE tenant = 3 AND created > 990").size() ==
+                    expected([](const Event &e) { return e.tenant == 3 && e.created > 990; }),
+                "open upper bound should stop at the end of the prefix");
+        const std::string leading = "SELECT note FROM events WHERE tenant = 7";
+        require(planUses(planSql(db, leading), PhysicalOpType::kIndexScan),
+                "equality on the leading column should use the composite index");
+        require(runSql(db, leading).size() == expected([](const Event &e) { return e.tenant == 7; }),
+                "leading-column equality should cover every later column");
+
+        require(runSql(db, "SELECT note FROM events WHERE note > 'n3'").size() ==
+                    expected([](const Event &e) { return e.note > "n3"; }),
+                "exclusive lower bound on a padded column should skip the whole value");
+        require(runSql(db, "SELECT note FROM events WHERE note <= 'n3'").size() ==
+                    expected([](const Event &e) { return e.note <= "n3"; }),
+                "inclusive upper bound on a padded column should take the whole value");
+        require(runSql(db, "SELECT note FROM events WHERE note = 'n2' AND tenant < 5").size() ==
+                    expected([](const Event &e) { return e.note == "n2" && e.tenant < 5; }),
+                "string prefix with a numeric range should match a filtered scan");
+    };
+    {
+        WorkingDirGuard guard(tempRoot);
+        removeIfExists("storage");
+        DatabaseSystem db(blockSizeBytes, mainMemoryBytes, diskBytes);
+        db.registerTable(schema);
+        for (const auto &e : events) {
+            db.insertRecord("events", Record{std::to_string(e.tenant), std::to_string(e.created), e.note});
+        }
+        db.createIndex("idx_events_tenant_created", "events", std::vector<std::string>{"tenant", "created"});
+        db.createIndex("idx_events_note_tenant", "events", std::vector<std::string>{"note", "tenant"});
+        require(db.getIndexDefinition("idx_events_tenant_created").keyLength == 2 * kNumericIndexKeyBytes,
+                "a composite key should span every column");
+        checkQueries(db);
+        db.flushAll();
+    }
+    {
+        WorkingDirGuard guard(tempRoot);
+        DatabaseSystem db(blockSizeBytes, mainMemoryBytes, diskBytes);
+        db.registerTable(schema);
+        require(db.getIndexDefinition("idx_events_note_tenant").columnList() == "note, tenant",
+                "composite columns should be read back from the catalog");
+        checkQueries(db);
+    }
+
+    removeIfExists(tempRoot);
+}
+
+void testCoveringIndexScan() {
+    const fs::path tempRoot = fs::current_path() / "tmp_dbms_tests" / "covering_index";
+    removeIfExists(tempRoot);
+
+    TableSchema users("users",
+                      {{"id", ColumnType::Integer, 8},
+                       {"email", ColumnType::String, 16},
+                       {"name", ColumnType::String, 8}});
+    const std::size_t blockSizeBytes = 512;
+    const std::size_t mainMemoryBytes = 2 * 1024 * 1024;
+    const std::size_t diskBytes = 8 * 1024 * 1024;
+
+    auto indexOnly = [](const std::shared_ptr<PhysicalPlanNode> &plan) {
+        auto scan = findPlanNode(plan, PhysicalOpType::kIndexScan);
+        return scan && scan->parameters["index_only"] == "true";
+    };
+    const std::string ranged = "SELECT id, email FROM users WHERE id BETWEEN 100 AND 199";
+
+    {
+        WorkingDirGuard guard(tempRoot);
+        removeIfExists("storage");
+        DatabaseSystem db(blockSizeBytes, mainMemoryBytes, diskBytes);
+        db.registerTable(users);
+        for (int i = 0; i < 500; ++i) {
+            const int id = (i * 7) % 500;
+            db.insertRecord("users", Record{std::to_string(id), "u" + std::to_string(id) + "@mail.io",
+                                            "n" + std::to_string(id % 10)});
+        }
+        db.createIndex("idx_users_id", "users", std::vector<std::string>{"id"},
+                       std::vector<std::string>{"email"});
+        require(db.getIndexDefinition("idx_users_id").includeList() == "email",
+                "index definition should list the included column");
+
+        require(indexOnly(planSql(db, ranged)), "a range reading key and included columns should skip the table");
+        auto rows = runSql(db, ranged);
+        require(rows.size() == 100, "index-only range scan should return every key in range");
+        int expected = 100;
+        for (const auto &row : rows) {
+            require(row.getValue("id") == std::to_string(expected) &&
+                        row.getValue("email") == "u" + std::to_string(expected) + "@mail.io",
+                    "index-only rows should carry their stored values in key order");
+            ++expected;
+        }
+
+        const std::string point = "SELECT email FROM users WHERE id = 42";
+        require(indexOnly(planSql(db, point)), "an equality lookup on covered columns should skip the table");
+        auto single = runSql(db, point);
+        require(single.size() == 1 && single.getTuple(0).getValue("email") == "u42@mail.io",
+                "index-only lookup should return its included value");
+
+        const std::string wider = "SELECT id, name FROM users WHERE id BETWEEN 100 AND 199";
+        require(planUses(planSql(db, wider), PhysicalOpType::kIndexScan) && !indexOnly(planSql(db, wider)),
+                "columns outside the index should still be read from the table");
+        require(runSql(db, wider).size() == 100, "table-backed range scan should be unchanged");
+        require(!indexOnly(planSql(db, "SELECT id FROM users WHERE id < 50 AND name = 'n3'")),
+                "a residual predicate on an uncovered column should read the table");
+
+        runSql(db, "UPDATE users SET email = 'x42@mail.io' WHERE id = 42");
+        runSql(db, "DELETE FROM users WHERE id = 150");
+        single = runSql(db, point);
+        require(single.size() == 1 && single.getTuple(0).getValue("email") == "x42@mail.io",
+                "updating an included column should refresh the index entry");
+        require(runSql(db, ranged).size() == 99, "deleted rows should leave the index");
+        db.flushAll();
+    }
+
+    {
+        WorkingDirGuard guard(tempRoot);
+        DatabaseSystem db(blockSizeBytes, mainMemoryBytes, diskBytes);
+        db.registerTable(users);
+        require(db.getIndexDefinition("idx_users_id").covering(), "included columns should survive a restart");
+        require(indexOnly(planSql(db, ranged)), "restored covering index should still skip the table");
+        require(runSql(db, ranged).size() == 99, "restored covering index should keep its entries");
+    }
+
+    removeIfExists(tempRoot);
+}
+
+void testHashIndex() {
+    const fs::path tempRoot = fs::current_path() / "tmp_dbms_tests" / "hash_index";
+    removeIfExists(tempRoot);
+
+    TableSchema sessions("sessions",
+                         {{"token", ColumnType::String, 16},
+                          {"owner", ColumnType::Integer, 8}});
+    const std::size_t blockSizeBytes = 512;
+    const std::size_t mainMemoryBytes = 2 * 1024 * 1024;
+    const std::size_t diskBytes = 8 * 1024 * 1024;
+
+    auto probedIndex = [](const std::shared_ptr<PhysicalPlanNode> &plan) {
+        auto scan = findPlanNode(plan, PhysicalOpType::kIndexScan);
+        return scan ? scan->parameters["index"] : std::string();
+    };
+
+    {
+        WorkingDirGuard guard(tempRoot);
+        removeIfExists("storage");
+        DatabaseSystem db(blockSizeBytes, mainMemoryBytes, diskBytes);
+        db.registerTable(sessions);
+        for (int i = 0; i < 600; ++i) {
+            db.insertRecord("sessions", Record{"tok" + std::to_string(i), std::to_string(i % 40)});
+        }
+        db.createIndex("idx_sessions_token", "sessions", std::vector<std::string>{"token"}, {},
+                       IndexMethod::Hash);
+        db.createIndex("idx_sessions_owner_tree", "sessions", "owner");
+        db.createIndex("idx_sessions_owner", "sessions", std::vector<std::string>{"owner"}, {},
+                       IndexMethod::Hash);
+        require(db.getIndexDefinition("idx_sessions_token").hashed(), "index should record its hash method");
+
+        bool rejected = false;
+        try {
+            db.createIndex("idx_bad", "sessions", std::vector<std::string>{"token", "owner"}, {},
+                           IndexMethod::Hash);
+        } catch (const std::runtime_error &) {
+            rejected = true;
+        }
+        require(rejected, "a composite hash index should be rejected");
+
+        const std::string point = "SELECT owner FROM sessions WHERE token = 'tok321'";
+        require(probedIndex(planSql(db, point)) == "idx_sessions_token",
+                "equality on a hashed column should probe the hash index");
+        auto rows = runSql(db, point);
+        require(rows.size() == 1 && rows.getTuple(0).getValue("owner") == "1",
+                "hash lookup should return the matching row");
+        require(runSql(db, "SELECT owner FROM sessions WHERE token = 'missing'").size() == 0,
+                "hash lookup of an absent key should return nothing");
+
+        require(probedIndex(planSql(db, "SELECT token FROM sessions WHERE owner = 7")) == "idx_sessions_owner",
+                "the hash index should win over a B+ tree on the same column for equality");
+        require(runSql(db, "SELECT token FROM sessions WHERE owner = 7").size() == 15,
+                "a non-unique hash index should return every duplicate");
+        const std::string ranged = "SELECT token FROM sessions WHERE owner < 2";
+        require(probedIndex(planSql(db, ranged)) == "idx_sessions_owner_tree",
+                "ranges should stay on the ordered index");
+        require(runSql(db, ranged).size() == 30, "range results should be unchanged");
+        require(!planUses(planSql(db, "SELECT owner FROM sessions WHERE token > 'tok9'"),
+                          PhysicalOpType::kIndexScan),
+                "a range over a hash-only column should scan the table");
+
+        runSql(db, "UPDATE sessions SET token = 'upd5' WHERE token = 'tok5'");
+        runSql(db, "DELETE FROM sessions WHERE token = 'tok6'");
+        require(runSql(db, "SELECT owner FROM sessions WHERE token = 'tok5'").size() == 0 &&
+                    runSql(db, "SELECT owner FROM sessions WHERE token = 'upd5'").size() == 1,
+                "updates should move the hash entry");
+        require(runSql(db, "SELECT owner FROM sessions WHERE token = 'tok6'").size() == 0,
+                "deleted rows should leave the hash index");
+        db.flushAll();
+    }
+
+    {
+        WorkingDirGuard guard(tempRoot);
+        DatabaseSystem db(blockSizeBytes, mainMemoryBytes, diskBytes);
+        db.registerTable(sessions);
+        require(db.getIndexDefinition("idx_sessions_token").hashed(), "hash method should survive a restart");
+        const std::string last = "SELECT owner FROM sessions WHERE token = 'tok599'";
+        require(probedIndex(planSql(db, last)) == "idx_sessions_token",
+                "restored hash index should still serve equality");
+        require(runSql(db, last).size() == 1 &&
+                    runSql(db, "SELECT owner FROM sessions WHERE token = 'tok6'").size() == 0,
+                "restored hash index should keep its entries");
+        require(runSql(db, "SELECT token FROM sessions WHERE owner = 7").size() == 15,
+                "restored hash index should keep its duplicates");
+    }
+
+    removeIfExists(tempRoot);
+}
+
+void testBitmapIndex() {
+    const fs::path tempRoot = fs::current_path() / "tmp_dbms_tests" / "bitmap_index";
+    removeIfExists(tempRoot);
+
+    TableSchema tickets("tickets",
+                        {{"id", ColumnType::Integer, 8},
+                         {"status", ColumnType::String, 8},
+                         {"region", ColumnType::String, 8}});
+    const std::size_t blockSizeBytes = 512;
+    const std::size_t mainMemoryBytes = 2 * 1024 * 1024;
+    const std::size_t diskBytes = 8 * 1024 * 1024;
+    const std::vector<std::string> statuses{"open", "done", "held"};
+
+    auto countBoth = [](DatabaseSystem &db, const std::string &condition) {
+        const std::string sql = "SELECT id FROM tickets WHERE " + condition;
+        require(planUses(planSql(db, sql), PhysicalOpType::kBitmapScan),
+                "bitmap-indexed predicate should plan a bitmap scan: " + condition);
+        return runSql(db, sql).size();
+    };
+
+    {
+        WorkingDirGuard guard(tempRoot);
+        removeIfExists("storage");
+        DatabaseSystem db(blockSizeBytes, mainMemoryBytes, diskBytes);
+        db.registerTable(tickets);
+        for (int i = 0; i < 600; ++i) {
+            db.insertRecord("tickets", Record{std::to_string(i), statuses[i % 3], "r" + std::to_string(i % 4)});
+        }
+        for (int i = 600; i < 605; ++i) {
+            db.insertRecord("tickets", Record{std::to_string(i), "rare", "r9"});
+        }
+        db.createIndex("idx_tickets_status", "tickets", std::vector<std::string>{"status"}, {},
+                       IndexMethod::Bitmap);
+        db.createIndex("idx_tickets_region", "tickets", std::vector<std::string>{"region"}, {},
+                       IndexMethod::Bitmap);
+        require(db.getIndexDefinition("idx_tickets_status").bitmapped(), "index should record its bitmap method");
+        require(db.searchIndexBitmap("idx_tickets_status", "held").cardinality() == 200,
+                "bitmap should hold one bit per matching row");
+
+        bool rejected = false;
+        try {
+            db.createIndex("idx_bad", "tickets", std::vector<std::string>{"status", "region"}, {},
+                           IndexMethod::Bitmap);
+        } catch (const std::runtime_error &) {
+            rejected = true;
+        }
+        require(rejected, "a composite bitmap index should be rejected");
+
+        require(countBoth(db, "status = 'held'") == 200, "single bitmap lookup should match every row");
+        require(countBoth(db, "status = 'open' AND region = 'r1'") == 50, "AND should intersect the bitmaps");
+        require(countBoth(db, "status = 'open' OR status = 'held'") == 400, "OR should unite the bitmaps");
+        require(countBoth(db, "(status = 'open' OR status = 'held') AND region = 'r2'") == 100,
+                "AND of ORs should combine both operations");
+        require(countBoth(db, "status = 'done' AND id < 100") == 33,
+                "conjuncts without a bitmap should be rechecked by the filter");
+        require(!planUses(planSql(db, "SELECT id FROM tickets WHERE status = 'open' OR id = 5"),
+                          PhysicalOpType::kBitmapScan),
+                "an OR reaching an unindexed column cannot use bitmaps");
+
+        BitmapScanOperator rare(db, "tickets", BitmapPredicate{{BitmapTerm{"idx_tickets_region", "r9"}}});
+        rare.init();
+        std::size_t rareRows = 0;
+        while (rare.next()) {
+            ++rareRows;
+        }
+        require(rareRows == 5 && rare.selectedBlocks() < db.getTable("tickets").blocks().size() / 4,
+                "a rare value should fetch only the blocks that hold it");
+        rare.close();
+
+        runSql(db, "UPDATE tickets SET status = 'done' WHERE id = 0");
+        runSql(db, "DELETE FROM tickets WHERE id = 3");
+        require(countBoth(db, "status = 'open'") == 198 && countBoth(db, "status = 'done'") == 201,
+                "updates and deletes should move bits between values");
+        db.flushAll();
+    }
+
+    const fs::path segment = tempRoot / "storage" / "idx.idx_tickets_status";
+    require(fs::is_directory(segment) && !fs::is_empty(segment),
+            "bitmap containers should be stored as blocks of their own segment");
+
+    {
+        WorkingDirGuard guard(tempRoot);
+        DatabaseSystem db(blockSizeBytes, mainMemoryBytes, diskBytes);
+        db.registerTable(tickets);
+        require(db.getIndexDefinition("idx_tickets_region").bitmapped(), "bitmap method should survive a restart");
+        require(countBoth(db, "status = 'held' AND region = 'r1'") == 50,
+                "restored bitmaps should keep their rows");
+        require(countBoth(db, "region = 'r9'") == 5, "restored bitmaps should keep rare values");
+    }
+
+    removeIfExists(tempRoot);
+}
+
+void testIndexNestedLoopJoin() {
+    const fs::path tempRoot = fs::current_path() / "tmp_dbms_tests" / "index_nested_loop_join";
+    removeIfExists(tempRoot);
+    WorkingDirGuard guard(tempRoot);
+    removeIfExists("storage");
+
+    const std::size_t blockSizeBytes = 512;
+    const std::size_t mainMemoryBytes = 2 * 1024 * 1024;
+    const std::size_t diskBytes = 8 * 1024 * 1024;
+    DatabaseSystem db(blockSizeBytes, mainMemoryBytes, diskBytes);
+
+    TableSchema orders("orders", {{"id", ColumnType::Integer, 8}, {"customer", ColumnType::String, 8}});
+    TableSchema items("order_items",
+                      {{"order_id", ColumnType::Integer, 8},
+                       {"sku", ColumnType::String, 8},
+                       {"qty", ColumnType::Integer, 8}});
+    db.registerTable(orders);
+    db.registerTable(items);
+    for (int i = 0; i <= 300; ++i) {
+        db.insertRecord("orders", Record{std::to_string(i), "cust" + std::to_string(i % 7)});
+    }
+    for (int i = 0; i < 1200; ++i) {
+        char sku[8];
+        std::snprintf(sku, sizeof(sku), "s%04d", i);
+        db.insertRecord("order_items", Record{std::to_string(i % 300), sku, std::to_string(i / 300)});
+    }
+    db.createIndex("idx_orders_id", "orders", "id");
+    db.createIndex("idx_items_order", "order_items", "order_id");
+
+    const std::string single =
+        "SELECT order_items.sku FROM orders JOIN order_items ON orders.id = order_items.order_id "
+        "WHERE orders.id = 42";
+    auto plan = planSql(db, single);
+    require(planUses(plan, PhysicalOpType::kIndexNestedLoopJoin),
+            "a single filtered outer row should probe the inner index");
+    require(!planUses(plan, PhysicalOpType::kHashJoin), "the inner table should not be hashed");
+    std::vector<std::string> skus;
+    for (const auto &row : runSql(db, single)) {
+        skus.push_back(row.getValue("sku"));
+    }
+    std::sort(skus.begin(), skus.end());
+    require((skus == std::vector<std::string>{"s0042", "s0342", "s0642", "s0942"}),
+            "index join should return every inner row under the outer key");
+
+    const std::string aliased =
+        "SELECT i.sku FROM orders o JOIN order_items i ON i.order_id = o.id "
+        "WHERE o.id = 7 AND i.qty > 1";
+    require(planUses(planSql(db, aliased), PhysicalOpType::kIndexNestedLoopJoin),
+            "aliases and a reversed condition should still plan an index join");
+    require(runSql(db, aliased).size() == 2, "conditions on the inner side should filter the joined rows");
+
+    const std::string left =
+        "SELECT orders.id, order_items.sku FROM orders LEFT JOIN order_items "
+        "ON orders.id = order_items.order_id WHERE orders.id = 300";
+    require(planUses(planSql(db, left), PhysicalOpType::kIndexNestedLoopJoin),
+            "left joins with a small outer side should probe the index");
+    auto unmatched = runSql(db, left);
+    require(unmatched.size() == 1, "left index join should keep outer rows without matches");
+    for (const auto &row : unmatched) {
+        require(row.getValue("sku") == "NULL", "missing inner rows should be NULL");
+    }
+
+    const std::string full =
+        "SELECT order_items.sku FROM orders JOIN order_items ON orders.id = order_items.order_id";
+    plan = planSql(db, full);
+    require(planUses(plan, PhysicalOpType::kHashJoin) &&
+                !planUses(plan, PhysicalOpType::kIndexNestedLoopJoin),
+            "an unfiltered outer table should keep the hash join");
+    require(runSql(db, full).size() == 1200, "hash join should match every item");
+}
+
 void testLeftAndRightJoinSupport() {
     const fs::path tempRoot = fs::current_path() / "tmp_dbms_tests" / "sql_join_types";
     removeIfExists(tempRoot);
@@ -977,6 +2451,57 @@ void testSqlDeleteExecution() {
     require(empty.size() == 0, "delete without where should clear all rows");
 }
 
+void testSqlKeyedUpdateAndDelete() {
+    const fs::path tempRoot = fs::current_path() / "tmp_dbms_tests" / "sql_keyed_writes";
+    removeIfExists(tempRoot);
+    WorkingDirGuard guard(tempRoot);
+    removeIfExists("storage");
+
+    const std::size_t blockSizeBytes = 512;
+    const std::size_t mainMemoryBytes = 2 * 1024 * 1024;
+    const std::size_t diskBytes = 8 * 1024 * 1024;
+    DatabaseSystem db(blockSizeBytes, mainMemoryBytes, diskBytes);
+
+    TableSchema accounts("accounts",
+                         {{"id", ColumnType::Integer, 8},
+                          {"owner", ColumnType::String, 8},
+                          {"balance", ColumnType::Integer, 8}});
+    db.registerTable(accounts);
+    // Ids keep three digits through the updates below, so rows never outgrow their slots.
+    for (int i = 100; i < 600; ++i) {
+        db.insertRecord("accounts", Record{std::to_string(i), "o" + std::to_string(i % 10), std::to_string(i)});
+    }
+    db.createIndex("idx_accounts_id", "accounts", "id");
+    db.createIndex("idx_accounts_owner", "accounts", "owner");
+
+    QueryExecutor executor(db);
+    const auto keyed = executor.locateRows("accounts", "id = 142");
+    require(keyed.size() == 1 && keyed.front().record.values[0] == "142",
+            "an equality on an indexed key should locate exactly its row");
+    const auto stored = db.readRecord(keyed.front().location.address, keyed.front().location.slot);
+    require(stored && stored->values[2] == "142", "located rows should point at their stored slot");
+
+    runSql(db, "UPDATE accounts SET balance = balance + 5 WHERE id = 142");
+    auto updated = runSql(db, "SELECT balance FROM accounts WHERE id = 142");
+    require(updated.size() == 1 && updated.getTuple(0).getValue("balance") == "147",
+            "keyed update should change its row");
+
+    // Moving keys past the scanned range must not revisit them.
+    runSql(db, "UPDATE accounts SET id = id + 500 WHERE id < 120");
+    require(runSql(db, "SELECT id FROM accounts WHERE id < 120").size() == 0,
+            "range update should move every key out of the range");
+    auto moved = runSql(db, "SELECT id FROM accounts WHERE id >= 600");
+    require(moved.size() == 20, "each row in the range should be updated once");
+    for (const auto &row : moved) {
+        require(std::stoi(row.getValue("id")) < 620, "no row should be updated twice");
+    }
+
+    runSql(db, "DELETE FROM accounts WHERE owner = 'o3' AND balance >= 350");
+    require(runSql(db, "SELECT id FROM accounts WHERE owner = 'o3'").size() == 25,
+            "delete through a non-unique index should apply the residual predicate");
+    require(runSql(db, "SELECT id FROM accounts").size() == 475, "other rows should survive the delete");
+}
+
 void testSortOperatorOrdersResults() {
     const fs::path tempRoot = fs::current_path() / "tmp_dbms_tests" / "sort_operator";
     removeIfExists(tempRoot);
@@ -1094,7 +2619,14 @@ int main() {
     TestRunner runner;
     runner.run("VariableLengthPage insert/update/delete/vacuum", testVariableLengthPage);
     runner.run("BufferPool LRU eviction and flush", testBufferPoolLRU);
+    runner.run("Page guards re-fetch evicted blocks", testPageGuardsRefetchEvictedBlocks);
     runner.run("BPlusTree index CRUD", testBPlusTreeIndexOps);
+    runner.run("Node key slots search like sorted strings", testNodeKeysSearch);
+    runner.run("BPlusTree bottom-up bulk load", testBPlusTreeBulkLoad);
+    runner.run("BPlusTree pages store shared key prefixes once", testBPlusTreePrefixCompression);
+    runner.run("BPlusTree serves readers and writers concurrently", testConcurrentBPlusTree);
+    runner.run("Index changes persist through delta log", testIndexDeltaLogPersistence);
+    runner.run("Index pages go through the buffer pool", testIndexPagesThroughBufferPool);
     runner.run("Index scan and hash join pipeline", testIndexScanAndJoinPipeline);
     runner.run("Persistence across restart (data + index)", testPersistenceAcrossRestart);
     runner.run("Index rebuild when data file is missing", testIndexRebuildWithoutDataFile);
@@ -1103,16 +2635,31 @@ int main() {
     runner.run("Access plan cache evicts when over capacity", testPlanCacheEvictionUnderCapacity);
     runner.run("Transaction rollback restores state", testTransactionRollback);
     runner.run("Transaction commit persists changes", testTransactionCommit);
+    runner.run("Commit checkpoints the WAL and redo is idempotent", testCheckpointTruncatesWalAndRedoIsIdempotent);
     runner.run("Buffer eviction flushes dirty pages", testBufferEvictionFlushesDirtyPage);
+    runner.run("DML and queries run in a two-frame buffer pool", testTinyBufferPoolWorkload);
+    runner.run("Table scans read ahead on a background thread", testTableScanReadAhead);
+    runner.run("Large scans read through a private ring", testBulkScanRing);
     runner.run("Disk full prevents further inserts", testDiskFullStopsInsertion);
     runner.run("Corrupted data block is detected", testCorruptedDataFileDetection);
     runner.run("Corrupted index file triggers rebuild", testCorruptedIndexFileRebuild);
+    runner.run("Stored indexes open on first use", testLazyIndexOpen);
     runner.run("SQL DISTINCT with ORDER BY", testSqlDistinctAndOrderBy);
     runner.run("SQL LIMIT/OFFSET clauses", testSqlLimitOffset);
+    runner.run("SQL range and prefix predicates use index scans", testSqlIndexRangeScan);
+    runner.run("Numeric index keys sort in value order", testNumericIndexKeyOrder);
+    runner.run("Non-unique index keeps posting lists", testNonUniqueIndexPostings);
+    runner.run("Parallel index build matches a serial build", testParallelIndexBuild);
+    runner.run("Composite index serves prefix equality and ranges", testCompositeIndex);
+    runner.run("Covering index answers queries without the table", testCoveringIndexScan);
+    runner.run("Hash index serves equality lookups", testHashIndex);
+    runner.run("Bitmap index combines AND/OR predicates", testBitmapIndex);
+    runner.run("Index nested loop join probes the inner index", testIndexNestedLoopJoin);
     runner.run("LEFT/RIGHT join execution", testLeftAndRightJoinSupport);
     runner.run("Subquery in FROM clause", testSubqueryInFrom);
     runner.run("SQL UPDATE applies SET with WHERE", testSqlUpdateExecution);
     runner.run("SQL DELETE removes matching rows", testSqlDeleteExecution);
+    runner.run("Keyed UPDATE and DELETE go through indexes", testSqlKeyedUpdateAndDelete);
     runner.run("Sort operator orders tuples", testSortOperatorOrdersResults);
     runner.run("Aggregate stddev/variance", testAggregateStddevVariance);
     runner.run("Aggregate operator group by + having", testAggregateGroupByHaving);